@@ -43,6 +43,10 @@ void            dbus_connection_setup_with_g_main (DBusConnection  *connection,
                                                    GMainContext    *context);
 void            dbus_server_setup_with_g_main     (DBusServer      *server,
                                                    GMainContext    *context);
+void            dbus_g_set_dispatch_budget        (guint            max_messages,
+                                                   guint            max_usec);
+void            dbus_g_get_dispatch_budget        (guint           *max_messages,
+                                                   guint           *max_usec);
 
 void dbus_g_proxy_send (DBusGProxy    *proxy,
                         DBusMessage   *message,
@@ -231,6 +231,10 @@ typedef void (* DBusGProxyCallNotify) (DBusGProxy       *proxy,
 				       DBusGProxyCall   *call_id,
 				       void             *user_data);
 
+typedef void (* DBusGProxyNameOwnerNotify) (DBusGProxy  *proxy,
+                                            gboolean     has_owner,
+                                            gpointer     user_data);
+
 GType             dbus_g_proxy_get_type              (void) G_GNUC_CONST;
 DBusGProxy*       dbus_g_proxy_new_for_name          (DBusGConnection   *connection,
                                                       const char        *name,
@@ -298,10 +302,24 @@ DBusGProxyCall * dbus_g_proxy_begin_call_with_timeout (DBusGProxy        *proxy,
                                                        int timeout,
                                                        GType             first_arg_type,
 				                       ...);
+DBusGProxyCall * dbus_g_proxy_begin_call_value_array (DBusGProxy        *proxy,
+                                                      const char        *method,
+                                                      DBusGProxyCallNotify notify,
+                                                      gpointer           user_data,
+                                                      GDestroyNotify     destroy,
+                                                      int                timeout,
+                                                      GValueArray       *args);
+
+void              dbus_g_proxy_get_signal_cache_stats (guint             *hits,
+                                                       guint             *misses);
 
 void              dbus_g_proxy_set_default_timeout   (DBusGProxy        *proxy,
                                                       int                timeout);
 
+void              dbus_g_proxy_set_name_owner_notify (DBusGProxy        *proxy,
+                                                      DBusGProxyNameOwnerNotify notify,
+                                                      gpointer           user_data);
+
 gboolean          dbus_g_proxy_end_call              (DBusGProxy        *proxy,
                                                       DBusGProxyCall    *call,
                                                       GError           **error,
@@ -32,6 +32,7 @@
 #include "dbus-gvalue-utils.h"
 #include "dbus-gsignature.h"
 #include <string.h>
+#include <time.h>
 
 //#include <libintl.h>
 #define _(x) dgettext (GETTEXT_PACKAGE, x)
@@ -88,23 +89,94 @@ message_queue_check (GSource *source)
   return FALSE;
 }
 
+/* Dispatch budget per main loop iteration, see
+ * dbus_g_set_dispatch_budget()
+ */
+static volatile gint dispatch_max_messages = 32;
+static volatile gint dispatch_max_usec = 5000;
+
+/* Monotonic, so a wall clock step can't end a batch early or never */
+static gint64
+monotonic_usec (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (gint64) ts.tv_sec * G_USEC_PER_SEC + ts.tv_nsec / 1000;
+}
+
 static gboolean
 message_queue_dispatch (GSource     *source,
                         GSourceFunc  callback,
                         gpointer     user_data)
 {
   DBusConnection *connection = ((DBusGMessageQueue *)source)->connection;
+  gint max_messages;
+  gint max_usec;
+  gint64 start = 0;
+  gint n;
+
+  max_messages = g_atomic_int_get (&dispatch_max_messages);
+  max_usec = g_atomic_int_get (&dispatch_max_usec);
+  if (max_usec > 0)
+    start = monotonic_usec ();
 
   dbus_connection_ref (connection);
 
-  /* Only dispatch once - we don't want to starve other GSource */
-  dbus_connection_dispatch (connection);
+  /* Drain a burst of queued messages in one wakeup, but stop at the
+   * budget so we don't starve other GSource; whatever is left keeps
+   * the source ready for the next iteration.
+   */
+  for (n = 1; dbus_connection_dispatch (connection) == DBUS_DISPATCH_DATA_REMAINS; n++)
+    {
+      if (n >= max_messages)
+        break;
+      if (max_usec > 0 && monotonic_usec () - start >= max_usec)
+        break;
+    }
   
   dbus_connection_unref (connection);
 
   return TRUE;
 }
 
+/**
+ * dbus_g_set_dispatch_budget:
+ * @max_messages: most messages dispatched per main loop iteration, at least 1
+ * @max_usec: time after which dispatching stops for this iteration,
+ *   or 0 for no time limit
+ *
+ * Sets how many queued messages a connection set up with
+ * dbus_connection_setup_with_g_main() dispatches per main loop
+ * iteration. The budget applies to all connections.
+ * A budget of one message gives the historical behaviour.
+ */
+void
+dbus_g_set_dispatch_budget (guint max_messages,
+                            guint max_usec)
+{
+  g_atomic_int_set (&dispatch_max_messages, MAX (max_messages, 1));
+  g_atomic_int_set (&dispatch_max_usec, max_usec);
+}
+
+/**
+ * dbus_g_get_dispatch_budget:
+ * @max_messages: return location for the message budget, or #NULL
+ * @max_usec: return location for the time budget, or #NULL
+ *
+ * Gets the budget set with dbus_g_set_dispatch_budget(), so one
+ * of its limits can be changed while keeping the other.
+ */
+void
+dbus_g_get_dispatch_budget (guint *max_messages,
+                            guint *max_usec)
+{
+  if (max_messages)
+    *max_messages = g_atomic_int_get (&dispatch_max_messages);
+  if (max_usec)
+    *max_usec = g_atomic_int_get (&dispatch_max_usec);
+}
+
 typedef struct
 {
   GMainContext *context;      /**< the main context */
@@ -48,7 +48,8 @@ typedef struct
 static GStaticRWLock globals_lock = G_STATIC_RW_LOCK_INIT;
 /* See comments in check_property_access */
 static gboolean disable_legacy_property_access = FALSE;
-static GHashTable *marshal_table = NULL;
+/* Immutable once published, see dbus_g_object_register_marshaller_array */
+static GHashTable * volatile marshal_table = NULL;
 static GData *error_metadata = NULL;
 
 static char*
@@ -2699,6 +2700,9 @@ funcsig_free (DBusGFuncSignature *sig)
   g_free (sig);
 }
 
+/* Signatures up to this many parameters are looked up without allocating */
+#define LOOKUP_MAX_STACK_PARAMS 16
+
 GClosureMarshal
 _dbus_gobject_lookup_marshaller (GType        rettype,
 				 guint        n_params,
@@ -2706,28 +2710,31 @@ _dbus_gobject_lookup_marshaller (GType        rettype,
 {
   GClosureMarshal ret;
   DBusGFuncSignature sig;
+  GType stack_params[LOOKUP_MAX_STACK_PARAMS];
   GType *params;
+  GHashTable *table;
   guint i;
 
   /* Convert to fundamental types */
   rettype = G_TYPE_FUNDAMENTAL (rettype);
-  params = g_new (GType, n_params);
+  if (n_params <= LOOKUP_MAX_STACK_PARAMS)
+    params = stack_params;
+  else
+    params = g_new (GType, n_params);
   for (i = 0; i < n_params; i++)
     params[i] = G_TYPE_FUNDAMENTAL (param_types[i]);
 
   sig.rettype = rettype;
   sig.n_params = n_params;
   sig.params = params;
-  
-  g_static_rw_lock_reader_lock (&globals_lock);
 
-  if (marshal_table)
-    ret = g_hash_table_lookup (marshal_table, &sig);
+  /* No lock: a published table is never modified or freed */
+  table = g_atomic_pointer_get (&marshal_table);
+  if (table)
+    ret = g_hash_table_lookup (table, &sig);
   else
     ret = NULL;
 
-  g_static_rw_lock_reader_unlock (&globals_lock);
-
   if (ret == NULL)
     {
       if (rettype == G_TYPE_NONE)
@@ -2771,7 +2778,8 @@ _dbus_gobject_lookup_marshaller (GType        rettype,
 	}
     }
 
-  g_free (params);
+  if (params != stack_params)
+    g_free (params);
   return ret;
 }
 
@@ -2827,15 +2835,29 @@ dbus_g_object_register_marshaller_array (GClosureMarshal  marshaller,
 					 const GType*     types)
 {
   DBusGFuncSignature *sig;
+  GHashTable *old_table;
+  GHashTable *new_table;
+  GHashTableIter iter;
+  gpointer key, value;
   guint i;
 
+  /* Lookups read marshal_table without locking, so registration copies
+   * the table, adds the new entry and publishes the copy. Superseded
+   * tables (and the signatures shared by them) are never freed since a
+   * lookup may still be reading one; registrations happen a handful of
+   * times at startup.
+   */
   g_static_rw_lock_writer_lock (&globals_lock);
 
-  if (marshal_table == NULL)
-    marshal_table = g_hash_table_new_full (funcsig_hash,
-					   funcsig_equal,
-					   (GDestroyNotify) funcsig_free,
-					   NULL);
+  new_table = g_hash_table_new (funcsig_hash, funcsig_equal);
+  old_table = marshal_table;
+  if (old_table)
+    {
+      g_hash_table_iter_init (&iter, old_table);
+      while (g_hash_table_iter_next (&iter, &key, &value))
+        g_hash_table_insert (new_table, key, value);
+    }
+
   sig = g_new0 (DBusGFuncSignature, 1);
   sig->rettype = G_TYPE_FUNDAMENTAL (rettype);
   sig->n_params = n_types;
@@ -2843,7 +2865,14 @@ dbus_g_object_register_marshaller_array (GClosureMarshal  marshaller,
   for (i = 0; i < n_types; i++)
     sig->params[i] = G_TYPE_FUNDAMENTAL (types[i]);
 
-  g_hash_table_insert (marshal_table, sig, marshaller);
+  if (g_hash_table_lookup_extended (new_table, sig, &key, NULL))
+    {
+      funcsig_free (sig);
+      sig = key;
+    }
+  g_hash_table_insert (new_table, sig, marshaller);
+
+  g_atomic_pointer_set (&marshal_table, new_table);
 
   g_static_rw_lock_writer_unlock (&globals_lock);
 }
@@ -76,10 +76,14 @@ struct _DBusGProxyPrivate
   guint call_id_counter;      /**< Integer counter for pending calls */
 
   GData *signal_signatures;   /**< D-BUS signatures for each signal */
+  GData *signal_marshallers;  /**< Marshallers found for each signal */
 
   GHashTable *pending_calls;  /**< Calls made on this proxy which have not yet returned */
 
   int default_timeout; /**< Default timeout to use, see dbus_g_proxy_set_default_timeout */
+
+  DBusGProxyNameOwnerNotify name_owner_notify; /**< See dbus_g_proxy_set_name_owner_notify */
+  gpointer name_owner_data;   /**< User data for name_owner_notify */
 };
 
 static void dbus_g_proxy_init               (DBusGProxy      *proxy);
@@ -421,6 +425,48 @@ tristring_alloc_from_strings (size_t      padding_before,
   return tri;
 }
 
+/* Size of the stack buffers used for tristring lookups in the filter */
+#define TRISTRING_BUF_SIZE 256
+
+/* Like tristring_alloc_from_strings (0, ...), but builds the tristring
+ * in buf when it fits, so hash lookups on the signal path don't
+ * allocate. Release with tristring_free_buf().
+ */
+static char*
+tristring_fill_buf (char       *buf,
+                    size_t      buf_len,
+                    const char *name,
+                    const char *path,
+                    const char *interface)
+{
+  size_t name_len, iface_len, path_len;
+
+  name_len = name ? strlen (name) : 0;
+  path_len = strlen (path);
+  iface_len = strlen (interface);
+
+  if (name_len + path_len + iface_len + 3 > buf_len)
+    return tristring_alloc_from_strings (0, name, path, interface);
+
+  if (name)
+    memcpy (buf, name, name_len);
+  buf[name_len] = '\0';
+  memcpy (&buf[name_len + 1], path, path_len);
+  buf[name_len + 1 + path_len] = '\0';
+  memcpy (&buf[name_len + path_len + 2], interface, iface_len);
+  buf[name_len + path_len + 2 + iface_len] = '\0';
+
+  return buf;
+}
+
+static void
+tristring_free_buf (char *tri,
+                    char *buf)
+{
+  if (tri != buf)
+    g_free (tri);
+}
+
 static char*
 tristring_from_proxy (DBusGProxy *proxy)
 {
@@ -433,7 +479,9 @@ tristring_from_proxy (DBusGProxy *proxy)
 }
 
 static char*
-tristring_from_message (DBusMessage *message)
+tristring_from_message (DBusMessage *message,
+                        char        *buf,
+                        size_t       buf_len)
 {
   const char *path;
   const char *interface;
@@ -444,9 +492,9 @@ tristring_from_message (DBusMessage *message)
   g_assert (path);
   g_assert (interface);
   
-  return tristring_alloc_from_strings (0,
-                                       dbus_message_get_sender (message),
-                                       path, interface);
+  return tristring_fill_buf (buf, buf_len,
+                             dbus_message_get_sender (message),
+                             path, interface);
 }
 
 static DBusGProxyList*
@@ -648,6 +696,65 @@ dbus_g_proxy_manager_unmonitor_name_owner (DBusGProxyManager  *manager,
     }
 }
 
+typedef struct
+{
+  DBusGProxy *proxy;
+  gboolean has_owner;
+} DBusGProxyNameOwnerChange;
+
+static gboolean
+name_owner_notify_idle (gpointer user_data)
+{
+  DBusGProxyNameOwnerChange *change = user_data;
+  DBusGProxyPrivate *priv = DBUS_G_PROXY_GET_PRIVATE(change->proxy);
+
+  /* not delivered to destroyed proxies */
+  if (priv->manager != NULL && priv->name_owner_notify != NULL)
+    (* priv->name_owner_notify) (change->proxy, change->has_owner,
+                                 priv->name_owner_data);
+
+  g_object_unref (change->proxy);
+  g_free (change);
+  return FALSE;
+}
+
+/* Called with the manager locked, the notification runs from the main loop */
+static void
+name_owner_notify_queue (DBusGProxy *proxy,
+                         gboolean    has_owner)
+{
+  DBusGProxyPrivate *priv = DBUS_G_PROXY_GET_PRIVATE(proxy);
+  DBusGProxyNameOwnerChange *change;
+
+  if (priv->name_owner_notify == NULL)
+    return;
+
+  change = g_new (DBusGProxyNameOwnerChange, 1);
+  change->proxy = g_object_ref (proxy);
+  change->has_owner = has_owner;
+  g_idle_add (name_owner_notify_idle, change);
+}
+
+static void
+name_owner_replaced (gpointer key, gpointer val, gpointer user_data)
+{
+  DBusGProxyList *list = val;
+  const char *name = user_data;
+  GSList *tmp;
+
+  for (tmp = list->proxies; tmp; tmp = tmp->next)
+    {
+      DBusGProxy *proxy = DBUS_G_PROXY (tmp->data);
+      DBusGProxyPrivate *priv = DBUS_G_PROXY_GET_PRIVATE(proxy);
+
+      if (!priv->for_owner && !strcmp (priv->name, name))
+        {
+          name_owner_notify_queue (proxy, FALSE);
+          name_owner_notify_queue (proxy, TRUE);
+        }
+    }
+}
+
 typedef struct
 {
   const char *name;
@@ -690,6 +797,7 @@ unassociate_proxies (gpointer key, gpointer val, gpointer user_data)
 
 	      priv->associated = FALSE;
 	      manager->unassociated_proxies = g_slist_prepend (manager->unassociated_proxies, proxy);
+	      name_owner_notify_queue (proxy, FALSE);
 	    }
 	  else
 	    {
@@ -731,6 +839,7 @@ dbus_g_proxy_manager_replace_name_owner (DBusGProxyManager  *manager,
 	      
 	      dbus_g_proxy_manager_monitor_name_owner (manager, new_owner, name);
 	      priv->associated = TRUE;
+	      name_owner_notify_queue (proxy, TRUE);
 	    }
 	}
 
@@ -806,7 +915,10 @@ dbus_g_proxy_manager_replace_name_owner (DBusGProxyManager  *manager,
 	}
       else if (info)
 	{
+	  /* the name was handed over, the new owner has none of the old state */
 	  insert_nameinfo (manager, new_owner, info);
+	  g_hash_table_foreach (manager->proxy_lists, name_owner_replaced,
+				(gpointer) name);
 	}
     }
 }
@@ -848,6 +960,7 @@ got_name_owner_cb (DBusGProxy       *bus_proxy,
     {
       dbus_g_proxy_manager_monitor_name_owner (priv->manager, owner, priv->name);
       priv->associated = TRUE;
+      name_owner_notify_queue (proxy, TRUE);
     }
 
  out:
@@ -1195,6 +1308,7 @@ dbus_g_proxy_manager_filter (DBusConnection    *connection,
     }
   else
     {
+      char tri_buf[TRISTRING_BUF_SIZE];
       char *tri;
       GSList *full_list;
       GSList *owned_names;
@@ -1238,7 +1352,7 @@ dbus_g_proxy_manager_filter (DBusConnection    *connection,
       g_assert (dbus_message_get_interface (message) != NULL);
       g_assert (dbus_message_get_member (message) != NULL);
       
-      tri = tristring_from_message (message);
+      tri = tristring_from_message (message, tri_buf, sizeof (tri_buf));
 
       if (manager->proxy_lists)
 	{
@@ -1252,7 +1366,7 @@ dbus_g_proxy_manager_filter (DBusConnection    *connection,
       else
 	full_list = NULL;
 
-      g_free (tri);
+      tristring_free_buf (tri, tri_buf);
 
       if (manager->owner_names && sender)
 	{
@@ -1264,9 +1378,9 @@ dbus_g_proxy_manager_filter (DBusConnection    *connection,
 
 	      nameinfo = tmp->data;
 	      g_assert (nameinfo->refcount > 0);
-	      tri = tristring_alloc_from_strings (0, nameinfo->name,
-						  dbus_message_get_path (message),
-						  dbus_message_get_interface (message));
+	      tri = tristring_fill_buf (tri_buf, sizeof (tri_buf), nameinfo->name,
+					dbus_message_get_path (message),
+					dbus_message_get_interface (message));
 
 	      owner_list = g_hash_table_lookup (manager->proxy_lists, tri);
 	      if (owner_list != NULL) 
@@ -1280,7 +1394,7 @@ dbus_g_proxy_manager_filter (DBusConnection    *connection,
 	                full_list = g_slist_append (full_list, elt->data);
 	            }
 	        }
-	      g_free (tri);
+	      tristring_free_buf (tri, tri_buf);
 	    }
 	}
 
@@ -1356,6 +1470,7 @@ dbus_g_proxy_init (DBusGProxy *proxy)
   DBusGProxyPrivate *priv = DBUS_G_PROXY_GET_PRIVATE(proxy);
   
   g_datalist_init (&priv->signal_signatures);
+  g_datalist_init (&priv->signal_marshallers);
   priv->pending_calls = g_hash_table_new_full (NULL, NULL, NULL,
 				(GDestroyNotify) dbus_pending_call_unref);
   priv->name_call = 0;
@@ -1499,6 +1614,7 @@ dbus_g_proxy_dispose (GObject *object)
   priv->manager = NULL;
   
   g_datalist_clear (&priv->signal_signatures);
+  g_datalist_clear (&priv->signal_marshallers);
   
   g_signal_emit (object, signals[DESTROY], 0);
   
@@ -1626,6 +1742,184 @@ create_signal_name (const char *interface,
   return g_string_free (str, FALSE);
 }
 
+/* Size of the stack buffer used for signal names of incoming signals */
+#define SIGNAL_NAME_BUF_SIZE 128
+
+/* Like create_signal_name(), but writes into buf when the name fits.
+ * Release with signal_name_free_buf().
+ */
+static char*
+create_signal_name_buf (char       *buf,
+                        size_t      buf_len,
+                        const char *interface,
+                        const char *signal)
+{
+  size_t iface_len, signal_len;
+  char *p;
+
+  iface_len = strlen (interface);
+  signal_len = strlen (signal);
+
+  if (iface_len + signal_len + 2 > buf_len)
+    return create_signal_name (interface, signal);
+
+  memcpy (buf, interface, iface_len);
+  buf[iface_len] = '-';
+  memcpy (&buf[iface_len + 1], signal, signal_len + 1);
+
+  for (p = buf; *p; ++p)
+    {
+      if (*p == '.')
+        *p = '-';
+    }
+
+  return buf;
+}
+
+static void
+signal_name_free_buf (char *name,
+                      char *buf)
+{
+  if (name != buf)
+    g_free (name);
+}
+
+static gboolean
+signature_is_property_changed (const GArray *gsignature)
+{
+  return gsignature->len == 2
+    && g_array_index (gsignature, GType, 0) == G_TYPE_STRING
+    && g_array_index (gsignature, GType, 1) == G_TYPE_VALUE;
+}
+
+/* Most of the signal traffic is PropertyChanged (s, v) with a basic
+ * typed value. Deliver it without a GValueArray: the arguments are read
+ * straight from the message into GValues on the stack, and strings are
+ * borrowed from the message, which outlives the emission. Returns FALSE
+ * if the message needs the generic path.
+ */
+static gboolean
+marshal_property_changed (GSignalCMarshaller  c_marshaller,
+                          GClosure           *closure,
+                          GValue             *return_value,
+                          DBusGProxy         *proxy,
+                          DBusMessage        *message,
+                          const GArray       *gsignature,
+                          gpointer            invocation_hint,
+                          gpointer            marshal_data)
+{
+  GValue params[3] = { { 0, }, { 0, }, { 0, } };
+  GValue variant = { 0, };
+  DBusMessageIter iter;
+  DBusMessageIter subiter;
+  const char *property;
+  union {
+    dbus_bool_t   b;
+    unsigned char y;
+    dbus_int16_t  n;
+    dbus_uint16_t q;
+    dbus_int32_t  i;
+    dbus_uint32_t u;
+#ifdef DBUS_HAVE_INT64
+    dbus_int64_t  x;
+    dbus_uint64_t t;
+#endif
+    double        d;
+    const char   *s;
+  } v;
+
+  if (!signature_is_property_changed (gsignature))
+    return FALSE;
+
+  if (!dbus_message_iter_init (message, &iter)
+      || dbus_message_iter_get_arg_type (&iter) != DBUS_TYPE_STRING)
+    return FALSE;
+  dbus_message_iter_get_basic (&iter, &property);
+
+  if (!dbus_message_iter_next (&iter)
+      || dbus_message_iter_get_arg_type (&iter) != DBUS_TYPE_VARIANT)
+    return FALSE;
+  dbus_message_iter_recurse (&iter, &subiter);
+
+  switch (dbus_message_iter_get_arg_type (&subiter))
+    {
+    case DBUS_TYPE_BOOLEAN:
+      dbus_message_iter_get_basic (&subiter, &v.b);
+      g_value_init (&variant, G_TYPE_BOOLEAN);
+      g_value_set_boolean (&variant, v.b);
+      break;
+    case DBUS_TYPE_BYTE:
+      dbus_message_iter_get_basic (&subiter, &v.y);
+      g_value_init (&variant, G_TYPE_UCHAR);
+      g_value_set_uchar (&variant, v.y);
+      break;
+    case DBUS_TYPE_INT16:
+      dbus_message_iter_get_basic (&subiter, &v.n);
+      g_value_init (&variant, G_TYPE_INT);
+      g_value_set_int (&variant, v.n);
+      break;
+    case DBUS_TYPE_UINT16:
+      dbus_message_iter_get_basic (&subiter, &v.q);
+      g_value_init (&variant, G_TYPE_UINT);
+      g_value_set_uint (&variant, v.q);
+      break;
+    case DBUS_TYPE_INT32:
+      dbus_message_iter_get_basic (&subiter, &v.i);
+      g_value_init (&variant, G_TYPE_INT);
+      g_value_set_int (&variant, v.i);
+      break;
+    case DBUS_TYPE_UINT32:
+      dbus_message_iter_get_basic (&subiter, &v.u);
+      g_value_init (&variant, G_TYPE_UINT);
+      g_value_set_uint (&variant, v.u);
+      break;
+#ifdef DBUS_HAVE_INT64
+    case DBUS_TYPE_INT64:
+      dbus_message_iter_get_basic (&subiter, &v.x);
+      g_value_init (&variant, G_TYPE_INT64);
+      g_value_set_int64 (&variant, v.x);
+      break;
+    case DBUS_TYPE_UINT64:
+      dbus_message_iter_get_basic (&subiter, &v.t);
+      g_value_init (&variant, G_TYPE_UINT64);
+      g_value_set_uint64 (&variant, v.t);
+      break;
+#endif
+    case DBUS_TYPE_DOUBLE:
+      dbus_message_iter_get_basic (&subiter, &v.d);
+      g_value_init (&variant, G_TYPE_DOUBLE);
+      g_value_set_double (&variant, v.d);
+      break;
+    case DBUS_TYPE_STRING:
+      dbus_message_iter_get_basic (&subiter, &v.s);
+      g_value_init (&variant, G_TYPE_STRING);
+      g_value_set_static_string (&variant, v.s);
+      break;
+    default:
+      /* containers, object paths: take the generic path */
+      return FALSE;
+    }
+
+  g_value_init (&params[0], G_TYPE_FROM_INSTANCE (proxy));
+  g_value_set_instance (&params[0], proxy);
+  g_value_init (&params[1], G_TYPE_STRING);
+  g_value_set_static_string (&params[1], property);
+  g_value_init (&params[2], G_TYPE_VALUE);
+  g_value_set_static_boxed (&params[2], &variant);
+
+  (* c_marshaller) (closure, return_value, 3, params,
+                    invocation_hint, marshal_data);
+
+  /* handlers usually unset the value themselves */
+  if (G_IS_VALUE (&variant))
+    g_value_unset (&variant);
+  g_value_unset (&params[2]);
+  g_value_unset (&params[1]);
+  g_value_unset (&params[0]);
+
+  return TRUE;
+}
+
 static void
 marshal_dbus_message_to_g_marshaller (GClosure     *closure,
                                       GValue       *return_value,
@@ -1647,6 +1941,7 @@ marshal_dbus_message_to_g_marshaller (GClosure     *closure,
   GArray *gsignature;
   const GType *types;
   DBusGProxyPrivate *priv;
+  GQuark detail;
 
   g_assert (n_param_values == 3);
 
@@ -1660,10 +1955,25 @@ marshal_dbus_message_to_g_marshaller (GClosure     *closure,
 
   priv = DBUS_G_PROXY_GET_PRIVATE(proxy);
 
-  c_marshaller = _dbus_gobject_lookup_marshaller (G_TYPE_NONE, gsignature->len,
-						  (GType*) gsignature->data);
+  /* The detail of the "received" emission is the signal quark; keep the
+   * marshaller found for it so later emissions skip the lookup.
+   * Registered marshallers are never removed.
+   */
+  detail = ((GSignalInvocationHint *) invocation_hint)->detail;
+  c_marshaller = g_datalist_id_get_data (&priv->signal_marshallers, detail);
+  if (c_marshaller == NULL)
+    {
+      c_marshaller = _dbus_gobject_lookup_marshaller (G_TYPE_NONE, gsignature->len,
+						      (GType*) gsignature->data);
+
+      g_return_if_fail (c_marshaller != NULL);
 
-  g_return_if_fail (c_marshaller != NULL);
+      g_datalist_id_set_data (&priv->signal_marshallers, detail, c_marshaller);
+    }
+
+  if (marshal_property_changed (c_marshaller, closure, return_value, proxy, message,
+                                gsignature, invocation_hint, marshal_data))
+    return;
   
   {
     DBusGValueMarshalCtx context;
@@ -1689,16 +1999,149 @@ marshal_dbus_message_to_g_marshaller (GClosure     *closure,
   g_value_array_free (value_array);
 }
 
+/* Incoming signals are resolved through a cache keyed by (interface,
+ * member, signature) which holds the GLib signal quark and the GType
+ * array parsed from the signature, so a hit costs one hash lookup and
+ * no string building. Only signals somebody added with
+ * dbus_g_proxy_add_signal() are cached; the table is flushed when it
+ * grows past SIGNAL_CACHE_MAX entries.
+ */
+#define SIGNAL_CACHE_MAX 128
+
+typedef struct
+{
+  char *interface;
+  char *member;
+  char *signature;
+  GQuark quark;
+  GArray *gtypes;
+} DBusGSignalCacheEntry;
+
+static GStaticMutex signal_cache_lock = G_STATIC_MUTEX_INIT;
+static GHashTable *signal_cache = NULL;
+static volatile gint signal_cache_hits = 0;
+static volatile gint signal_cache_misses = 0;
+
+static guint
+signal_cache_hash (gconstpointer key)
+{
+  const DBusGSignalCacheEntry *entry = key;
+
+  return g_str_hash (entry->interface)
+    ^ (g_str_hash (entry->member) * 31)
+    ^ (g_str_hash (entry->signature) * 17);
+}
+
+static gboolean
+signal_cache_equal (gconstpointer a,
+                    gconstpointer b)
+{
+  const DBusGSignalCacheEntry *ea = a;
+  const DBusGSignalCacheEntry *eb = b;
+
+  return strcmp (ea->member, eb->member) == 0
+    && strcmp (ea->interface, eb->interface) == 0
+    && strcmp (ea->signature, eb->signature) == 0;
+}
+
+static void
+signal_cache_entry_free (gpointer data)
+{
+  DBusGSignalCacheEntry *entry = data;
+
+  g_free (entry->interface);
+  g_free (entry->member);
+  g_free (entry->signature);
+  g_array_free (entry->gtypes, TRUE);
+  g_free (entry);
+}
+
+/* Must be called with signal_cache_lock held. Returns NULL if nobody
+ * registered the signal.
+ */
+static const DBusGSignalCacheEntry *
+signal_cache_lookup (const char *interface,
+                     const char *member,
+                     const char *signature)
+{
+  DBusGSignalCacheEntry key;
+  DBusGSignalCacheEntry *entry;
+  char name_buf[SIGNAL_NAME_BUF_SIZE];
+  char *name;
+  GQuark q;
+
+  key.interface = (char *) interface;
+  key.member = (char *) member;
+  key.signature = (char *) signature;
+
+  if (signal_cache != NULL)
+    {
+      entry = g_hash_table_lookup (signal_cache, &key);
+      if (entry != NULL)
+        {
+          g_atomic_int_inc (&signal_cache_hits);
+          return entry;
+        }
+    }
+
+  g_atomic_int_inc (&signal_cache_misses);
+
+  name = create_signal_name_buf (name_buf, sizeof (name_buf), interface, member);
+
+  /* If the quark isn't preexisting, there's no way there
+   * are any handlers connected. We don't want to create
+   * extra quarks for every possible signal.
+   */
+  q = g_quark_try_string (name);
+  signal_name_free_buf (name, name_buf);
+  if (q == 0)
+    return NULL;
+
+  if (signal_cache == NULL)
+    signal_cache = g_hash_table_new_full (signal_cache_hash, signal_cache_equal,
+                                          NULL, signal_cache_entry_free);
+  else if (g_hash_table_size (signal_cache) >= SIGNAL_CACHE_MAX)
+    g_hash_table_remove_all (signal_cache);
+
+  entry = g_new (DBusGSignalCacheEntry, 1);
+  entry->interface = g_strdup (interface);
+  entry->member = g_strdup (member);
+  entry->signature = g_strdup (signature);
+  entry->quark = q;
+  entry->gtypes = _dbus_gtypes_from_arg_signature (signature, TRUE);
+  g_hash_table_insert (signal_cache, entry, entry);
+
+  return entry;
+}
+
+/**
+ * dbus_g_proxy_get_signal_cache_stats:
+ * @hits: return location for the number of cache hits
+ * @misses: return location for the number of cache misses
+ *
+ * Reports how incoming signals were resolved to GLib signals:
+ * a miss builds the signal name and parses the message signature.
+ */
+void
+dbus_g_proxy_get_signal_cache_stats (guint *hits,
+                                     guint *misses)
+{
+  if (hits)
+    *hits = g_atomic_int_get (&signal_cache_hits);
+  if (misses)
+    *misses = g_atomic_int_get (&signal_cache_misses);
+}
+
 static void
 dbus_g_proxy_emit_remote_signal (DBusGProxy  *proxy,
                                  DBusMessage *message)
 {
   const char *interface;
   const char *signal;
-  char *name;
-  GQuark q;
+  const DBusGSignalCacheEntry *entry;
+  GArray *gsignature = NULL;
+  GQuark q = 0;
   DBusGProxyPrivate *priv = DBUS_G_PROXY_GET_PRIVATE(proxy);
-  GArray *msg_gsignature = NULL;
 
   g_return_if_fail (!DBUS_G_PROXY_DESTROYED (proxy));
 
@@ -1708,54 +2151,32 @@ dbus_g_proxy_emit_remote_signal (DBusGProxy  *proxy,
   g_assert (interface != NULL);
   g_assert (signal != NULL);
 
-  name = create_signal_name (interface, signal);
-
-  /* If the quark isn't preexisting, there's no way there
-   * are any handlers connected. We don't want to create
-   * extra quarks for every possible signal.
-   */
-  q = g_quark_try_string (name);
-
-  if (q != 0)
+  g_static_mutex_lock (&signal_cache_lock);
+  entry = signal_cache_lookup (interface, signal,
+                               dbus_message_get_signature (message));
+  if (entry != NULL)
     {
-      GArray *gsignature;
-      guint i;
-      
+      q = entry->quark;
       gsignature = g_datalist_id_get_data (&priv->signal_signatures, q);
-      if (gsignature == NULL)
-	goto out;
-      
-      msg_gsignature = _dbus_gtypes_from_arg_signature (dbus_message_get_signature (message),
-						       TRUE);
-      for (i = 0; i < gsignature->len; i++)
-	{
-	  if (msg_gsignature->len == i
-	      || g_array_index (gsignature, GType, i) != g_array_index (msg_gsignature, GType, i))
-	    goto mismatch;
-	}
-      if (msg_gsignature->len != i)
-	goto mismatch;
-      
-      g_signal_emit (proxy,
-		     signals[RECEIVED],
-		     q,
-		     message,
-		     msg_gsignature);
+
+      /* Don't spew on remote errors, just drop mismatching signals */
+      if (gsignature != NULL
+          && (gsignature->len != entry->gtypes->len
+              || memcmp (gsignature->data, entry->gtypes->data,
+                         gsignature->len * sizeof (GType)) != 0))
+        gsignature = NULL;
     }
+  g_static_mutex_unlock (&signal_cache_lock);
 
- out:
-  g_free (name);
-  if (msg_gsignature)
-    g_array_free (msg_gsignature, TRUE);
-  return;
- mismatch:
-#if 0
-  /* Don't spew on remote errors */
-  g_warning ("Unexpected message signature '%s' for signal '%s'\n",
-	     dbus_message_get_signature (message),
-	     name);
-#endif
-  goto out;
+  /* The registered signature equals the message one, and unlike the
+   * cache entry it can't go away during the emission.
+   */
+  if (gsignature != NULL)
+    g_signal_emit (proxy,
+                   signals[RECEIVED],
+                   q,
+                   message,
+                   gsignature);
 }
 
 typedef struct
@@ -2517,6 +2938,50 @@ dbus_g_proxy_begin_call_with_timeout (DBusGProxy          *proxy,
   return DBUS_G_PROXY_ID_TO_CALL (call_id);
 }
 
+/**
+ * dbus_g_proxy_begin_call_value_array:
+ * @proxy: a proxy for a remote interface
+ * @method: the name of the method to invoke
+ * @notify: callback to be invoked when method returns
+ * @user_data: user data passed to callback
+ * @destroy: function called to destroy user_data
+ * @timeout: specify the timeout in milliseconds, -1 for the proxy default
+ * @args: the "in" arguments, already collected into GValues
+ *
+ * Like dbus_g_proxy_begin_call_with_timeout(), but takes the arguments
+ * as a #GValueArray instead of a varargs list. This allows a caller to
+ * collect the arguments on one thread and start the call later from
+ * the thread running the main loop.
+ *
+ * Returns: call identifier, or %NULL if the call could not be sent
+ * (in which case @destroy is not invoked).
+ */
+DBusGProxyCall *
+dbus_g_proxy_begin_call_value_array (DBusGProxy          *proxy,
+                                     const char          *method,
+                                     DBusGProxyCallNotify notify,
+                                     gpointer             user_data,
+                                     GDestroyNotify       destroy,
+                                     int                  timeout,
+                                     GValueArray         *args)
+{
+  guint call_id;
+  DBusGProxyPrivate *priv;
+
+  g_return_val_if_fail (DBUS_IS_G_PROXY (proxy), NULL);
+  g_return_val_if_fail (!DBUS_G_PROXY_DESTROYED (proxy), NULL);
+  g_return_val_if_fail (args != NULL, NULL);
+
+  priv = DBUS_G_PROXY_GET_PRIVATE(proxy);
+
+  if (timeout < 0)
+    timeout = priv->default_timeout;
+
+  call_id = dbus_g_proxy_begin_call_internal (proxy, method, notify, user_data, destroy, args, timeout);
+
+  return DBUS_G_PROXY_ID_TO_CALL (call_id);
+}
+
 /**
  * dbus_g_proxy_end_call:
  * @proxy: a proxy for a remote interface
@@ -3001,6 +3466,39 @@ dbus_g_proxy_set_default_timeout (DBusGProxy        *proxy,
   priv->default_timeout = timeout;
 }
 
+/**
+ * dbus_g_proxy_set_name_owner_notify:
+ * @proxy: a proxy for a well-known name
+ * @notify: called when the name gains or loses its owner, or %NULL
+ * @user_data: data passed to @notify
+ *
+ * Lets the caller follow the service behind @proxy coming and going,
+ * from the name owner tracking the proxy manager already does. @notify
+ * runs from the default main context; if the name already has an owner
+ * it is called once with @has_owner %TRUE. A name handed over to a new
+ * owner is reported as lost and gained again.
+ */
+void
+dbus_g_proxy_set_name_owner_notify (DBusGProxy                *proxy,
+                                    DBusGProxyNameOwnerNotify  notify,
+                                    gpointer                   user_data)
+{
+  DBusGProxyPrivate *priv;
+
+  g_return_if_fail (DBUS_IS_G_PROXY (proxy));
+  g_return_if_fail (!DBUS_G_PROXY_DESTROYED (proxy));
+
+  priv = DBUS_G_PROXY_GET_PRIVATE(proxy);
+  g_return_if_fail (priv->name != NULL && !priv->for_owner);
+
+  LOCK_MANAGER (priv->manager);
+  priv->name_owner_notify = notify;
+  priv->name_owner_data = user_data;
+  if (priv->associated)
+    name_owner_notify_queue (proxy, TRUE);
+  UNLOCK_MANAGER (priv->manager);
+}
+
 
 /** @} End of DBusGLib public */
 
@@ -22,7 +22,10 @@ include $(CLEAR_VARS)
 LOCAL_SRC_FILES:= \
 	ril.c \
 	pdu.c \
-	marshaller.c
+	marshaller.c \
+	stats.c \
+	trace.c \
+	identity.c
 ##
 
 LOCAL_C_INCLUDES := \
@@ -54,6 +57,11 @@ ifeq ($(PLATFORM_VERSION_CODENAME),AOSP)
 LOCAL_CFLAGS += -DAOSP
 endif
 
+# errors and warnings only in user builds, see logging.h
+ifeq ($(TARGET_BUILD_VARIANT),user)
+LOCAL_CFLAGS += -DRIL_LOG_LEVEL=2
+endif
+
 LOCAL_LDLIBS += -lpthread
 
 ifeq ($(TARGET_PRODUCT),n900)
@@ -72,3 +80,12 @@ LOCAL_MODULE:= libofono-ril
 LOCAL_MODULE_TAGS := optional
 
 include $(BUILD_SHARED_LIBRARY)
+
+# trace dump decoder, see trace.h
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := tracedecode.c
+LOCAL_MODULE := ofono-ril-tracedecode
+LOCAL_MODULE_TAGS := optional
+
+include $(BUILD_HOST_EXECUTABLE)
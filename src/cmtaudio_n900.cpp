@@ -27,6 +27,7 @@ extern "C" {
 }
 
 #include "cmtaudio.h"
+#include "trace.h"
 
 #define LOG_TAG "CMTAUDIO"
 #define vsyslog(level, format, ap) LOG_PRI_VA(level, LOG_TAG, format, ap);
@@ -141,6 +142,7 @@ static void handleCmtspeechData()
     int res = cmtspeech_dl_buffer_acquire(cmtspeech, &dlbuf);
     if (res == 0) {
         LOGD("Received a DL packet (%u bytes).\n", dlbuf->count);
+        traceEvent(TRACE_AUDIO_IN, 0, dlbuf->count, 0);
 #if LOOPBACK_TEST > 0
         if (cmtspeech_protocol_state(cmtspeech) ==
             CMTSPEECH_STATE_ACTIVE_DLUL) {
@@ -149,12 +151,14 @@ static void handleCmtspeechData()
                 if (ulbuf->pcount >= dlbuf->pcount) {
                     LOGD("Looping DL packet to UL (%u payload bytes).\n", dlbuf->pcount);
                     memcpy(ulbuf->payload, dlbuf->payload, dlbuf->pcount);
+                    traceEvent(TRACE_AUDIO_OUT, 0, dlbuf->pcount, 0);
                 }
                 cmtspeech_ul_buffer_release(cmtspeech, ulbuf);
             }
         }
 #else
         ssize_t written = aTrack->write(dlbuf->payload, dlbuf->pcount);
+        traceEvent(TRACE_AUDIO_OUT, 0, written > 0 ? written : 0, 0);
 #endif
         res = cmtspeech_dl_buffer_release(cmtspeech, dlbuf);
     }
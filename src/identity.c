@@ -0,0 +1,112 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define LOG_TAG "RIL"
+#include <utils/Log.h>
+#include "logging.h"
+
+#include "identity.h"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t checksum;          // of fields
+    char     fields[IDENTITY_COUNT][IDENTITY_FIELD_SIZE];
+} IdentityFile;
+
+static IdentityFile *file;      // NULL while the cache is off
+static int valid;
+
+/* FNV-1a */
+static uint32_t checksumOf(const IdentityFile *f)
+{
+    const unsigned char *p = (const unsigned char *) f->fields;
+    uint32_t hash = 2166136261u;
+    size_t i;
+
+    for (i = 0; i < sizeof(f->fields); i++)
+        hash = (hash ^ p[i]) * 16777619u;
+    return hash;
+}
+
+int identityInit(const char *path)
+{
+    void *map;
+    int fd;
+
+    fd = open(path, O_RDWR | O_CREAT, 0640);
+    if (fd < 0) {
+        LOGW("identity: can't open %s: %s", path, strerror(errno));
+        return -1;
+    }
+    if (ftruncate(fd, sizeof(IdentityFile)) < 0) {
+        LOGW("identity: can't resize %s: %s", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    map = mmap(NULL, sizeof(IdentityFile), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == map) {
+        LOGW("identity: can't map %s: %s", path, strerror(errno));
+        return -1;
+    }
+    file = (IdentityFile *) map;
+
+    valid = IDENTITY_MAGIC == file->magic && IDENTITY_VERSION == file->version
+            && checksumOf(file) == file->checksum;
+    if (!valid) {
+        LOGI("identity: no valid cache in %s", path);
+        memset(file, 0, sizeof(IdentityFile));
+        file->magic = IDENTITY_MAGIC;
+        file->version = IDENTITY_VERSION;
+        file->checksum = checksumOf(file);
+    }
+    return valid;
+}
+
+const char *identityGet(IdentityField field)
+{
+    if (!file || !valid)
+        return "";
+    return file->fields[field];
+}
+
+void identitySet(IdentityField field, const char *value)
+{
+    char *slot;
+
+    if (!file)
+        return;
+
+    slot = file->fields[field];
+    if (!strncmp(slot, value, IDENTITY_FIELD_SIZE - 1))
+        return;
+
+    // a crash in between leaves a checksum mismatch, the cache is then ignored
+    strncpy(slot, value, IDENTITY_FIELD_SIZE - 1);
+    slot[IDENTITY_FIELD_SIZE - 1] = 0;
+    file->checksum = checksumOf(file);
+    valid = 1;
+    msync(file, sizeof(IdentityFile), MS_ASYNC);
+}
@@ -0,0 +1,59 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef __IDENTITY_H
+#define __IDENTITY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Modem and SIM identity kept across rild restarts in a small
+ * memory-mapped file, so requests for them can be answered before ofono
+ * reports the live values. A checksum covers the values; a torn or
+ * foreign file is ignored and rewritten from the live values.
+ */
+
+#define IDENTITY_MAGIC      0x4449524f  // "ORID"
+#define IDENTITY_VERSION    1
+#define IDENTITY_FIELD_SIZE 64
+
+typedef enum {
+    IDENTITY_IMEI = 0,
+    IDENTITY_REVISION,
+    IDENTITY_IMSI,
+    IDENTITY_OPERATOR,          // last registered operator: name, MCC, MNC
+    IDENTITY_MCC,
+    IDENTITY_MNC,
+    IDENTITY_COUNT
+} IdentityField;
+
+/* Map the cache file, 1 if it holds valid values, 0 if not, -1 on error */
+int identityInit(const char *path);
+
+/* Cached value, "" if there's none */
+const char *identityGet(IdentityField field);
+
+/* Store a live value; main loop thread only */
+void identitySet(IdentityField field, const char *value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __IDENTITY_H
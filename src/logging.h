@@ -0,0 +1,108 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef __LOGGING_H
+#define __LOGGING_H
+
+/*
+ * Include after <utils/Log.h>.
+ *
+ * RIL_LOG_LEVEL selects the messages compiled in: 1 errors, 2 +warnings,
+ * 3 +info, 4 +debug. Disabled macros expand to nothing, so their
+ * arguments are never evaluated.
+ */
+
+#include <time.h>
+#include <glib-object.h>
+
+#ifndef RIL_LOG_LEVEL
+#define RIL_LOG_LEVEL 4
+#endif
+
+#define RIL_LOGE_ENABLED 1
+#define RIL_LOGW_ENABLED (RIL_LOG_LEVEL >= 2)
+#define RIL_LOGI_ENABLED (RIL_LOG_LEVEL >= 3)
+#define RIL_LOGD_ENABLED (RIL_LOG_LEVEL >= 4)
+
+#if !RIL_LOGW_ENABLED
+#undef LOGW
+#define LOGW(...) ((void) 0)
+#endif
+
+#if !RIL_LOGI_ENABLED
+#undef LOGI
+#define LOGI(...) ((void) 0)
+#endif
+
+#if !RIL_LOGD_ENABLED
+#undef LOGD
+#define LOGD(...) ((void) 0)
+#endif
+
+/* Messages per second a rate-limited call site may log */
+#define RIL_LOG_RATE 10
+
+typedef struct {
+    time_t   second;
+    unsigned count;
+    unsigned suppressed;
+} LogRateLimit;
+
+static inline int logRateLimitAllow(LogRateLimit *rl, const char *site)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    if (ts.tv_sec != rl->second) {
+        if (rl->suppressed)
+            LOGW("%s: %u log messages suppressed", site, rl->suppressed);
+        rl->second = ts.tv_sec;
+        rl->count = 0;
+        rl->suppressed = 0;
+    }
+    if (rl->count >= RIL_LOG_RATE) {
+        rl->suppressed++;
+        return 0;
+    }
+    rl->count++;
+    return 1;
+}
+
+/* LOG_RATELIMITED(D, "fmt", ...): LOGD limited to RIL_LOG_RATE per second */
+#define LOG_RATELIMITED(LEVEL, ...) \
+    do { \
+        if (RIL_LOG##LEVEL##_ENABLED) { \
+            static LogRateLimit _rl; \
+            if (logRateLimitAllow(&_rl, __func__)) \
+                LOG##LEVEL(__VA_ARGS__); \
+        } \
+    } while (0)
+
+/* Rate-limited "who property->value", the value is formatted only when logged */
+#define LOG_PROPERTY(LEVEL, who, property, value) \
+    do { \
+        if (RIL_LOG##LEVEL##_ENABLED) { \
+            static LogRateLimit _rl; \
+            if (logRateLimitAllow(&_rl, who)) { \
+                gchar *_str = g_strdup_value_contents(value); \
+                LOG##LEVEL("%s %s->%s", who, property, _str); \
+                g_free(_str); \
+            } \
+        } \
+    } while (0)
+
+#endif // __LOGGING_H
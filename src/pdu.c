@@ -18,10 +18,21 @@
 ** limitations under the License.
 */
 
+#include <pthread.h>
+#include <string.h>
 #include <glib.h>
 
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #define LOG_TAG "RIL"
 #include <utils/Log.h>
+#include "logging.h"
+
+#include "pdu.h"
 
 static inline unsigned char makeSemiOctet(guint8 in)
 {
@@ -38,10 +49,52 @@ static inline void setSemiOctet(unsigned char *pdu, int *offset, unsigned char o
 	*offset = *offset + 1;
 }
 
+static const char hexDigits[16] = "0123456789abcdef";
+
 static inline void setOctet(unsigned char *pdu, int *offset, guint8 oct)
 {
-    setSemiOctet(pdu, offset, makeSemiOctet((oct & 0xf0) >> 4));
-    setSemiOctet(pdu, offset, makeSemiOctet(oct & 0x0f));
+    pdu[*offset] = hexDigits[oct >> 4];
+    pdu[*offset + 1] = hexDigits[oct & 0x0f];
+    *offset = *offset + 2;
+}
+
+/* Write count octets as hex digits, 16 at a time where SIMD is available */
+static void setOctets(unsigned char *pdu, int *offset, const guint8 *data, int count)
+{
+    unsigned char *out = &pdu[*offset];
+    int i = 0;
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+    const uint8x16_t nine = vdupq_n_u8(9), letter = vdupq_n_u8('a' - '0' - 10);
+    for (; i + 16 <= count; i += 16, out += 32) {
+        uint8x16_t in = vld1q_u8(&data[i]);
+        uint8x16x2_t hex;
+        hex.val[0] = vshrq_n_u8(in, 4);
+        hex.val[1] = vandq_u8(in, vdupq_n_u8(0x0f));
+        hex.val[0] = vaddq_u8(vaddq_u8(hex.val[0], vdupq_n_u8('0')),
+                              vandq_u8(vcgtq_u8(hex.val[0], nine), letter));
+        hex.val[1] = vaddq_u8(vaddq_u8(hex.val[1], vdupq_n_u8('0')),
+                              vandq_u8(vcgtq_u8(hex.val[1], nine), letter));
+        vst2q_u8(out, hex);     // interleaves high and low digits
+    }
+#elif defined(__SSE2__)
+    const __m128i mask = _mm_set1_epi8(0x0f), nine = _mm_set1_epi8(9);
+    const __m128i zero = _mm_set1_epi8('0'), letter = _mm_set1_epi8('a' - '0' - 10);
+    for (; i + 16 <= count; i += 16, out += 32) {
+        __m128i in = _mm_loadu_si128((const __m128i *) &data[i]);
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(in, 4), mask);
+        __m128i lo = _mm_and_si128(in, mask);
+        hi = _mm_add_epi8(_mm_add_epi8(hi, zero), _mm_and_si128(_mm_cmpgt_epi8(hi, nine), letter));
+        lo = _mm_add_epi8(_mm_add_epi8(lo, zero), _mm_and_si128(_mm_cmpgt_epi8(lo, nine), letter));
+        _mm_storeu_si128((__m128i *) out, _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i *) (out + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+#endif
+    for (; i < count; i++) {
+        *out++ = hexDigits[data[i] >> 4];
+        *out++ = hexDigits[data[i] & 0x0f];
+    }
+    *offset += 2 * count;
 }
 
 static int encodeNumber(unsigned char *pdu, const char *num)
@@ -65,7 +118,195 @@ static int encodeNumber(unsigned char *pdu, const char *num)
     return res ? res : 0;
 }
 
-int encodePDU(unsigned char *pdu, const char *message, const char *smsc, const char *sender)
+/*** Text conversion ***/
+
+/* GSM 03.38 default alphabet, septet -> Unicode (0x1b is the escape) */
+static const gunichar gsmDefault[128] = {
+    '@',    0xa3,   '$',    0xa5,   0xe8,   0xe9,   0xf9,   0xec,
+    0xf2,   0xc7,   '\n',   0xd8,   0xf8,   '\r',   0xc5,   0xe5,
+    0x394,  '_',    0x3a6,  0x393,  0x39b,  0x3a9,  0x3a0,  0x3a8,
+    0x3a3,  0x398,  0x39e,  0x1b,   0xc6,   0xe6,   0xdf,   0xc9,
+    ' ',    '!',    '"',    '#',    0xa4,   '%',    '&',    '\'',
+    '(',    ')',    '*',    '+',    ',',    '-',    '.',    '/',
+    '0',    '1',    '2',    '3',    '4',    '5',    '6',    '7',
+    '8',    '9',    ':',    ';',    '<',    '=',    '>',    '?',
+    0xa1,   'A',    'B',    'C',    'D',    'E',    'F',    'G',
+    'H',    'I',    'J',    'K',    'L',    'M',    'N',    'O',
+    'P',    'Q',    'R',    'S',    'T',    'U',    'V',    'W',
+    'X',    'Y',    'Z',    0xc4,   0xd6,   0xd1,   0xdc,   0xa7,
+    0xbf,   'a',    'b',    'c',    'd',    'e',    'f',    'g',
+    'h',    'i',    'j',    'k',    'l',    'm',    'n',    'o',
+    'p',    'q',    'r',    's',    't',    'u',    'v',    'w',
+    'x',    'y',    'z',    0xe4,   0xf6,   0xf1,   0xfc,   0xe0,
+};
+
+/* GSM 03.38 extension table, reached with the escape septet */
+static const struct {
+    guint8   septet;
+    gunichar uc;
+} gsmExtension[] = {
+    { 0x0a, 0x0c }, { 0x14, '^' }, { 0x28, '{' }, { 0x29, '}' }, { 0x2f, '\\' },
+    { 0x3c, '[' }, { 0x3d, '~' }, { 0x3e, ']' }, { 0x40, '|' }, { 0x65, 0x20ac },
+};
+
+#define GSM_ESCAPE      0x1b
+#define GSM_NONE        0xffff  // not in the GSM alphabet
+#define GSM_EXTENDED    0x100   // flag: escape + septet
+
+/* Reverse tables: Latin-1 range and the Greek capitals, built once */
+static guint16 gsmFromLatin1[0x100];
+static guint16 gsmFromGreek[0x3aa - 0x390];
+static pthread_once_t gsmTablesOnce = PTHREAD_ONCE_INIT;
+
+static void gsmTablesInit()
+{
+    unsigned i;
+
+    for (i = 0; i < G_N_ELEMENTS(gsmFromLatin1); i++)
+        gsmFromLatin1[i] = GSM_NONE;
+    for (i = 0; i < G_N_ELEMENTS(gsmFromGreek); i++)
+        gsmFromGreek[i] = GSM_NONE;
+
+    for (i = 0; i < G_N_ELEMENTS(gsmDefault); i++) {
+        gunichar uc = gsmDefault[i];
+        if (GSM_ESCAPE == i)
+            continue;
+        if (uc < 0x100)
+            gsmFromLatin1[uc] = i;
+        else
+            gsmFromGreek[uc - 0x390] = i;
+    }
+    for (i = 0; i < G_N_ELEMENTS(gsmExtension); i++) {
+        gunichar uc = gsmExtension[i].uc;
+        if (uc < 0x100)
+            gsmFromLatin1[uc] = GSM_EXTENDED | gsmExtension[i].septet;
+    }
+}
+
+static inline guint16 gsmFromUnicode(gunichar uc)
+{
+    if (uc < 0x100)
+        return gsmFromLatin1[uc];
+    if (uc >= 0x390 && uc < 0x3aa)
+        return gsmFromGreek[uc - 0x390];
+    if (0x20ac == uc)
+        return GSM_EXTENDED | 0x65;
+    return GSM_NONE;
+}
+
+/* Next character of a UTF-8 string, invalid sequences read as '?' */
+static inline gunichar nextChar(const char **str)
+{
+    gunichar uc = g_utf8_get_char_validated(*str, -1);
+
+    if (uc >= 0x110000) {
+        (*str)++;
+        return '?';
+    }
+    *str = g_utf8_next_char(*str);
+    return uc;
+}
+
+/**
+ * Convert UTF-8 text to unpacked GSM septets
+ *
+ * @septets  room for 2 * strlen(utf8) septets
+ * @return   number of septets, -1 if the text needs UCS2
+ */
+static int utf8ToGsm(const char *utf8, guint8 *septets)
+{
+    int count = 0;
+
+    pthread_once(&gsmTablesOnce, gsmTablesInit);
+
+    while (*utf8) {
+        guint16 gsm = gsmFromUnicode(nextChar(&utf8));
+        if (GSM_NONE == gsm)
+            return -1;
+        if (gsm & GSM_EXTENDED)
+            septets[count++] = GSM_ESCAPE;
+        septets[count++] = gsm & 0x7f;
+    }
+    return count;
+}
+
+/**
+ * Convert UTF-8 text to UCS2 (UTF-16BE, characters beyond the BMP as
+ * surrogate pairs)
+ *
+ * @out     room for 2 * strlen(utf8) octets
+ * @return  number of octets
+ */
+static int utf8ToUcs2(const char *utf8, guint8 *out)
+{
+    int count = 0;
+
+    while (*utf8) {
+        gunichar uc = nextChar(&utf8);
+        if (uc >= 0x10000) {
+            gunichar hi = 0xd800 + ((uc - 0x10000) >> 10);
+            gunichar lo = 0xdc00 + ((uc - 0x10000) & 0x3ff);
+            out[count++] = hi >> 8;
+            out[count++] = hi & 0xff;
+            uc = lo;
+        }
+        out[count++] = uc >> 8;
+        out[count++] = uc & 0xff;
+    }
+    return count;
+}
+
+/**
+ * Pack septets into octets, 8 septets into 7 octets at a time
+ *
+ * @fillBits  zero bits preceding the first septet (to align after a UDH)
+ * @return    number of octets written
+ */
+static int packSeptets(const guint8 *septets, int count, int fillBits, guint8 *out)
+{
+    guint64 acc = 0;
+    int bits = fillBits;
+    guint8 *start = out;
+    int i;
+
+    for (; count >= 8; count -= 8, septets += 8) {
+        for (i = 0; i < 8; i++)
+            acc |= (guint64) septets[i] << (bits + 7 * i);
+        for (i = 0; i < 7; i++) {
+            *out++ = acc & 0xff;
+            acc >>= 8;
+        }
+    }
+    for (i = 0; i < count; i++) {
+        acc |= (guint64) septets[i] << bits;
+        bits += 7;
+        if (bits >= 8) {
+            *out++ = acc & 0xff;
+            acc >>= 8;
+            bits -= 8;
+        }
+    }
+    if (bits > 0)
+        *out++ = acc & 0xff;
+
+    return out - start;
+}
+
+/*** SMS-DELIVER encoder ***/
+
+#define SMS_MAX_UD          140 // octets of user data in one PDU
+#define SMS_MAX_SEPTETS     160
+#define SMS_MAX_PARTS       255
+
+/* Concatenation UDH: IEI 0x00 (8-bit reference) or 0x08 (16-bit reference) */
+#define UDH_CONCAT8_SIZE    6   // UDHL, IEI, IEDL, ref, total, seq
+#define UDH_CONCAT16_SIZE   7   // UDHL, IEI, IEDL, ref hi, ref lo, total, seq
+
+static guint16 concatRef;
+
+/* SMSC, first octet, originating address, PID, DCS and SCTS */
+static int encodeDeliverHeader(unsigned char *pdu, const char *smsc, const char *sender,
+                               guint8 firstOctet, guint8 dcs)
 {
     int ofs = 0;
     setSemiOctet(pdu, &ofs, '0');
@@ -77,19 +318,17 @@ int encodePDU(unsigned char *pdu, const char *message, const char *smsc, const c
     setSemiOctet(pdu, &ofs, makeSemiOctet(smcSize/2 + (smcSize & 0x1) + 1)); // length (in octets)
     ofs += smcSize + (smcSize & 0x1) + 2;
 
-    setSemiOctet(pdu, &ofs, '0');
-    setSemiOctet(pdu, &ofs, '4'); // First octet of the SMS-DELIVER PDU
+    setOctet(pdu, &ofs, firstOctet); // First octet of the SMS-DELIVER PDU
 
     // Sender
     int senderSize = encodeNumber(&pdu[ofs+2], sender[0] == '+' ? &sender[1] : "0000");
     LOGD("senderSize: %d", senderSize);
     if (!senderSize) return 0;
-    setSemiOctet(pdu, &ofs, '0');
-    setSemiOctet(pdu, &ofs, makeSemiOctet(senderSize));// length
+    setOctet(pdu, &ofs, senderSize); // length (in digits)
     ofs += senderSize + (senderSize & 0x1) + 2;
 
     setOctet(pdu, &ofs, 0x00); // TP-PID
-    setOctet(pdu, &ofs, 0x08); // TP-DCS (Class Unspecified, UCS2)
+    setOctet(pdu, &ofs, dcs);  // TP-DCS (Class Unspecified, UCS2 or GSM 7-bit)
     setOctet(pdu, &ofs, 0x99); // TP-SCTS
 
     // Timestamp (whatever, don't realy care about it)
@@ -100,28 +339,377 @@ int encodePDU(unsigned char *pdu, const char *message, const char *smsc, const c
     setOctet(pdu, &ofs, 0x95);
     setOctet(pdu, &ofs, 0x80);
 
-    gsize converted;
-    char *ucs2_encoded = g_convert(message, -1, "UCS-2BE//TRANSLIT", "UTF-8",
-                                   NULL, &converted, NULL);
+    return ofs;
+}
+
+/* Bytes of text that go into the next part, not splitting escapes or surrogates */
+static int partLength(const guint8 *text, int left, int max, gboolean ucs2)
+{
+    if (left <= max)
+        return left;
+    if (ucs2)
+        return (text[max - 2] & 0xfc) == 0xd8 ? max - 2 : max;
+    return text[max - 1] == GSM_ESCAPE ? max - 1 : max;
+}
+
+int encodeDeliverPDUs(const char *message, const char *smsc, const char *sender,
+                      gboolean ref16, char ***pdus)
+{
+    // GSM 7-bit when the text fits the alphabet, UCS2 otherwise
+    guint8 *text = g_malloc(2 * strlen(message) + 1);
+    int length = utf8ToGsm(message, text);
+    gboolean ucs2 = length < 0;
+    if (ucs2)
+        length = utf8ToUcs2(message, text);
+    LOGD("%s length: %d", ucs2 ? "UCS2" : "GSM", length);
+
+    // room for the text in a single PDU and in a concatenated part
+    int udhSize = ref16 ? UDH_CONCAT16_SIZE : UDH_CONCAT8_SIZE;
+    int udhSeptets = (udhSize * 8 + 6) / 7;
+    int maxSingle = ucs2 ? SMS_MAX_UD : SMS_MAX_SEPTETS;
+    // UCS2 parts hold whole UTF-16 code units, 133 octets after a 16-bit reference don't
+    int maxPart = ucs2 ? (SMS_MAX_UD - udhSize) & ~1 : SMS_MAX_SEPTETS - udhSeptets;
+
+    // split the text first, so the PDUs can be allocated at their exact size
+    guint8 partLen[SMS_MAX_PARTS];
+    int parts = 0;
+    if (length <= maxSingle) {
+        partLen[parts++] = length;
+    } else {
+        int ofs;
+        for (ofs = 0; ofs < length; parts++) {
+            if (parts == SMS_MAX_PARTS) {
+                LOGE("message too long: %d septets/octets", length);
+                g_free(text);
+                return 0;
+            }
+            partLen[parts] = partLength(&text[ofs], length - ofs, maxPart, ucs2);
+            ofs += partLen[parts];
+        }
+    }
 
-    if (!ucs2_encoded || !converted) {
-        LOGE("!ucs2_encoded || !converted");
+    int smcDigits = smsc[0] == '+' ? strlen(&smsc[1]) : 4;
+    int senderDigits = sender[0] == '+' ? strlen(&sender[1]) : 4;
+    if (!smcDigits || !senderDigits) {
+        LOGE("empty SMSC or sender address");
+        g_free(text);
         return 0;
     }
-    LOGD("UCS2 length: %d %d", (int)converted, ofs);
 
-    // pdu encoder able to encode only to ucs2 encoding (2bytes/char),
-    // but length field stored as uint8.
-    // Cut down size of the message (better than drop it).
-    if (converted > 254)
-        converted = 254;
+    // hex digits: SMSC, first octet, sender, PID, DCS, SCTS and UDL
+    int headerSize = 2 + 2 + smcDigits + (smcDigits & 1) + 2
+                     + 2 + 2 + senderDigits + (senderDigits & 1) + 2 + 2 + 14 + 2;
+    int udhLen = parts > 1 ? udhSize : 0;
+    int fillBits = udhLen ? udhSeptets * 7 - udhLen * 8 : 0;
+    size_t size = (parts + 1) * sizeof(char *);
+    int i;
 
-    setOctet(pdu, &ofs, (guint8)converted); // TP-TP-User-Data-Length
-    const char *strPtr = ucs2_encoded;
-    while(converted-- > 0)
-        setOctet(pdu, &ofs, (guint8) *strPtr++);
+    for (i = 0; i < parts; i++) {
+        int udOctets = ucs2 ? partLen[i] : (fillBits + 7 * partLen[i] + 7) / 8;
+        size += headerSize + 2 * (udhLen + udOctets) + 1;
+    }
 
-    g_free(ucs2_encoded);
-    pdu[ofs] = 0;
-    return ofs;
+    char **result = g_malloc(size);
+    unsigned char *pdu = (unsigned char *) &result[parts + 1];
+    guint8 udh[UDH_CONCAT16_SIZE];
+    guint8 packed[SMS_MAX_UD];
+    guint16 ref = concatRef++;
+    int textOfs = 0;
+
+    for (i = 0; i < parts; i++) {
+        int len = partLen[i];
+        int ofs = encodeDeliverHeader(pdu, smsc, sender, udhLen ? 0x44 : 0x04, ucs2 ? 0x08 : 0x00);
+
+        if (udhLen) {
+            int n = 0;
+            udh[n++] = udhSize - 1;    // UDHL
+            if (ref16) {
+                udh[n++] = 0x08;
+                udh[n++] = 4;
+                udh[n++] = ref >> 8;
+            } else {
+                udh[n++] = 0x00;
+                udh[n++] = 3;
+            }
+            udh[n++] = ref & 0xff;
+            udh[n++] = parts;
+            udh[n++] = i + 1;
+        }
+
+        const guint8 *ud = &text[textOfs];
+        int udOctets = len;
+        if (ucs2) {
+            setOctet(pdu, &ofs, udhLen + len); // TP-User-Data-Length, octets
+        } else {
+            // septets are aligned on a septet boundary after the UDH
+            setOctet(pdu, &ofs, (udhLen ? udhSeptets : 0) + len); // TP-UDL, septets
+            udOctets = packSeptets(ud, len, fillBits, packed);
+            ud = packed;
+        }
+
+        setOctets(pdu, &ofs, udh, udhLen);
+        setOctets(pdu, &ofs, ud, udOctets);
+        pdu[ofs] = 0;
+
+        result[i] = (char *) pdu;
+        pdu += ofs + 1;
+        textOfs += len;
+    }
+    result[parts] = NULL;
+
+    g_free(text);
+    *pdus = result;
+    return parts;
+}
+
+/*** SMS-SUBMIT decoder ***/
+
+static inline int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+/* @return  number of octets, -1 if the string isn't hex */
+static int hexDecode(const char *hex, guint8 *out)
+{
+    int count = 0;
+
+    while (hex[0] && hex[1]) {
+        int hi = hexValue(hex[0]), lo = hexValue(hex[1]);
+        if (hi < 0 || lo < 0)
+            return -1;
+        out[count++] = hi << 4 | lo;
+        hex += 2;
+    }
+    return hex[0] ? -1 : count;
+}
+
+/* TP-DA: length in digits, type of address, swapped semi-octets */
+static int decodeAddress(const guint8 *pdu, int len, gchar *out, size_t size)
+{
+    if (len < 2)
+        return -1;
+
+    int digits = pdu[0];
+    int octets = 2 + (digits + 1) / 2;
+    if (octets > len || digits + 2 > (int) size)
+        return -1;
+    if ((pdu[1] & 0x70) == 0x50) {
+        LOGW("alphanumeric destination address");
+        return -1;
+    }
+
+    int i;
+    if ((pdu[1] & 0x70) == 0x10)
+        *out++ = '+';
+    for (i = 0; i < digits; i++) {
+        guint8 digit = i & 1 ? pdu[2 + i/2] >> 4 : pdu[2 + i/2] & 0x0f;
+        *out++ = "0123456789*#abc"[digit < 15 ? digit : 14];
+    }
+    *out = 0;
+    return octets;
+}
+
+/* Data coding scheme (3GPP 23.038 4), FALSE for compressed or reserved */
+static gboolean decodeDCS(guint8 dcs, SmsAlphabet *alphabet)
+{
+    switch (dcs >> 4) {
+        case 0x0: case 0x1: case 0x2: case 0x3:     // general data coding
+        case 0x4: case 0x5: case 0x6: case 0x7:     // ... marked for deletion
+            if (dcs & 0x20)
+                return FALSE;
+            switch ((dcs >> 2) & 0x3) {
+                case 0: *alphabet = SMS_ALPHABET_GSM; return TRUE;
+                case 1: *alphabet = SMS_ALPHABET_8BIT; return TRUE;
+                case 2: *alphabet = SMS_ALPHABET_UCS2; return TRUE;
+            }
+            return FALSE;
+        case 0xc: case 0xd:                         // message waiting, GSM
+            *alphabet = SMS_ALPHABET_GSM;
+            return TRUE;
+        case 0xe:                                   // message waiting, UCS2
+            *alphabet = SMS_ALPHABET_UCS2;
+            return TRUE;
+        case 0xf:                                   // data coding/message class
+            *alphabet = dcs & 0x04 ? SMS_ALPHABET_8BIT : SMS_ALPHABET_GSM;
+            return TRUE;
+    }
+    return FALSE;
+}
+
+static gboolean decodeUDH(const guint8 *udh, int len, SmsSubmit *submit)
+{
+    int ofs = 0;
+
+    while (ofs + 2 <= len) {
+        guint8 iei = udh[ofs], iedl = udh[ofs + 1];
+        const guint8 *ied = &udh[ofs + 2];
+        if (ofs + 2 + iedl > len)
+            return FALSE;
+
+        if (0x00 == iei && 3 == iedl && ied[1] && ied[2] && ied[2] <= ied[1]) {
+            submit->concatRef = ied[0];
+            submit->concatTotal = ied[1];
+            submit->concatSeq = ied[2];
+        } else if (0x08 == iei && 4 == iedl && ied[2] && ied[3] && ied[3] <= ied[2]) {
+            submit->concatRef = ied[0] << 8 | ied[1];
+            submit->concatTotal = ied[2];
+            submit->concatSeq = ied[3];
+        } else {
+            submit->otherHeaders = TRUE;
+        }
+        ofs += 2 + iedl;
+    }
+    return ofs == len;
+}
+
+static gunichar gsmToUnicode(guint8 septet, gboolean escaped)
+{
+    unsigned i;
+
+    if (escaped) {
+        for (i = 0; i < G_N_ELEMENTS(gsmExtension); i++)
+            if (gsmExtension[i].septet == septet)
+                return gsmExtension[i].uc;
+        // unknown extension, shown as the default character (23.038 6.2.1.1)
+    }
+    return gsmDefault[septet];
+}
+
+/* Unpack septets skip..count-1 from the user data into UTF-8 */
+static gchar *gsmToUtf8(const guint8 *ud, int count, int skip)
+{
+    GString *str = g_string_sized_new(count);
+    gboolean escaped = FALSE;
+    int i;
+
+    for (i = skip; i < count; i++) {
+        int bit = 7 * i;
+        guint16 word = ud[bit / 8];
+        if (bit % 8 > 1)
+            word |= ud[bit / 8 + 1] << 8;
+        guint8 septet = (word >> (bit % 8)) & 0x7f;
+
+        if (GSM_ESCAPE == septet && !escaped) {
+            escaped = TRUE;
+            continue;
+        }
+        g_string_append_unichar(str, gsmToUnicode(septet, escaped));
+        escaped = FALSE;
+    }
+    return g_string_free(str, FALSE);
+}
+
+gchar *ucs2ToUtf8(const guint8 *ud, int octets)
+{
+    GString *str = g_string_sized_new(octets);
+    int i;
+
+    for (i = 0; i + 1 < octets; i += 2) {
+        gunichar uc = ud[i] << 8 | ud[i + 1];
+        if (uc >= 0xd800 && uc < 0xdc00 && i + 3 < octets) {
+            gunichar lo = ud[i + 2] << 8 | ud[i + 3];
+            if (lo >= 0xdc00 && lo < 0xe000) {
+                uc = 0x10000 + ((uc - 0xd800) << 10) + (lo - 0xdc00);
+                i += 2;
+            }
+        }
+        if (uc >= 0xd800 && uc < 0xe000)
+            uc = 0xfffd;
+        g_string_append_unichar(str, uc);
+    }
+    return g_string_free(str, FALSE);
+}
+
+gboolean decodeSubmitPDU(const char *hex, SmsSubmit *submit)
+{
+    size_t hexLen = strlen(hex);
+    guint8 *pdu = g_malloc(hexLen / 2 + 1);
+    int len = hexDecode(hex, pdu);
+    int ofs = 0;
+
+    memset(submit, 0, sizeof(*submit));
+    if (len < 7)
+        goto malformed;
+
+    guint8 firstOctet = pdu[ofs++];
+    if ((firstOctet & 0x03) != 0x01) {
+        LOGW("not an SMS-SUBMIT: %02x", firstOctet);
+        goto malformed;
+    }
+    submit->statusReport = (firstOctet & 0x20) != 0;
+    submit->messageRef = pdu[ofs++];
+
+    int addrLen = decodeAddress(&pdu[ofs], len - ofs, submit->destination,
+                                sizeof(submit->destination));
+    if (addrLen < 0)
+        goto malformed;
+    ofs += addrLen;
+
+    if (ofs + 1 >= len)
+        goto malformed;
+    submit->pid = pdu[ofs++];
+    submit->dcs = pdu[ofs++];
+    if (!decodeDCS(submit->dcs, &submit->alphabet)) {
+        // compressed or reserved, passed on as opaque data
+        LOGW("unsupported data coding scheme %02x", submit->dcs);
+        submit->alphabet = SMS_ALPHABET_8BIT;
+    }
+
+    submit->validityPeriod = (firstOctet & 0x18) != 0;
+    switch ((firstOctet >> 3) & 0x03) {     // TP-VPF
+        case 0x2: ofs += 1; break;          // relative
+        case 0x1:                           // enhanced
+        case 0x3: ofs += 7; break;          // absolute
+    }
+    if (ofs >= len)
+        goto malformed;
+
+    int udl = pdu[ofs++];
+    const guint8 *ud = &pdu[ofs];
+    int udOctets = SMS_ALPHABET_GSM == submit->alphabet ? (udl * 7 + 7) / 8 : udl;
+    if (udOctets > len - ofs || udOctets > SMS_MAX_UD)
+        goto malformed;
+
+    int udhLen = 0;
+    if (firstOctet & 0x40) {                // TP-UDHI
+        udhLen = 1 + (udOctets ? ud[0] : 0);
+        if (udhLen > udOctets || !decodeUDH(&ud[1], udhLen - 1, submit))
+            goto malformed;
+    }
+
+    switch (submit->alphabet) {
+        case SMS_ALPHABET_GSM:
+            submit->text = gsmToUtf8(ud, udl, (udhLen * 8 + 6) / 7);
+            break;
+        case SMS_ALPHABET_UCS2:
+            // converted once the parts are joined, they may split a character
+            submit->ucs2Octets = udOctets - udhLen;
+            submit->ucs2 = g_memdup(&ud[udhLen], submit->ucs2Octets);
+            break;
+        case SMS_ALPHABET_8BIT:
+            break;
+    }
+
+    g_free(pdu);
+    return TRUE;
+
+malformed:
+    g_free(pdu);
+    return FALSE;
+}
+
+void smsSubmitClear(SmsSubmit *submit)
+{
+    g_free(submit->text);
+    g_free(submit->ucs2);
+    submit->text = NULL;
+    submit->ucs2 = NULL;
+    submit->ucs2Octets = 0;
 }
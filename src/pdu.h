@@ -0,0 +1,78 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef __PDU_H
+#define __PDU_H
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * SMS PDUs in the hex form the framework uses (3GPP 23.040)
+ */
+
+typedef enum {
+    SMS_ALPHABET_GSM = 0,       // default 7-bit alphabet
+    SMS_ALPHABET_8BIT,
+    SMS_ALPHABET_UCS2,
+} SmsAlphabet;
+
+typedef struct {
+    guint8      messageRef;     // TP-MR
+    gboolean    statusReport;   // TP-SRR
+    gchar       destination[24];// '+' and digits for international numbers
+    guint8      pid;            // TP-PID
+    guint8      dcs;            // TP-DCS
+    gboolean    validityPeriod; // TP-VP present
+    SmsAlphabet alphabet;
+    guint16     concatRef;      // concatenated message reference
+    guint8      concatTotal;    // parts of the concatenated message, 0 if not one
+    guint8      concatSeq;      // this part, from 1
+    gboolean    otherHeaders;   // UDH elements besides concatenation
+    gchar       *text;          // UTF-8 of GSM 7-bit data, NULL otherwise
+    guint8      *ucs2;          // UCS2 data as it is, without the UDH
+    int         ucs2Octets;
+} SmsSubmit;
+
+/*
+ * Encode a received message as SMS-DELIVER PDUs. Text that doesn't fit
+ * a single PDU becomes a concatenated series, with an 8-bit or 16-bit
+ * reference.
+ *
+ * @pdus    set to a NULL-terminated array of the PDUs, the strings live in
+ *          the same allocation; release with g_free()
+ * @return  number of PDUs, 0 on error
+ */
+int encodeDeliverPDUs(const char *message, const char *smsc, const char *sender,
+                      gboolean ref16, char ***pdus);
+
+/* Decode an SMS-SUBMIT PDU, FALSE if it's malformed; release with smsSubmitClear() */
+gboolean decodeSubmitPDU(const char *hex, SmsSubmit *submit);
+
+void smsSubmitClear(SmsSubmit *submit);
+
+/* UTF-16BE into UTF-8, unpaired surrogates become U+FFFD; release with g_free() */
+gchar *ucs2ToUtf8(const guint8 *ud, int octets);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __PDU_H
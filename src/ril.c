@@ -20,6 +20,7 @@
 
 #include <telephony/ril.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
 #include <string.h>
 #include <errno.h>
@@ -43,13 +44,19 @@
 
 #define LOG_TAG "RIL"
 #include <utils/Log.h>
+#include "logging.h"
 
 #include <glib/gthread.h>
 #include <dbus/dbus-glib.h>
+#include <dbus/dbus-glib-lowlevel.h>
 #include <dbus/dbus-gobject.h>
 
 #include "marshaller.h"
 #include "cmtaudio.h"
+#include "identity.h"
+#include "pdu.h"
+#include "stats.h"
+#include "trace.h"
 
 #define G_VALUE_INITIALIZATOR {0,{{0}, {0}} }
 
@@ -62,8 +69,6 @@ typedef enum {
     SIM_NETWORK_PERSONALIZATION = 5
 } SIM_Status;
 
-static GHashTable* iface_get_properties(DBusGProxy *proxy);
-
 static void onRequest (int request, void *data, size_t datalen, RIL_Token t);
 static RIL_RadioState currentState();
 static int onSupports (int requestCode);
@@ -85,13 +90,15 @@ static const RIL_RadioFunctions s_callbacks = {
     getVersion
 };
 
+/* GSM allows 7 calls in a multiparty call plus one waiting call */
+#define MAX_CALLS 8
+
 typedef struct {
     DBusGProxy      *obj;
     RIL_Call        rilCall;
-    RIL_Call        *rilCallPtr;
     char            number[30];
     char            name[30];
-    char            objPath[50];
+    char            objPath[50];    // empty for a free slot
 } ORIL_Call;
 
 static const gchar EMPTY[] = "";
@@ -115,14 +122,14 @@ static const gchar OFONO_SIGNAL_INCOMING_MESSAGE[] = "IncomingMessage";
 static const gchar OFONO_SIGNAL_CALL_ADDED[] = "CallAdded";
 static const gchar OFONO_SIGNAL_CALL_REMOVED[] = "CallRemoved";
 static const gchar OFONO_SIGNAL_REQUEST_RECEIVED[] = "RequestReceived";
+static const gchar OFONO_SIGNAL_MODEM_ADDED[] = "ModemAdded";
 
-static GSList *voiceCalls;
+static ORIL_Call voiceCalls[MAX_CALLS]; // protected by lock, see callsSnapshot()
 static GMainLoop *loop;
 static DBusGConnection *connection;
 static GType type_a_oa_sv, type_oa_sv, type_a_sv;
 static DBusGProxy *manager, *modem, *vcm, *sim, *netreg, *radiosettings;
 static DBusGProxy *sms, *connman, *pdc, *supsrv, *audioSettings;
-static int goingOnline = 0;
 static gboolean screenState = TRUE;
 static int lastCallFailCause;
 static char simIMSI[16], modemIMEI[16], modemRev[50];
@@ -142,14 +149,30 @@ static char ipDataCall[16];
 static const char gprsIfName[] = "gprs0";
 // we always use only one context for PDC: primarycontext1
 static const char *responseDataCall[3] = { "1", gprsIfName, ipDataCall };
-static RIL_Token dataCallToken, poweredToken, imeiToken, modemRevToken;
+static RIL_Token dataCallToken, imeiToken, modemRevToken;
 static gboolean pdcActive = FALSE;
 static gboolean roamingAllowed = FALSE;
 
 static const struct RIL_Env *s_rilenv;
 
-#define RIL_onRequestComplete(t, e, response, responselen) s_rilenv->OnRequestComplete(t,e, response, responselen)
-#define RIL_onUnsolicitedResponse(a,b,c) s_rilenv->OnUnsolicitedResponse(a,b,c)
+/* Event trace, see trace.h */
+#define TRACE_PATH      "/data/radio/ofono-ril.trace" // -t option
+#define TRACE_RECORDS   16384
+
+/* Modem identity cache, see identity.h */
+#define IDENTITY_PATH   "/data/radio/ofono-ril.identity"
+
+#define RIL_onRequestComplete(t, e, response, responselen) \
+    do { \
+        traceEvent(TRACE_REQUEST_END, statsRequestOf(t), e, (uintptr_t) (t)); \
+        statsRequestEnd(t, e); \
+        s_rilenv->OnRequestComplete(t,e, response, responselen); \
+    } while (0)
+#define RIL_onUnsolicitedResponse(a,b,c) \
+    do { \
+        traceEvent(TRACE_UNSOLICITED, a, 0, 0); \
+        s_rilenv->OnUnsolicitedResponse(a,b,c); \
+    } while (0)
 #define RIL_requestTimedCallback(a,b,c) s_rilenv->RequestTimedCallback(a,b,c)
 
 static RIL_RadioState sState = RADIO_STATE_UNAVAILABLE;
@@ -167,22 +190,144 @@ static const struct timeval TIMEVAL_0 = {0,0};
 
 static void pollSIMState (void *param);
 static void setRadioState(RIL_RadioState newState);
+static void requestRadioPower(void *data, size_t datalen, RIL_Token t);
 
 static void hash_entry_gvalue_print(const gchar *key, GValue *val, gpointer userdata)
 {
-    char *str = g_strdup_value_contents(val);
-    LOGD("[\"%s\"] = %s", key, str);
-    free(str);
+    if (RIL_LOGD_ENABLED) {
+        char *str = g_strdup_value_contents(val);
+        LOGD("[\"%s\"] = %s", key, str);
+        g_free(str);
+    }
+}
+
+/*** ofono string dispatch ***/
+
+/*
+ * Property names and enumerated values we act upon, decoded with a single
+ * hash lookup instead of g_strcmp0 chains. Property names are capitalized
+ * and values are lower case, so both share one table.
+ */
+typedef enum {
+    OFONO_UNKNOWN = 0,
+
+    /* NetworkRegistration properties */
+    OFONO_PROP_STRENGTH,
+    OFONO_PROP_BASE_STATION,
+    OFONO_PROP_CELL_ID,
+    OFONO_PROP_LAC,
+    OFONO_PROP_STATUS,
+    OFONO_PROP_NAME,
+    OFONO_PROP_MNC,
+    OFONO_PROP_MCC,
+    OFONO_PROP_TECHNOLOGY,
+    OFONO_PROP_MODE,
+
+    /* Modem properties */
+    OFONO_PROP_ONLINE,
+    OFONO_PROP_INTERFACES,
+    OFONO_PROP_POWERED,
+    OFONO_PROP_SERIAL,
+    OFONO_PROP_REVISION,
+    OFONO_PROP_FEATURES,
+
+    /* VoiceCall properties */
+    OFONO_PROP_STATE,
+
+    /* VoiceCall.State */
+    OFONO_CALL_ACTIVE,
+    OFONO_CALL_HELD,
+    OFONO_CALL_DIALING,
+    OFONO_CALL_ALERTING,
+    OFONO_CALL_INCOMING,
+    OFONO_CALL_WAITING,
+
+    /* NetworkRegistration.Status */
+    OFONO_STATUS_SEARCHING,
+    OFONO_STATUS_REGISTERED,
+    OFONO_STATUS_ROAMING,
+
+    /* NetworkRegistration.Technology */
+    OFONO_TECH_GSM,
+    OFONO_TECH_EDGE,
+    OFONO_TECH_UMTS,
+    OFONO_TECH_HSPA,
+    OFONO_TECH_LTE,
+
+    /* NetworkRegistration.Mode */
+    OFONO_MODE_AUTO,
+    OFONO_MODE_MANUAL,
+} OfonoString;
+
+static const struct {
+    const char  *str;
+    OfonoString id;
+} ofonoStrings[] = {
+    { "Strength",           OFONO_PROP_STRENGTH },
+    { "BaseStation",        OFONO_PROP_BASE_STATION },
+    { "CellId",             OFONO_PROP_CELL_ID },
+    { "LocationAreaCode",   OFONO_PROP_LAC },
+    { "Status",             OFONO_PROP_STATUS },
+    { "Name",               OFONO_PROP_NAME },
+    { "MobileNetworkCode",  OFONO_PROP_MNC },
+    { "MobileCountryCode",  OFONO_PROP_MCC },
+    { "Technology",         OFONO_PROP_TECHNOLOGY },
+    { "Mode",               OFONO_PROP_MODE },
+    { "Online",             OFONO_PROP_ONLINE },
+    { "Interfaces",         OFONO_PROP_INTERFACES },
+    { "Powered",            OFONO_PROP_POWERED },
+    { "Serial",             OFONO_PROP_SERIAL },
+    { "Revision",           OFONO_PROP_REVISION },
+    { "Features",           OFONO_PROP_FEATURES },
+    { "State",              OFONO_PROP_STATE },
+    { "active",             OFONO_CALL_ACTIVE },
+    { "held",               OFONO_CALL_HELD },
+    { "dialing",            OFONO_CALL_DIALING },
+    { "alerting",           OFONO_CALL_ALERTING },
+    { "incoming",           OFONO_CALL_INCOMING },
+    { "waiting",            OFONO_CALL_WAITING },
+    { "searching",          OFONO_STATUS_SEARCHING },
+    { "registered",         OFONO_STATUS_REGISTERED },
+    { "roaming",            OFONO_STATUS_ROAMING },
+    { "gsm",                OFONO_TECH_GSM },
+    { "edge",               OFONO_TECH_EDGE },
+    { "umts",               OFONO_TECH_UMTS },
+    { "hspa",               OFONO_TECH_HSPA },
+    { "lte",                OFONO_TECH_LTE },
+    { "auto",               OFONO_MODE_AUTO },
+    { "manual",             OFONO_MODE_MANUAL },
+};
+
+// built once by RIL_Init, read-only afterwards so lookups need no locking
+static GHashTable *ofonoStringTable;
+
+static void ofonoStringsInit()
+{
+    unsigned i;
+    ofonoStringTable = g_hash_table_new(g_str_hash, g_str_equal);
+    for (i = 0; i < sizeof(ofonoStrings)/sizeof(ofonoStrings[0]); i++)
+        g_hash_table_insert(ofonoStringTable, (gpointer) ofonoStrings[i].str,
+                            GINT_TO_POINTER(ofonoStrings[i].id));
+}
+
+static OfonoString ofonoString(const gchar *str)
+{
+    if (!str)
+        return OFONO_UNKNOWN;
+    return (OfonoString) GPOINTER_TO_INT(g_hash_table_lookup(ofonoStringTable, str));
 }
 
 static RIL_CallState ofonoStateToRILState(const gchar *state)
 {
-    if (!g_strcmp0(state, "active")) return RIL_CALL_ACTIVE;
-    if (!g_strcmp0(state, "held")) return RIL_CALL_HOLDING;
-    if (!g_strcmp0(state, "dialing")) return RIL_CALL_DIALING;
-    if (!g_strcmp0(state, "alerting")) return RIL_CALL_ALERTING;
-    if (!g_strcmp0(state, "incoming")) return RIL_CALL_INCOMING;
-    if (!g_strcmp0(state, "waiting")) return RIL_CALL_WAITING;
+    switch (ofonoString(state)) {
+        case OFONO_CALL_ACTIVE:     return RIL_CALL_ACTIVE;
+        case OFONO_CALL_HELD:       return RIL_CALL_HOLDING;
+        case OFONO_CALL_DIALING:    return RIL_CALL_DIALING;
+        case OFONO_CALL_ALERTING:   return RIL_CALL_ALERTING;
+        case OFONO_CALL_INCOMING:   return RIL_CALL_INCOMING;
+        case OFONO_CALL_WAITING:    return RIL_CALL_WAITING;
+        default:                    break;
+    }
 
     LOGE("Bad callstate: %s", state);
     return (RIL_CallState) 0xffffffff;
@@ -207,54 +352,449 @@ static void onSIMReady()
 #endif
 }
 
-static int objSetProperty(DBusGProxy *obj, const gchar *prop, GValue *value)
+/*** Asynchronous ofono requests ***/
+
+/*
+ * Requests to ofono never block the RIL request thread: onRequest only
+ * collects the arguments, the call is started from the main loop thread
+ * (dbus-glib proxies aren't thread safe) and the RIL_Token is completed
+ * from the reply callback, also on the main loop thread.
+ */
+
+typedef struct _OfonoRequest OfonoRequest;
+
+/* Called on the main loop thread, must call dbus_g_proxy_end_call() */
+typedef void (*OfonoReplyFunc)(OfonoRequest *req, DBusGProxyCall *call);
+
+struct _OfonoRequest {
+    DBusGProxy      *proxy;
+    const char      *method;
+    int             timeout;    // ms, -1 for the proxy default
+    GValueArray     *args;
+    OfonoReplyFunc  reply;
+    RIL_Token       t;          // cleared once completed
+    RIL_Errno       failure;    // reported by ofonoReplyNoResult on error
+    GType           resultType; // out argument ignored by ofonoReplyNoResult
+    int             statsRequest; // RIL request the call is made for, 0 if none
+    gpointer        data;
+    GDestroyNotify  dataFree;   // called for data when the request is freed
+};
+
+static OfonoRequest *ofonoRequestNew(DBusGProxy *proxy, const char *method,
+                                     OfonoReplyFunc reply, RIL_Token t)
+{
+    OfonoRequest *req = g_new0(OfonoRequest, 1);
+    req->proxy = g_object_ref(proxy);
+    req->method = method;
+    req->timeout = -1;
+    req->args = g_value_array_new(2);
+    req->reply = reply;
+    req->t = t;
+    req->failure = RIL_E_GENERIC_FAILURE;
+    req->resultType = G_TYPE_INVALID;
+    req->statsRequest = statsRequestOf(t);
+    return req;
+}
+
+static void ofonoRequestAddString(OfonoRequest *req, const gchar *str)
+{
+    GValue value = G_VALUE_INITIALIZATOR;
+    g_value_init(&value, G_TYPE_STRING);
+    g_value_set_string(&value, str);
+    g_value_array_append(req->args, &value);
+    g_value_unset(&value);
+}
+
+/* append a variant argument */
+static void ofonoRequestAddValue(OfonoRequest *req, const GValue *variant)
+{
+    GValue value = G_VALUE_INITIALIZATOR;
+    g_value_init(&value, G_TYPE_VALUE);
+    g_value_set_boxed(&value, variant);
+    g_value_array_append(req->args, &value);
+    g_value_unset(&value);
+}
+
+static void ofonoRequestComplete(OfonoRequest *req, RIL_Errno e,
+                                 void *response, size_t responselen)
+{
+    if (req->t) {
+        RIL_onRequestComplete(req->t, e, response, responselen);
+        req->t = 0;
+    }
+}
+
+static void ofonoRequestFree(gpointer data)
+{
+    OfonoRequest *req = (OfonoRequest *) data;
+
+    // pending call was cancelled (proxy destroyed) before ofono replied
+    if (req->t) {
+        LOGW("%s: cancelled, no reply from ofono", req->method);
+        ofonoRequestComplete(req, RIL_E_GENERIC_FAILURE, NULL, 0);
+    }
+
+    if (req->dataFree)
+        req->dataFree(req->data);
+    g_value_array_free(req->args);
+    g_object_unref(req->proxy);
+    g_free(req);
+}
+
+static void ofonoRequestNotify(DBusGProxy *proxy, DBusGProxyCall *call,
+                               void *user_data)
+{
+    OfonoRequest *req = (OfonoRequest *) user_data;
+    traceEvent(TRACE_DBUS_END, req->statsRequest, 0, (uintptr_t) req);
+    req->reply(req, call);
+}
+
+static gboolean ofonoRequestStart(gpointer data)
+{
+    OfonoRequest *req = (OfonoRequest *) data;
+
+    statsDBusCall(req->statsRequest);
+    traceEvent(TRACE_DBUS_BEGIN, req->statsRequest, 0, (uintptr_t) req);
+    if (!dbus_g_proxy_begin_call_value_array(req->proxy, req->method,
+                                             ofonoRequestNotify, req,
+                                             ofonoRequestFree,
+                                             req->timeout, req->args))
+    {
+        LOGE("%s: can't send request to ofono", req->method);
+        ofonoRequestFree(req);
+    }
+    return FALSE;
+}
+
+/* Hand the request over to the main loop thread, may be called from any thread */
+static void ofonoRequestSend(OfonoRequest *req)
+{
+    g_idle_add_full(G_PRIORITY_DEFAULT, ofonoRequestStart, req, NULL);
+}
+
+/* Reply handler for methods without meaningful out arguments */
+static void ofonoReplyNoResult(OfonoRequest *req, DBusGProxyCall *call)
 {
     GError *error = NULL;
-    if (obj) {
-        if ( !dbus_g_proxy_call(obj, "SetProperty", &error,
-                                G_TYPE_STRING, prop,
-                                G_TYPE_VALUE, value,
-                                G_TYPE_INVALID,
-                                G_TYPE_INVALID) )
-        {
-            LOGE("%s->SetProperty(%s) to %p failed: %s",
-                 dbus_g_proxy_get_bus_name(obj),
-                 prop, value, error->message);
-        }
+    RIL_Errno res = RIL_E_SUCCESS;
+
+    if (!dbus_g_proxy_end_call(req->proxy, call, &error,
+                               req->resultType, NULL, G_TYPE_INVALID))
+    {
+        LOGE("%s.%s failed: %s", dbus_g_proxy_get_interface(req->proxy),
+             req->method, error->message);
+        g_error_free(error);
+        res = req->failure;
     }
-    return error != NULL;
+    ofonoRequestComplete(req, res, NULL, 0);
 }
 
-/* Toggle radio on and off (for "airplane" mode) */
-static void requestRadioPower(void *data, size_t datalen, RIL_Token t)
+/* Build SetProperty request, it's up to the caller to send it */
+static OfonoRequest *objSetPropertyRequest(DBusGProxy *obj, const gchar *prop,
+                                           GValue *value, RIL_Token t)
 {
-    int onOff;
-    int err;
+    OfonoRequest *req = ofonoRequestNew(obj, "SetProperty", ofonoReplyNoResult, t);
+    ofonoRequestAddString(req, prop);
+    ofonoRequestAddValue(req, value);
+    return req;
+}
 
-    assert (datalen >= sizeof(int *));
-    onOff = ((int *)data)[0];
-    LOGD("requestRadioPower: %d", onOff);
+static void objSetProperty(DBusGProxy *obj, const gchar *prop, GValue *value)
+{
+    if (obj)
+        ofonoRequestSend(objSetPropertyRequest(obj, prop, value, 0));
+}
 
-    GValue value = G_VALUE_INITIALIZATOR;
-    g_value_init(&value, G_TYPE_BOOLEAN);
-    if (onOff == 0 /*&& sState != RADIO_STATE_OFF*/) {
-        g_value_set_boolean(&value, FALSE);
-        objSetProperty(modem, "Powered", &value);
-        setRadioState(RADIO_STATE_OFF);
-        RIL_onRequestComplete(t, RIL_E_SUCCESS, NULL, 0);
-    } else if (onOff > 0 /*&& sState == RADIO_STATE_OFF*/) {
+/*** ofono property mirror ***/
+
+/*
+ * Every interface proxy carries a copy of the ofono object properties.
+ * It is seeded with a single GetProperties call when the proxy is created
+ * and then kept current from PropertyChanged, so getters never go to ofono.
+ * Updated on the main loop thread, read from the request thread.
+ *
+ * The seeded values are also passed to the interface handler, as if each
+ * had just changed, so the initial state takes effect without a round
+ * trip per property. Interfaces appearing together are seeded together:
+ * their GetProperties calls are all in flight at once.
+ *
+ * An interface that goes away (the modem went offline, ofono restarted)
+ * keeps its proxy and its mirror holds the last known values, like the
+ * state the handlers derived from them. When it's back it is seeded
+ * again and only values differing from the mirror are passed on, so the
+ * framework hears of what actually changed meanwhile.
+ */
 
-        // dirty hack to exit from airplane mode
-        // relies on init.<device>.rc ability restart ofono
-        // after rild process was crashed
-        static int wasPowered = 0;
-        if (wasPowered++)
-            exit(0);
+/* PropertyChanged handler, may unset value */
+typedef void (*PropertyHandler)(DBusGProxy *proxy, const gchar *property,
+                                GValue *value, gpointer userData);
 
-        g_value_set_boolean(&value, TRUE);
-        objSetProperty(modem, "Powered", &value);
-        poweredToken = t;
+static const char PROPERTIES_KEY[] = "ofono-properties";
+static const char HANDLER_KEY[] = "ofono-property-handler";
+static pthread_mutex_t propertiesLock = PTHREAD_MUTEX_INITIALIZER;
+static int seedsPending;    // GetProperties in flight, main loop thread only
+
+static GValue *gvalueDup(const GValue *src)
+{
+    GValue *value = g_new0(GValue, 1);
+    g_value_init(value, G_VALUE_TYPE(src));
+    g_value_copy(src, value);
+    return value;
+}
+
+static void gvalueFree(gpointer data)
+{
+    GValue *value = (GValue *) data;
+    g_value_unset(value);
+    g_free(value);
+}
+
+static void propertiesStore(gpointer key, gpointer value, gpointer table)
+{
+    g_hash_table_replace((GHashTable *) table, g_strdup((const gchar *) key),
+                         gvalueDup((const GValue *) value));
+}
+
+static void propertiesSet(DBusGProxy *proxy, const gchar *name, const GValue *value)
+{
+    pthread_mutex_lock(&propertiesLock);
+    GHashTable *table = g_object_get_data(G_OBJECT(proxy), PROPERTIES_KEY);
+    if (table && G_IS_VALUE(value))
+        propertiesStore((gpointer) name, (gpointer) value, table);
+    pthread_mutex_unlock(&propertiesLock);
+}
+
+/* For the types ofono properties come in, anything else counts as changed */
+static gboolean gvalueEqual(const GValue *a, const GValue *b)
+{
+    if (G_VALUE_TYPE(a) != G_VALUE_TYPE(b))
+        return FALSE;
+
+    switch (G_TYPE_FUNDAMENTAL(G_VALUE_TYPE(a))) {
+        case G_TYPE_BOOLEAN:
+            return g_value_get_boolean(a) == g_value_get_boolean(b);
+        case G_TYPE_UCHAR:
+            return g_value_get_uchar(a) == g_value_get_uchar(b);
+        case G_TYPE_INT:
+            return g_value_get_int(a) == g_value_get_int(b);
+        case G_TYPE_UINT:
+            return g_value_get_uint(a) == g_value_get_uint(b);
+        case G_TYPE_INT64:
+            return g_value_get_int64(a) == g_value_get_int64(b);
+        case G_TYPE_UINT64:
+            return g_value_get_uint64(a) == g_value_get_uint64(b);
+        case G_TYPE_DOUBLE:
+            return g_value_get_double(a) == g_value_get_double(b);
+        case G_TYPE_STRING:
+            return !g_strcmp0(g_value_get_string(a), g_value_get_string(b));
+        case G_TYPE_BOXED:
+            if (G_VALUE_HOLDS(a, DBUS_TYPE_G_OBJECT_PATH))
+                return !g_strcmp0(g_value_get_boxed(a), g_value_get_boxed(b));
+            if (G_VALUE_HOLDS(a, G_TYPE_STRV)) {
+                gchar **sa = g_value_get_boxed(a), **sb = g_value_get_boxed(b);
+                if (!sa || !sb)
+                    return sa == sb;
+                for (; *sa && *sb; sa++, sb++)
+                    if (strcmp(*sa, *sb))
+                        return FALSE;
+                return !*sa && !*sb;
+            }
+            break;
+    }
+    return FALSE;
+}
+
+typedef struct {
+    GHashTable *table;      // the mirror
+    GSList *changed;        // keys of dict, values differing from the mirror
+} PropertiesDiff;
+
+static void propertiesCompare(gpointer key, gpointer value, gpointer data)
+{
+    PropertiesDiff *diff = (PropertiesDiff *) data;
+    GValue *stored = g_hash_table_lookup(diff->table, key);
+
+    if (!stored || !gvalueEqual(stored, (const GValue *) value)) {
+        diff->changed = g_slist_prepend(diff->changed, key);
+        propertiesStore(key, value, diff->table);
+    }
+}
+
+static gboolean propertiesMissing(gpointer key, gpointer value, gpointer dict)
+{
+    return !g_hash_table_lookup((GHashTable *) dict, key);
+}
+
+static void propertiesSeedDispatch(gpointer key, gpointer value, gpointer data)
+{
+    OfonoRequest *req = (OfonoRequest *) data;
+    GValue *copy = gvalueDup((const GValue *) value);
+
+    ((PropertyHandler) req->data)(req->proxy, (const gchar *) key, copy, req->proxy);
+    if (G_IS_VALUE(copy))
+        g_value_unset(copy);
+    g_free(copy);
+}
+
+static void propertiesApply(OfonoRequest *req, DBusGProxyCall *call)
+{
+    GError *error = NULL;
+    GHashTable *dict = 0;
+
+    if (!dbus_g_proxy_end_call(req->proxy, call, &error,
+                               type_a_sv, &dict,
+                               G_TYPE_INVALID))
+    {
+        LOGE("%s.GetProperties failed: %s",
+             dbus_g_proxy_get_interface(req->proxy), error->message);
+        g_error_free(error);
+        return;
+    }
+
+    PropertiesDiff diff = { NULL, NULL };
+    GSList *l;
+
+    pthread_mutex_lock(&propertiesLock);
+    diff.table = g_object_get_data(G_OBJECT(req->proxy), PROPERTIES_KEY);
+    if (diff.table) {
+        g_hash_table_foreach(dict, propertiesCompare, &diff);
+        g_hash_table_foreach_remove(diff.table, propertiesMissing, dict);
+    }
+    pthread_mutex_unlock(&propertiesLock);
+
+    // outside the lock, handlers may read the mirror
+    if (req->data)
+        for (l = diff.changed; l; l = l->next)
+            propertiesSeedDispatch(l->data, g_hash_table_lookup(dict, l->data), req);
+
+    g_slist_free(diff.changed);
+    g_hash_table_destroy(dict);
+}
+
+/* dataFree of a first seed, also runs if it's dropped without a reply */
+static void propertiesSeedDone(gpointer handler)
+{
+    if (!--seedsPending)
+        statsPhase(STATS_PHASE_SYNCED);
+}
+
+/* Account a signal handler run in the statistics and the trace */
+static void signalHandled(StatsSignal signal, uint64_t start)
+{
+    uint64_t now = statsNow();
+
+    statsSignal(signal, start);
+    traceRecord(TRACE_SIGNAL, start, signal, 0, now - start);
+}
+
+static uint64_t propertiesChangedStart; // main loop thread only
+
+static void propertiesChanged(DBusGProxy *proxy, const gchar *property,
+                              GValue *value, gpointer user_data)
+{
+    propertiesChangedStart = statsNow();
+    propertiesSet(proxy, property, value);
+}
+
+/* Connected after the interface handler, user_data is the StatsSignal */
+static void propertiesChangedDone(DBusGProxy *proxy, const gchar *property,
+                                  GValue *value, gpointer user_data)
+{
+    signalHandled((StatsSignal) GPOINTER_TO_INT(user_data), propertiesChangedStart);
+}
+
+/**
+ * Subscribe to PropertyChanged of the ofono object behind proxy
+ *
+ * @proxy    interface proxy, gets its own property mirror
+ * @handler  PropertyChanged handler (a PropertyHandler), called with proxy
+ *           as user data, also for the seeded properties
+ * @signal   statistics slot timing the mirror and handler
+ */
+static void watchProperties(DBusGProxy *proxy, GCallback handler, StatsSignal signal)
+{
+    g_object_set_data_full(G_OBJECT(proxy), PROPERTIES_KEY,
+                           g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                 g_free, gvalueFree),
+                           (GDestroyNotify) g_hash_table_destroy);
+    g_object_set_data(G_OBJECT(proxy), HANDLER_KEY, (gpointer) handler);
+
+    // signal PropertyChanged(string property, variant value)
+    dbus_g_proxy_add_signal(proxy, OFONO_SIGNAL_PROPERTY_CHANGED,
+                            G_TYPE_STRING, G_TYPE_VALUE, G_TYPE_INVALID);
+    // the mirror is connected first, handlers are free to unset the value
+    dbus_g_proxy_connect_signal(proxy, OFONO_SIGNAL_PROPERTY_CHANGED,
+                                G_CALLBACK(propertiesChanged), NULL, NULL);
+    if (handler)
+        dbus_g_proxy_connect_signal(proxy, OFONO_SIGNAL_PROPERTY_CHANGED,
+                                    handler, proxy, NULL);
+    dbus_g_proxy_connect_signal(proxy, OFONO_SIGNAL_PROPERTY_CHANGED,
+                                G_CALLBACK(propertiesChangedDone),
+                                GINT_TO_POINTER(signal), NULL);
+
+    // on the main loop thread already, so the call goes out right away
+    OfonoRequest *req = ofonoRequestNew(proxy, "GetProperties", propertiesApply, 0);
+    req->data = (gpointer) handler;
+    req->dataFree = propertiesSeedDone;
+    seedsPending++;
+    ofonoRequestStart(req);
+}
+
+/* Undo watchProperties, the mirror stays until the proxy is finalized */
+static void unwatchProperties(DBusGProxy *proxy, GCallback handler, StatsSignal signal)
+{
+    dbus_g_proxy_disconnect_signal(proxy, OFONO_SIGNAL_PROPERTY_CHANGED,
+                                   G_CALLBACK(propertiesChanged), NULL);
+    if (handler)
+        dbus_g_proxy_disconnect_signal(proxy, OFONO_SIGNAL_PROPERTY_CHANGED,
+                                       handler, proxy);
+    dbus_g_proxy_disconnect_signal(proxy, OFONO_SIGNAL_PROPERTY_CHANGED,
+                                   G_CALLBACK(propertiesChangedDone),
+                                   GINT_TO_POINTER(signal));
+}
+
+/* Drop the mirror, the next seed passes on every property */
+static void propertiesForget(DBusGProxy *proxy)
+{
+    pthread_mutex_lock(&propertiesLock);
+    GHashTable *table = g_object_get_data(G_OBJECT(proxy), PROPERTIES_KEY);
+    if (table)
+        g_hash_table_remove_all(table);
+    pthread_mutex_unlock(&propertiesLock);
+}
+
+/* The ofono object behind a watched proxy is back, fetch it again */
+static void propertiesReseed(DBusGProxy *proxy)
+{
+    OfonoRequest *req = ofonoRequestNew(proxy, "GetProperties", propertiesApply, 0);
+    req->data = g_object_get_data(G_OBJECT(proxy), HANDLER_KEY);
+    ofonoRequestStart(req);
+}
+
+/**
+ * Copy a property from the mirror
+ *
+ * @value  uninitialized GValue, must be unset by the caller on success
+ * @return FALSE if the property isn't known (yet)
+ */
+static gboolean getProperty(DBusGProxy *proxy, const gchar *name, GValue *value)
+{
+    gboolean found = FALSE;
+
+    if (!proxy)
+        return FALSE;
+
+    pthread_mutex_lock(&propertiesLock);
+    GHashTable *table = g_object_get_data(G_OBJECT(proxy), PROPERTIES_KEY);
+    GValue *stored = table ? (GValue *) g_hash_table_lookup(table, name) : NULL;
+    if (stored) {
+        g_value_init(value, G_VALUE_TYPE(stored));
+        g_value_copy(stored, value);
+        found = TRUE;
     }
+    pthread_mutex_unlock(&propertiesLock);
+
+    return found;
 }
 
 static void requestDataCallList(RIL_Token *t)
@@ -273,35 +813,27 @@ static void requestQueryNetworkSelectionMode(
     RIL_onRequestComplete(t, RIL_E_SUCCESS, &netregMode, sizeof(int));
 }
 
-static void requestQueryAvailableNetworks(
-    void * data, size_t datalen, RIL_Token t)
+static void queryAvailableNetworksReply(OfonoRequest *req, DBusGProxyCall *call)
 {
     GError *error = NULL;
     unsigned int i=0;
     GHashTable* opParams;
-    DBusGProxy * proxy;
-
-    if (!netreg) {
-        LOGE("Netreg proxy doesn't exist");
-        RIL_onRequestComplete(t, RIL_E_GENERIC_FAILURE, NULL, 0);
-        return;
-    }
-    LOGD("proxy manager - ok");
-
     GPtrArray *ops = 0;
-    /* Timeout after 15 minutes because Operator Scan takes looooooong */
-    if (!dbus_g_proxy_call_with_timeout(netreg, "Scan", 15*60000, &error, G_TYPE_INVALID,
-                                        type_a_oa_sv, &ops,
-                                        G_TYPE_INVALID))
+
+    if (!dbus_g_proxy_end_call(req->proxy, call, &error,
+                               type_a_oa_sv, &ops,
+                               G_TYPE_INVALID))
     {
         LOGE(".GetOperators failed: %s", error->message);
-        RIL_onRequestComplete(t, RIL_E_GENERIC_FAILURE, NULL, 0);
+        g_error_free(error);
+        ofonoRequestComplete(req, RIL_E_GENERIC_FAILURE, NULL, 0);
         return;
     }
 
     if (!ops || !ops->len) {
         LOGE("ops->len is empty.");
-        RIL_onRequestComplete(t, RIL_E_GENERIC_FAILURE, NULL, 0);
+        ofonoRequestComplete(req, RIL_E_GENERIC_FAILURE, NULL, 0);
+        if (ops) g_ptr_array_free(ops, TRUE);
         return;
     }
 
@@ -329,9 +861,26 @@ static void requestQueryAvailableNetworks(
         response[i*4 + 3] = strdup(g_value_peek_pointer(status));
     }
 
+    ofonoRequestComplete(req, RIL_E_SUCCESS, response, sizeof(response));
+
+    for (i = 0; i < ops->len*4; i++)
+        free(response[i]);
     g_ptr_array_free(ops, TRUE);
+}
+
+static void requestQueryAvailableNetworks(
+    void * data, size_t datalen, RIL_Token t)
+{
+    if (!netreg) {
+        LOGE("Netreg proxy doesn't exist");
+        RIL_onRequestComplete(t, RIL_E_GENERIC_FAILURE, NULL, 0);
+        return;
+    }
 
-    RIL_onRequestComplete(t, RIL_E_SUCCESS, response, sizeof(response));
+    OfonoRequest *req = ofonoRequestNew(netreg, "Scan", queryAvailableNetworksReply, t);
+    /* Timeout after 15 minutes because Operator Scan takes looooooong */
+    req->timeout = 15*60000;
+    ofonoRequestSend(req);
 }
 
 static void requestRegisterNetwork(
@@ -339,7 +888,6 @@ static void requestRegisterNetwork(
 {
     char * mccmnc = data;
     char  objPath[50];
-    GError * error = NULL;
     DBusGProxy * proxy;
 
     snprintf(objPath, sizeof(objPath), "%s/operator/%s", MODEM,mccmnc);
@@ -352,16 +900,10 @@ static void requestRegisterNetwork(
         return;
     }
 
-    if (!dbus_g_proxy_call(proxy, "Register", &error, G_TYPE_INVALID,
-                           G_TYPE_INVALID))
-    {
-        LOGE(".Register failed: %s", error->message);
-        RIL_onRequestComplete(t, RIL_E_ILLEGAL_SIM_OR_ME, NULL, 0);
-        return;
-    }
-    
-    RIL_onRequestComplete(t, RIL_E_SUCCESS, NULL, 0);
-
+    OfonoRequest *req = ofonoRequestNew(proxy, "Register", ofonoReplyNoResult, t);
+    req->failure = RIL_E_ILLEGAL_SIM_OR_ME;
+    ofonoRequestSend(req);
+    g_object_unref(proxy);
 }
 
 
@@ -369,7 +911,7 @@ static void requestGetPreferredNetworkType(
     void * data, size_t datalen, RIL_Token t){
     const gchar * preferred;
     int response;
-    GError * error = NULL;
+    GValue valueSettings = G_VALUE_INITIALIZATOR;
 
     if (!radiosettings) {
         LOGE("Radiosettings proxy doesn't exist");
@@ -377,21 +919,12 @@ static void requestGetPreferredNetworkType(
         return;
     }
 
-    GHashTable *dictProps = iface_get_properties(radiosettings);
-    if (!dictProps) {
-        LOGD("!dictProps");
-        RIL_onRequestComplete(t, RIL_E_GENERIC_FAILURE, NULL, 0);
-        return;
-    }
-
-    GValue *valueSettings = (GValue*) g_hash_table_lookup(dictProps, "TechnologyPreference");
-    if (!valueSettings) {
+    if (!getProperty(radiosettings, "TechnologyPreference", &valueSettings)) {
         LOGE("!valueSettings");
         RIL_onRequestComplete(t, RIL_E_GENERIC_FAILURE, NULL, 0);
         return;
     }
-    LOGD("valueSettings-ok");
-    preferred = g_value_peek_pointer(valueSettings);
+    preferred = g_value_get_string(&valueSettings);
 
     if (!g_strcmp0(preferred, "any")) {
         /* We don't have support for cdma/evdo so it's gsm/wcdma in auto mode */
@@ -400,11 +933,14 @@ static void requestGetPreferredNetworkType(
         response = 1; 
     } else if (!g_strcmp0(preferred, "umts")){
         response = 2; 
-    } else if (!g_strcmp0(preferred, "lte")){
+    } else {
         /* RIL doesn't have an option for LTE yet */
         RIL_onRequestComplete(t, RIL_E_GENERIC_FAILURE, NULL, 0);
+        g_value_unset(&valueSettings);
+        return;
     }
     RIL_onRequestComplete(t, RIL_E_SUCCESS, &response, sizeof(int));
+    g_value_unset(&valueSettings);
 }
 
 static void requestSetPreferredNetworkType(
@@ -412,7 +948,6 @@ static void requestSetPreferredNetworkType(
 
     int requested = *((int *)data);
     const gchar * preferred;
-    GError * error = NULL;
 
     if (!radiosettings) {
         LOGE("Radiosettings proxy object doesn't exist");
@@ -421,11 +956,11 @@ static void requestSetPreferredNetworkType(
     }
 
     if (requested == 3 || requested == 0){
-        preferred = g_strdup("any");
+        preferred = "any";
     } else if (requested == 1){
-        preferred = g_strdup("gsm");
+        preferred = "gsm";
     } else if (requested == 2){
-        preferred = g_strdup("umts");
+        preferred = "umts";
     } else {
         RIL_onRequestComplete(t, RIL_E_MODE_NOT_SUPPORTED, NULL, 0);
         return;
@@ -434,96 +969,233 @@ static void requestSetPreferredNetworkType(
     GValue value = G_VALUE_INITIALIZATOR;
     g_value_init(&value, G_TYPE_STRING);
     g_value_set_static_string(&value, preferred);
+
+    OfonoRequest *req = objSetPropertyRequest(radiosettings, "TechnologyPreference", &value, t);
     /* For some reason this works but sends back an error, just ignore it*/
-    objSetProperty(radiosettings, "TechnologyPreference", &value);
+    req->failure = RIL_E_SUCCESS;
+    ofonoRequestSend(req);
+}
 
-    RIL_onRequestComplete(t, RIL_E_SUCCESS, NULL, 0);
+
+/*** Coalesced unsolicited notifications ***/
+
+/*
+ * Every NETWORK_STATE_CHANGED / CALL_STATE_CHANGED makes the framework poll
+ * us for the whole state, and ofono reports a single transition as a burst
+ * of PropertyChanged signals. Notifications of the same kind arriving within
+ * coalesceWindow ms are merged into one, sent when the window closes.
+ */
+
+typedef struct {
+    int             unsol;      // RIL_UNSOL_*
+    const char      *name;
+    guint           source;     // pending timeout, 0 if nothing is scheduled
+    unsigned int    merged;     // merged into the pending notification
+} CoalescedUnsol;
+
+static CoalescedUnsol networkStateUnsol = {
+    RIL_UNSOL_RESPONSE_NETWORK_STATE_CHANGED, "NETWORK_STATE_CHANGED", 0, 0
+};
+static CoalescedUnsol callStateUnsol = {
+    RIL_UNSOL_RESPONSE_CALL_STATE_CHANGED, "CALL_STATE_CHANGED", 0, 0
+};
+
+static unsigned int coalesceWindow = 30; // ms, 0 disables coalescing (-c option)
+static pthread_mutex_t coalesceLock = PTHREAD_MUTEX_INITIALIZER;
+
+static gboolean coalescedUnsolFire(gpointer data)
+{
+    CoalescedUnsol *u = (CoalescedUnsol *) data;
+    unsigned int merged;
+
+    pthread_mutex_lock(&coalesceLock);
+    u->source = 0;
+    merged = u->merged;
+    u->merged = 0;
+    pthread_mutex_unlock(&coalesceLock);
+
+    // totals are in OEM_HOOK_STRINGS "stats"
+    if (merged)
+        LOGD("%s: %u merged", u->name, merged);
+    statsUnsolSent(u->unsol, merged);
+    RIL_onUnsolicitedResponse(u->unsol, NULL, 0);
+    return FALSE;
 }
 
+/* May be called from any thread */
+static void coalescedUnsolSchedule(CoalescedUnsol *u)
+{
+    if (!coalesceWindow) {
+        statsUnsolSent(u->unsol, 0);
+        RIL_onUnsolicitedResponse(u->unsol, NULL, 0);
+        return;
+    }
+
+    pthread_mutex_lock(&coalesceLock);
+    if (u->source)
+        u->merged++;
+    else
+        u->source = g_timeout_add(coalesceWindow, coalescedUnsolFire, u);
+    pthread_mutex_unlock(&coalesceLock);
+}
 
 static void sendCallStateChanged(void *param)
 {
-    RIL_onUnsolicitedResponse (
-        RIL_UNSOL_RESPONSE_CALL_STATE_CHANGED,
-        NULL, 0);
+    coalescedUnsolSchedule(&callStateUnsol);
 }
 
 static void sendNetworkStateChanged()
 {
-    RIL_onUnsolicitedResponse(
-        RIL_UNSOL_RESPONSE_NETWORK_STATE_CHANGED,
-        NULL, 0);
+    coalescedUnsolSchedule(&networkStateUnsol);
 }
 
-static void requestAnswer(RIL_Token t)
-{
-    GError *error = NULL;
-    GSList *l;
-    int found = 0;
+/*** Voice call table ***/
 
-    pthread_mutex_lock(&lock);
-    for (l = voiceCalls; l; l = l->next) {
-        ORIL_Call *call = (ORIL_Call*) l->data;
-        if (RIL_CALL_INCOMING == call->rilCall.state) {
-            found = 1;
-            if (!dbus_g_proxy_call(call->obj, "Answer", &error, G_TYPE_INVALID, G_TYPE_INVALID))
-                LOGE("Call->Answer failed: %s", error->message);
-            RIL_onUnsolicitedResponse(RIL_UNSOL_RESPONSE_CALL_STATE_CHANGED, 0, 0);
-            break;
-        }
-    }
-    pthread_mutex_unlock(&lock);
+/*
+ * Calls live in the fixed voiceCalls table, slot (index - 1) for ofono call
+ * index <= MAX_CALLS. The slot is also passed as user data to the call
+ * proxy signal handlers, so they find their call without a search.
+ */
 
-    if (!found)
-        LOGW("Can't answer: call not found");
+/* Call index ofono encodes in the object path, 0 if it can't be parsed */
+static unsigned callIndexFromPath(const char *objPath)
+{
+    unsigned callIndex = 0;
+    size_t len = strlen(MODEM);
 
-    /* success or failure is ignored by the upper layer here.
-       it will call GET_CURRENT_CALLS and determine success that way */
-    RIL_onRequestComplete(t, RIL_E_SUCCESS, NULL, 0);
+    if (!strncmp(objPath, MODEM, len))
+        sscanf(objPath + len, "/voicecall%u", &callIndex);
+    return callIndex;
 }
 
-static GHashTable* iface_get_properties(DBusGProxy *proxy)
+/* Must be called with lock held */
+static ORIL_Call *callByPath(const char *objPath)
 {
-    GError *error = NULL;
-    GHashTable *dict = 0;
-    if (!dbus_g_proxy_call(proxy, "GetProperties", &error, G_TYPE_INVALID,
-                           dbus_g_type_get_map("GHashTable", G_TYPE_STRING, G_TYPE_VALUE), &dict,
-                           G_TYPE_INVALID))
-    {
-        LOGE(".GetProperties failed: %s", error->message);
-        return 0;
-    }
+    unsigned callIndex = callIndexFromPath(objPath);
+    int i;
+
+    if (callIndex >= 1 && callIndex <= MAX_CALLS
+        && !strcmp(voiceCalls[callIndex - 1].objPath, objPath))
+        return &voiceCalls[callIndex - 1];
 
-    return dict;
+    // the call didn't fit in its own slot
+    for (i = 0; i < MAX_CALLS; i++)
+        if (!strcmp(voiceCalls[i].objPath, objPath))
+            return &voiceCalls[i];
+    return NULL;
 }
 
-static void requestGetCurrentCalls(void *data, size_t datalen, RIL_Token t)
+/* Must be called with lock held */
+static ORIL_Call *callAllocSlot(unsigned callIndex)
 {
-    int countCalls = 0;
-    GSList *l;
-    RIL_Call **pp_calls;
+    int i;
 
-    LOGD("requestGetCurrentCalls");
-    if (!vcm) {
-        LOGE("!VCM");
-        RIL_onRequestComplete(t, RIL_E_SUCCESS, 0, 0);
-        return;
-    }
+    if (callIndex >= 1 && callIndex <= MAX_CALLS
+        && !voiceCalls[callIndex - 1].objPath[0])
+        return &voiceCalls[callIndex - 1];
+
+    for (i = 0; i < MAX_CALLS; i++)
+        if (!voiceCalls[i].objPath[0])
+            return &voiceCalls[i];
+    return NULL;
+}
+
+/*
+ * Copy the live calls into snapshot, taking a reference on each call proxy.
+ * lock is held only for the copy, so the caller can talk to ofono and the
+ * framework with the snapshot while the main loop keeps updating the table.
+ * Release with callsRelease().
+ */
+static int callsSnapshot(ORIL_Call snapshot[MAX_CALLS])
+{
+    int count = 0;
+    int i;
 
     pthread_mutex_lock(&lock);
-    pp_calls = (RIL_Call **)alloca(8 * sizeof(RIL_Call *));
-    for (l = voiceCalls; l; l = l->next) {
-        ORIL_Call *call = (ORIL_Call*) l->data;
-        pp_calls[countCalls++] = &(call->rilCall);
-        //validCalls++;
+    for (i = 0; i < MAX_CALLS; i++) {
+        if (!voiceCalls[i].objPath[0])
+            continue;
+        ORIL_Call *call = &snapshot[count++];
+        *call = voiceCalls[i];
+        if (call->obj)
+            g_object_ref(call->obj);
     }
-
-    RIL_onRequestComplete(t, RIL_E_SUCCESS, pp_calls,
-                          countCalls * sizeof (RIL_Call *));
     pthread_mutex_unlock(&lock);
-    LOGD("countCalls: %d", countCalls);
 
-    return;
+    for (i = 0; i < count; i++) {
+        snapshot[i].rilCall.number = snapshot[i].number;
+        snapshot[i].rilCall.name = snapshot[i].name;
+    }
+    return count;
+}
+
+static gboolean callsReleaseIdle(gpointer data)
+{
+    g_object_unref(data);
+    return FALSE;
+}
+
+/* The snapshot may hold the last reference, so drop it on the main loop */
+static void callsRelease(ORIL_Call snapshot[MAX_CALLS], int count)
+{
+    int i;
+
+    for (i = 0; i < count; i++)
+        if (snapshot[i].obj)
+            g_idle_add(callsReleaseIdle, snapshot[i].obj);
+}
+
+static void requestAnswer(RIL_Token t)
+{
+    ORIL_Call calls[MAX_CALLS];
+    int count = callsSnapshot(calls);
+    OfonoRequest *req = 0;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        ORIL_Call *call = &calls[i];
+        if (RIL_CALL_INCOMING == call->rilCall.state && call->obj) {
+            req = ofonoRequestNew(call->obj, "Answer", ofonoReplyNoResult, t);
+            /* success or failure is ignored by the upper layer here.
+               it will call GET_CURRENT_CALLS and determine success that way */
+            req->failure = RIL_E_SUCCESS;
+            ofonoRequestSend(req);
+            sendCallStateChanged(NULL);
+            break;
+        }
+    }
+    callsRelease(calls, count);
+
+    if (!req) {
+        LOGW("Can't answer: call not found");
+        RIL_onRequestComplete(t, RIL_E_SUCCESS, NULL, 0);
+    }
+}
+
+static void requestGetCurrentCalls(void *data, size_t datalen, RIL_Token t)
+{
+    ORIL_Call calls[MAX_CALLS];
+    RIL_Call *pp_calls[MAX_CALLS];
+    int countCalls;
+    int i;
+
+    LOGD("requestGetCurrentCalls");
+    if (!vcm) {
+        LOGE("!VCM");
+        RIL_onRequestComplete(t, RIL_E_SUCCESS, 0, 0);
+        return;
+    }
+
+    countCalls = callsSnapshot(calls);
+    for (i = 0; i < countCalls; i++)
+        pp_calls[i] = &calls[i].rilCall;
+
+    RIL_onRequestComplete(t, RIL_E_SUCCESS, pp_calls,
+                          countCalls * sizeof (RIL_Call *));
+    callsRelease(calls, countCalls);
+    LOGD("countCalls: %d", countCalls);
+
+    return;
 }
 
 static void requestDial(void *data, size_t datalen, RIL_Token t)
@@ -541,26 +1213,24 @@ static void requestDial(void *data, size_t datalen, RIL_Token t)
         case 0: clir = ""; break;   /*subscription default*/
     }
 
-    GError *error = NULL;
-    GValue *value = 0;
-    if (!dbus_g_proxy_call(vcm, "Dial", &error,
-                           G_TYPE_STRING, p_dial->address, G_TYPE_STRING, clir,
-                           G_TYPE_INVALID, G_TYPE_VALUE, value, G_TYPE_INVALID))
-    {
-        LOGE("VCM.Dial(%s, %s) failed: %s",
-             p_dial->address, clir, error->message);
+    if (!vcm) {
+        RIL_onRequestComplete(t, RIL_E_RADIO_NOT_AVAILABLE, NULL, 0);
+        return;
     }
 
+    OfonoRequest *req = ofonoRequestNew(vcm, "Dial", ofonoReplyNoResult, t);
+    ofonoRequestAddString(req, p_dial->address);
+    ofonoRequestAddString(req, clir);
+    req->resultType = DBUS_TYPE_G_OBJECT_PATH;
     /* success or failure is ignored by the upper layer here.
        it will call GET_CURRENT_CALLS and determine success that way */
-    RIL_onRequestComplete(t, RIL_E_SUCCESS, NULL, 0);
+    req->failure = RIL_E_SUCCESS;
+    ofonoRequestSend(req);
 }
 
 static void requestDTMF(void *data, size_t datalen, RIL_Token t)
 {
     char tones[2];
-    GError *error = NULL;
-    RIL_Errno res = RIL_E_SUCCESS;
 
     if (!vcm) {
         RIL_onRequestComplete(t, RIL_E_RADIO_NOT_AVAILABLE, NULL, 0);
@@ -571,14 +1241,9 @@ static void requestDTMF(void *data, size_t datalen, RIL_Token t)
     tones[0] = *((char*)data);
     tones[1] = '\0';
 
-    if (!dbus_g_proxy_call(vcm, "SendTones", &error,
-                           G_TYPE_STRING, tones,
-                           G_TYPE_INVALID, G_TYPE_INVALID)) {
-        LOGE("VoiceCallManager.SendTones failed: %s", error->message);
-        res = RIL_E_GENERIC_FAILURE;
-    }
-
-    RIL_onRequestComplete(t, res, NULL, 0);
+    OfonoRequest *req = ofonoRequestNew(vcm, "SendTones", ofonoReplyNoResult, t);
+    ofonoRequestAddString(req, tones);
+    ofonoRequestSend(req);
 }
 
 static void requestWriteSmsToSim(void *data, size_t datalen, RIL_Token t)
@@ -616,33 +1281,65 @@ error:
  */
 static void requestHangup(RIL_Token t, int line, int state)
 {
-    GSList *l;
-    int found = 0;
+    ORIL_Call calls[MAX_CALLS];
+    int count = callsSnapshot(calls);
+    OfonoRequest *req = 0;
+    int i;
 
     // 3GPP 22.030 6.5.5
     // "Releases a specific active call X"
     // ril.h: Hang up a specific line (like AT+CHLD=1x)
 
-    pthread_mutex_lock(&lock);
-    for (l = voiceCalls; l; l = l->next) {
-        ORIL_Call *call = (ORIL_Call*) l->data;
-        if (line == call->rilCall.index || (!line && (RIL_CallState) state == call->rilCall.state)) {
-            found = 1;
-            GError *error = NULL;
-            if (!dbus_g_proxy_call(call->obj, "Hangup", &error, G_TYPE_INVALID, G_TYPE_INVALID))
-                LOGE("VoiceCall.Hangup failed for line %d: %s", line, error->message);
-            RIL_onUnsolicitedResponse(RIL_UNSOL_RESPONSE_CALL_STATE_CHANGED, 0, 0);
+    for (i = 0; i < count; i++) {
+        ORIL_Call *call = &calls[i];
+        if ((line == call->rilCall.index || (!line && (RIL_CallState) state == call->rilCall.state))
+            && call->obj) {
+            req = ofonoRequestNew(call->obj, "Hangup", ofonoReplyNoResult, t);
+            /* success or failure is ignored by the upper layer here.
+               it will call GET_CURRENT_CALLS and determine success that way */
+            req->failure = RIL_E_SUCCESS;
+            ofonoRequestSend(req);
+            sendCallStateChanged(NULL);
             break;
         }
     }
-    pthread_mutex_unlock(&lock);
+    callsRelease(calls, count);
 
-    if (!found)
+    if (!req) {
         LOGW("requestHangup failed: line/state %d/%d not found", line, state);
+        RIL_onRequestComplete(t, RIL_E_SUCCESS, NULL, 0);
+    }
+}
 
-    /* success or failure is ignored by the upper layer here.
-       it will call GET_CURRENT_CALLS and determine success that way */
-    RIL_onRequestComplete(t, RIL_E_SUCCESS, NULL, 0);
+/**
+ * OEM_HOOK_STRINGS "stats" returns the request and signal statistics, one
+ * string per line, "stats-reset" clears them. Anything else is echoed back.
+ */
+static void requestOemHookStrings(void *data, size_t datalen, RIL_Token t)
+{
+    int i;
+    const char ** cur;
+    const char *command = datalen >= sizeof(char *) ? ((const char **) data)[0] : NULL;
+
+    LOGD("got OEM_HOOK_STRINGS: 0x%8p %lu", data, (long)datalen);
+
+    for (i = (datalen / sizeof (char *)), cur = (const char **)data ;
+         i > 0 ; cur++, i --) {
+        LOGD("> '%s'", *cur);
+    }
+
+    if (!g_strcmp0(command, "stats")) {
+        int count;
+        char **lines = statsFormat(&count);
+        RIL_onRequestComplete(t, RIL_E_SUCCESS, lines, count * sizeof(char *));
+        statsFree(lines, count);
+    } else if (!g_strcmp0(command, "stats-reset")) {
+        statsReset();
+        RIL_onRequestComplete(t, RIL_E_SUCCESS, NULL, 0);
+    } else {
+        // echo back strings
+        RIL_onRequestComplete(t, RIL_E_SUCCESS, data, datalen);
+    }
 }
 
 static void requestSignalStrength(void *data, size_t datalen, RIL_Token t)
@@ -717,6 +1414,312 @@ static void requestOperator(void *data, size_t datalen, RIL_Token t)
         RIL_onRequestComplete(t, RIL_E_RADIO_NOT_AVAILABLE, NULL, 0);
 }
 
+/*** Sending SMS ***/
+
+/*
+ * Text messages go to ofono's SendMessage, which does its own encoding
+ * and segmentation: the parts of a concatenated message are collected
+ * on the main loop thread and sent with a single call, whose reply
+ * completes the requests of all of them. Whatever SendMessage can't
+ * express (8-bit data, a message class or waiting indication, TP-PID,
+ * TP-VP, other UDH elements, status report requests) goes to SendPdu
+ * unchanged, as do PDUs that don't decode and parts whose siblings
+ * don't show up within SMS_CONCAT_TIMEOUT.
+ */
+
+#define SMS_CONCAT_TIMEOUT 2000 // ms to wait for the other parts of a message
+
+typedef struct {
+    RIL_Token   t;              // cleared once completed
+    gchar       *pdu;
+    gboolean    decoded;        // submit is valid
+    SmsSubmit   submit;
+} SmsPart;
+
+typedef struct {
+    gchar       destination[24];
+    guint16     ref;
+    int         total;
+    int         received;
+    guint       source;         // expiry timeout, 0 once sent
+    SmsPart     **parts;        // by sequence number - 1
+} SmsConcat;
+
+static GSList *smsConcats;      // incomplete messages, main loop thread only
+static volatile int smsMessageRef;
+
+static void smsComplete(RIL_Token t, RIL_Errno e, int messageRef)
+{
+    RIL_SMS_Response response;
+
+    if (RIL_E_SUCCESS != e) {
+        RIL_onRequestComplete(t, e, NULL, 0);
+        return;
+    }
+    response.messageRef = messageRef;
+    response.ackPDU = NULL;
+    response.errorCode = -1;    // 3GPP 27.005 3.2.5: unknown
+    RIL_onRequestComplete(t, RIL_E_SUCCESS, &response, sizeof(response));
+}
+
+static inline int smsNextMessageRef()
+{
+    return __sync_fetch_and_add(&smsMessageRef, 1) & 0xff;
+}
+
+static RIL_Errno smsErrorFromDBus(GError *error)
+{
+    if (DBUS_GERROR != error->domain)
+        return RIL_E_GENERIC_FAILURE;
+
+    switch (error->code) {
+        case DBUS_GERROR_NO_REPLY:
+        case DBUS_GERROR_TIMEOUT:
+        case DBUS_GERROR_TIMED_OUT:
+            return RIL_E_SMS_SEND_FAIL_RETRY;
+        case DBUS_GERROR_SERVICE_UNKNOWN:
+        case DBUS_GERROR_NAME_HAS_NO_OWNER:
+            return RIL_E_RADIO_NOT_AVAILABLE;
+        case DBUS_GERROR_REMOTE_EXCEPTION:
+            // network or modem failure, worth another try
+            if (dbus_g_error_has_name(error, "org.ofono.Error.Failed")
+                || dbus_g_error_has_name(error, "org.ofono.Error.Busy")
+                || dbus_g_error_has_name(error, "org.ofono.Error.InProgress"))
+                return RIL_E_SMS_SEND_FAIL_RETRY;
+            if (dbus_g_error_has_name(error, "org.ofono.Error.NotAvailable")
+                || dbus_g_error_has_name(error, "org.ofono.Error.NotImplemented"))
+                return RIL_E_RADIO_NOT_AVAILABLE;
+            break;
+    }
+    return RIL_E_GENERIC_FAILURE;
+}
+
+static void smsPartFree(SmsPart *part)
+{
+    if (part->t) {
+        LOGW("SMS: cancelled, no reply from ofono");
+        RIL_onRequestComplete(part->t, RIL_E_GENERIC_FAILURE, NULL, 0);
+    }
+    smsSubmitClear(&part->submit);
+    g_free(part->pdu);
+    g_free(part);
+}
+
+static void smsConcatFree(gpointer data)
+{
+    SmsConcat *concat = (SmsConcat *) data;
+    int i;
+
+    if (concat->source)
+        g_source_remove(concat->source);
+    for (i = 0; i < concat->total; i++)
+        if (concat->parts[i])
+            smsPartFree(concat->parts[i]);
+    g_free(concat->parts);
+    g_free(concat);
+}
+
+static void sendPduReply(OfonoRequest *req, DBusGProxyCall *call)
+{
+    GError *error = NULL;
+    GValue value = G_VALUE_INITIALIZATOR;
+    int messageRef;
+
+    if (!dbus_g_proxy_end_call(req->proxy, call, &error,
+                               G_TYPE_VALUE, &value, G_TYPE_INVALID))
+    {
+        LOGE("SendPdu failed: %s", error->message);
+        RIL_Errno e = smsErrorFromDBus(error);
+        g_error_free(error);
+        ofonoRequestComplete(req, e, NULL, 0);
+        return;
+    }
+
+    // TP-MR, when ofono tells it
+    if (G_VALUE_HOLDS_UCHAR(&value))
+        messageRef = g_value_get_uchar(&value);
+    else if (G_VALUE_HOLDS_UINT(&value))
+        messageRef = g_value_get_uint(&value) & 0xff;
+    else if (G_VALUE_HOLDS_INT(&value))
+        messageRef = g_value_get_int(&value) & 0xff;
+    else
+        messageRef = smsNextMessageRef();
+    g_value_unset(&value);
+
+    RIL_Token t = req->t;
+    req->t = 0;
+    smsComplete(t, RIL_E_SUCCESS, messageRef);
+}
+
+/* Send the part as it came from the framework, takes the part */
+static void smsSendPdu(SmsPart *part)
+{
+    OfonoRequest *req = ofonoRequestNew(sms, "SendPdu", sendPduReply, part->t);
+    ofonoRequestAddString(req, part->pdu);
+    part->t = 0;
+    smsPartFree(part);
+    ofonoRequestStart(req);
+}
+
+static void sendMessageReply(OfonoRequest *req, DBusGProxyCall *call)
+{
+    SmsConcat *concat = (SmsConcat *) req->data;
+    GError *error = NULL;
+    char *path = NULL;
+    RIL_Errno e = RIL_E_SUCCESS;
+    int i;
+
+    if (!dbus_g_proxy_end_call(req->proxy, call, &error,
+                               DBUS_TYPE_G_OBJECT_PATH, &path, G_TYPE_INVALID))
+    {
+        LOGE("SendMessage failed: %s", error->message);
+        e = smsErrorFromDBus(error);
+        g_error_free(error);
+    } else {
+        LOGD("SendMessage: %s, %d parts", path, concat->total);
+        g_free(path);
+    }
+
+    // the reply is a message path, ofono keeps the TP-MR it used to itself
+    for (i = 0; i < concat->total; i++) {
+        smsComplete(concat->parts[i]->t, e, smsNextMessageRef());
+        concat->parts[i]->t = 0;
+    }
+}
+
+/* Appends the UCS2 collected so far to text as UTF-8 */
+static void smsFlushUcs2(GString *text, GByteArray *ucs2)
+{
+    if (!ucs2->len)
+        return;
+    gchar *utf8 = ucs2ToUtf8(ucs2->data, ucs2->len);
+    g_string_append(text, utf8);
+    g_free(utf8);
+    g_byte_array_set_size(ucs2, 0);
+}
+
+/* Send the complete message as text, the request takes the concat */
+static void smsSendMessage(SmsConcat *concat)
+{
+    GString *text = g_string_new(NULL);
+    GByteArray *ucs2 = g_byte_array_new();
+    int i;
+
+    for (i = 0; i < concat->total; i++) {
+        const SmsSubmit *submit = &concat->parts[i]->submit;
+
+        // UCS2 is converted joined, a surrogate pair may span two parts
+        if (SMS_ALPHABET_UCS2 == submit->alphabet) {
+            g_byte_array_append(ucs2, submit->ucs2, submit->ucs2Octets);
+            continue;
+        }
+        smsFlushUcs2(text, ucs2);
+        g_string_append(text, submit->text);
+    }
+    smsFlushUcs2(text, ucs2);
+    g_byte_array_free(ucs2, TRUE);
+
+    OfonoRequest *req = ofonoRequestNew(sms, "SendMessage", sendMessageReply, 0);
+    req->statsRequest = statsRequestOf(concat->parts[0]->t);
+    req->data = concat;
+    req->dataFree = smsConcatFree;
+    ofonoRequestAddString(req, concat->destination);
+    ofonoRequestAddString(req, text->str);
+    g_string_free(text, TRUE);
+    ofonoRequestStart(req);
+}
+
+static gboolean smsConcatExpired(gpointer data)
+{
+    SmsConcat *concat = (SmsConcat *) data;
+    int i;
+
+    LOGW("SMS %u to %s: %d of %d parts, sending them as PDUs",
+         concat->ref, concat->destination, concat->received, concat->total);
+
+    concat->source = 0;
+    smsConcats = g_slist_remove(smsConcats, concat);
+    for (i = 0; i < concat->total; i++) {
+        if (concat->parts[i]) {
+            smsSendPdu(concat->parts[i]);
+            concat->parts[i] = NULL;
+        }
+    }
+    smsConcatFree(concat);
+    return FALSE;
+}
+
+/* Message the part belongs to, a new one for its first part */
+static SmsConcat *smsConcatOf(const SmsSubmit *submit)
+{
+    GSList *l;
+
+    for (l = smsConcats; l; l = l->next) {
+        SmsConcat *concat = (SmsConcat *) l->data;
+        if (concat->ref == submit->concatRef && concat->total == submit->concatTotal
+            && !strcmp(concat->destination, submit->destination))
+            return concat;
+    }
+
+    SmsConcat *concat = g_new0(SmsConcat, 1);
+    strcpy(concat->destination, submit->destination);
+    concat->ref = submit->concatRef;
+    concat->total = submit->concatTotal ? submit->concatTotal : 1;
+    concat->parts = g_new0(SmsPart *, concat->total);
+    if (concat->total > 1) {
+        concat->source = g_timeout_add(SMS_CONCAT_TIMEOUT, smsConcatExpired, concat);
+        smsConcats = g_slist_prepend(smsConcats, concat);
+    }
+    return concat;
+}
+
+/* Plain text of no class to the network as it is, all SendMessage can send */
+static gboolean smsIsPlainText(const SmsPart *part)
+{
+    const SmsSubmit *submit = &part->submit;
+
+    return part->decoded && !submit->pid && !submit->validityPeriod
+           && (0x00 == submit->dcs || 0x08 == submit->dcs)
+           && !submit->otherHeaders && !submit->statusReport;
+}
+
+static gboolean smsSubmitStart(gpointer data)
+{
+    SmsPart *part = (SmsPart *) data;
+    SmsSubmit *submit = &part->submit;
+
+    if (!sms) {
+        RIL_onRequestComplete(part->t, RIL_E_RADIO_NOT_AVAILABLE, NULL, 0);
+        part->t = 0;
+        smsPartFree(part);
+        return FALSE;
+    }
+
+    if (!smsIsPlainText(part)) {
+        smsSendPdu(part);
+        return FALSE;
+    }
+
+    SmsConcat *concat = smsConcatOf(submit);
+    int seq = submit->concatSeq ? submit->concatSeq - 1 : 0;
+    if (concat->parts[seq]) {
+        LOGW("SMS %u: part %d sent again", concat->ref, seq + 1);
+        smsSendPdu(part);
+        return FALSE;
+    }
+    concat->parts[seq] = part;
+
+    if (++concat->received == concat->total) {
+        if (concat->source) {
+            g_source_remove(concat->source);
+            concat->source = 0;
+            smsConcats = g_slist_remove(smsConcats, concat);
+        }
+        smsSendMessage(concat);
+    }
+    return FALSE;
+}
+
 static void requestSendSMS(void *data, size_t datalen, RIL_Token t)
 {
     if (!sms) {
@@ -728,23 +1731,35 @@ static void requestSendSMS(void *data, size_t datalen, RIL_Token t)
     const char *pdu = ((const char **)data)[1];
     LOGD("requestSendSMS, %s, %s", smsc, pdu);
 
-    GError *error = NULL;
-    GValue *value = 0;
+    SmsPart *part = g_new0(SmsPart, 1);
+    part->decoded = decodeSubmitPDU(pdu, &part->submit);
+    if (!part->decoded)
+        LOGW("requestSendSMS: SMS-SUBMIT not decoded, sent as it is");
+    part->t = t;
+    part->pdu = g_strdup(pdu);
 
-    int res = dbus_g_proxy_call(sms, "SendPdu",
-                                &error,
-                                G_TYPE_STRING, pdu, G_TYPE_INVALID,
-                                G_TYPE_VALUE, value, G_TYPE_INVALID);
+    // parts of a message are collected on the main loop thread, no locking
+    g_idle_add(smsSubmitStart, part);
+}
 
-    /* FIXME fill in messageRef and ackPDU */
-    RIL_SMS_Response response;
-    memset(&response, 0, sizeof(response));
-    RIL_onRequestComplete(t, RIL_E_SUCCESS, &response, sizeof(response));
+static void setupDataCallReply(OfonoRequest *req, DBusGProxyCall *call)
+{
+    GError *error = NULL;
+
+    if (!dbus_g_proxy_end_call(req->proxy, call, &error, G_TYPE_INVALID)) {
+        LOGE("Activating data context failed: %s", error->message);
+        g_error_free(error);
+        // there won't be PropertyChanged signal for Active
+        if (dataCallToken) {
+            RIL_onRequestComplete(dataCallToken, RIL_E_GENERIC_FAILURE, NULL, 0);
+            dataCallToken = 0;
+        }
+    }
 }
 
 static void requestSetupDataCall(void *data, size_t datalen, RIL_Token t)
 {
-    if (!connmanAttached) {
+    if (!connmanAttached || !pdc) {
         LOGW("requestSetupDataCall exit, connman is not in Attached state");
         RIL_onRequestComplete(t, RIL_E_GENERIC_FAILURE, NULL, 0);
         return;
@@ -789,7 +1804,9 @@ static void requestSetupDataCall(void *data, size_t datalen, RIL_Token t)
         GValue value = G_VALUE_INITIALIZATOR;
         g_value_init(&value, G_TYPE_BOOLEAN);
         g_value_set_boolean(&value, TRUE);
-        objSetProperty(pdc, "Active", &value);
+        OfonoRequest *req = objSetPropertyRequest(pdc, "Active", &value, 0);
+        req->reply = setupDataCallReply;
+        ofonoRequestSend(req);
     }
 
     LOGW("Data connection setup: success");
@@ -826,29 +1843,31 @@ static int setupIP()
     return 1;
 }
 
+/* Complete SETUP_DATA_CALL once its context is active */
 static void getIP()
 {
     LOGD("getIP called");
 
-    // Get IP address of new connection
-    GHashTable *dictProps = iface_get_properties(pdc);
-    if (!dictProps) {
-        LOGD("!dictProps");
-        goto error;
+    // active already at startup, or activated by someone else
+    if (!dataCallToken) {
+        LOGW("context active, no data call pending");
+        return;
     }
 
-    GValue *valueSettings = (GValue*) g_hash_table_lookup(dictProps, "Settings");
-    if (!valueSettings) {
+    // Get IP address of new connection, Settings is announced before Active
+    GValue valueSettings = G_VALUE_INITIALIZATOR;
+    if (!getProperty(pdc, "Settings", &valueSettings)) {
         LOGE("!valueSettings");
         goto error;
     }
     LOGD("valueSettings-ok");
-    GHashTable *dictSettings = (GHashTable*) g_value_peek_pointer(valueSettings);
+    GHashTable *dictSettings = (GHashTable*) g_value_get_boxed(&valueSettings);
     GValue *value = (GValue *) g_hash_table_lookup(dictSettings, "Address");
     LOGD("Address: %p", value);
     if (value && g_value_peek_pointer(value)) {
         strncpy(ipDataCall, g_value_peek_pointer(value), sizeof(ipDataCall));
         LOGW("IP Address=%s", ipDataCall);
+        g_value_unset(&valueSettings);
 
         if (ifc_init() != 0) {
             LOGE("ifc_init failed");
@@ -857,17 +1876,21 @@ static void getIP()
 
         if (setupIP()) {
             RIL_onRequestComplete(dataCallToken, RIL_E_SUCCESS, responseDataCall, sizeof(responseDataCall));
+            dataCallToken = 0;
             ifc_close();
             return;
         }
         ifc_close();
     }
-    else
+    else {
         LOGE("No IP Address in Properties:Settings");
+        g_value_unset(&valueSettings);
+    }
 
 error:
     LOGE("getIP: ERROR!!!");
     RIL_onRequestComplete(dataCallToken, RIL_E_GENERIC_FAILURE, NULL, 0);
+    dataCallToken = 0;
 }
 
 static void requestSMSAcknowledge(void *data, size_t datalen, RIL_Token t)
@@ -984,32 +2007,19 @@ static void  requestEnterSimPin(void*  data, size_t  datalen, RIL_Token  t)
 static char getSupplementaryServicesState()
 {
     char res = '0'; // fallback to USSD-Notify
-    GHashTable *dictProps = iface_get_properties(supsrv);
-    if (dictProps) {
-        GValue *value = (GValue*) g_hash_table_lookup(dictProps, "State");
-        if (value) {
-            if (!strcmp(g_value_peek_pointer(value), "user-response"))
-                res = '1';
-        }
-        g_hash_table_destroy(dictProps);
+    GValue value = G_VALUE_INITIALIZATOR;
+    if (getProperty(supsrv, "State", &value)) {
+        if (!g_strcmp0(g_value_get_string(&value), "user-response"))
+            res = '1';
+        g_value_unset(&value);
     }
 
     LOGD("srv_ussd_state: %c", res);
     return res;
 }
 
-static void  requestSendUSSD(void *data, size_t datalen, RIL_Token t)
+static void sendUSSDReply(OfonoRequest *req, DBusGProxyCall *call)
 {
-    const char *ussdRequest = (char *)(data);
-
-    if (!supsrv) {
-        RIL_onRequestComplete(t, RIL_E_RADIO_NOT_AVAILABLE, NULL, 0);
-        return;
-    }
-
-    // get current SupplementaryServices state
-    char state = getSupplementaryServicesState();
-
     GError *error = NULL;
     char *request = 0;
     char *strValue = 0;
@@ -1017,40 +2027,32 @@ static void  requestSendUSSD(void *data, size_t datalen, RIL_Token t)
 
     // If USSD session is active in USSD-Response state,
     // we use Respond method instead of Initiate
-    if (state == '1') {
-      res = dbus_g_proxy_call(supsrv, "Respond",
-                              &error,
-                              G_TYPE_STRING, ussdRequest, G_TYPE_INVALID,
-                              G_TYPE_STRING, &strValue, G_TYPE_INVALID);
-      if (!res) {
-          LOGE("supsrv.Respond(%s) failed: %s",
-               ussdRequest, error->message);
-          RIL_onRequestComplete(t, RIL_E_GENERIC_FAILURE, NULL, 0);
-          return;
-      }
+    if (!g_strcmp0(req->method, "Respond")) {
+        res = dbus_g_proxy_end_call(req->proxy, call, &error,
+                                    G_TYPE_STRING, &strValue, G_TYPE_INVALID);
     }
     else {
         GValue value = G_VALUE_INITIALIZATOR;
-        res = dbus_g_proxy_call(supsrv, "Initiate",
-                                &error,
-                                G_TYPE_STRING, ussdRequest, G_TYPE_INVALID,
-                                G_TYPE_STRING, &request,
-                                G_TYPE_VALUE, &value, G_TYPE_INVALID);
+        res = dbus_g_proxy_end_call(req->proxy, call, &error,
+                                    G_TYPE_STRING, &request,
+                                    G_TYPE_VALUE, &value, G_TYPE_INVALID);
         if (res) {
             strValue = g_strdup(g_value_get_string(&value));
             g_value_unset(&value);
         }
-        else {
-            LOGE("supsrv.Initiate(%s) failed: %s",
-                 ussdRequest, error->message);
-            RIL_onRequestComplete(t, RIL_E_GENERIC_FAILURE, NULL, 0);
-            return;
-        }
     }
 
+    if (!res) {
+        LOGE("supsrv.%s failed: %s", req->method, error->message);
+        g_error_free(error);
+        ofonoRequestComplete(req, RIL_E_GENERIC_FAILURE, NULL, 0);
+        return;
+    }
+
+    ofonoRequestComplete(req, RIL_E_SUCCESS, NULL, 0);
+
     if (strValue) {
         LOGD("USSD response from network: %s", strValue);
-        RIL_onRequestComplete(t, RIL_E_SUCCESS, NULL, 0);
 
         // Get SupplementaryServices state again
         char supSrvState[] = {0, 0};
@@ -1060,29 +2062,39 @@ static void  requestSendUSSD(void *data, size_t datalen, RIL_Token t)
         unsResp[0] = supSrvState;
         unsResp[1] = strValue;
         RIL_onUnsolicitedResponse(RIL_UNSOL_ON_USSD, unsResp, sizeof(unsResp));
-
-        if (request) g_free(request);
         g_free(strValue);
     }
+    if (request) g_free(request);
 }
 
-static void requestCancelUSSD(void * data, size_t datalen, RIL_Token t)
+static void  requestSendUSSD(void *data, size_t datalen, RIL_Token t)
 {
-    RIL_Errno res = RIL_E_GENERIC_FAILURE;
+    const char *ussdRequest = (char *)(data);
 
-    if (supsrv) {
-        GError *error = NULL;
-        if (!dbus_g_proxy_call(supsrv, "Cancel", &error,
-                               G_TYPE_INVALID, G_TYPE_INVALID))
-        {
-            LOGE("supsrv.Cancel() failed: %s", error->message);
-        }
-        else {
-            res = RIL_E_SUCCESS;
-        }
+    if (!supsrv) {
+        RIL_onRequestComplete(t, RIL_E_RADIO_NOT_AVAILABLE, NULL, 0);
+        return;
+    }
+
+    // get current SupplementaryServices state
+    char state = getSupplementaryServicesState();
+
+    // If USSD session is active in USSD-Response state,
+    // we use Respond method instead of Initiate
+    OfonoRequest *req = ofonoRequestNew(supsrv, state == '1' ? "Respond" : "Initiate",
+                                        sendUSSDReply, t);
+    ofonoRequestAddString(req, ussdRequest);
+    ofonoRequestSend(req);
+}
+
+static void requestCancelUSSD(void * data, size_t datalen, RIL_Token t)
+{
+    if (!supsrv) {
+        RIL_onRequestComplete(t, RIL_E_GENERIC_FAILURE, NULL, 0);
+        return;
     }
 
-    RIL_onRequestComplete(t, res, NULL, 0);
+    ofonoRequestSend(ofonoRequestNew(supsrv, "Cancel", ofonoReplyNoResult, t));
 }
 
 static void requestGetRoamingPreference(void * data, size_t datalen, RIL_Token t)
@@ -1100,7 +2112,6 @@ static void requestSetRoamingPreference(void * data, size_t datalen, RIL_Token t
 {
     int requested = *((int *)data);
     gboolean roaming;
-    GError * error = NULL;
 
     if (!connman) {
         LOGE("Connman proxy object doesn't exist");
@@ -1117,28 +2128,20 @@ static void requestSetRoamingPreference(void * data, size_t datalen, RIL_Token t
     g_value_init(&value, G_TYPE_BOOLEAN);
     g_value_set_boolean(&value, roaming);
 
-    if(objSetProperty(connman, "RoamingAllowed", &value)){
-        RIL_onRequestComplete(t,RIL_E_GENERIC_FAILURE, NULL, 0);
-        return;
-    }
-
-    RIL_onRequestComplete(t, RIL_E_SUCCESS, NULL, 0);
-
+    ofonoRequestSend(objSetPropertyRequest(connman, "RoamingAllowed", &value, t));
 }
 
 static void requestBasebandVersion(void * data, size_t datalen, RIL_Token t)
 {
-    GHashTable* props;
-    GValue* value;
     if (modemRev[0] == '\0') {
         /* We don't have the revision, lets save the token and reply when we have the version */
         modemRevToken = t;
     } 
+    else
+        RIL_onRequestComplete(t, RIL_E_SUCCESS, modemRev, sizeof(char *));
 }
 
 static void setFastDormancy(gboolean state) {
-    GError * error = NULL;
-
     if (!radiosettings) {
         LOGE("Radiosettings proxy object doesn't exist");
         return;
@@ -1148,11 +2151,7 @@ static void setFastDormancy(gboolean state) {
     g_value_init(&value, G_TYPE_BOOLEAN);
     g_value_set_boolean(&value, state);
 
-    if(objSetProperty(radiosettings, "FastDormancy", &value)){
-        LOGE("Couldn't set fast dormancy");
-        return;
-    }
-
+    objSetProperty(radiosettings, "FastDormancy", &value);
 }
 
 /*** Callback methods from the RIL library to us ***/
@@ -1174,7 +2173,9 @@ onRequest (int request, void *data, size_t datalen, RIL_Token t)
 {
     int err;
 
-    LOGD("onRequest: %s", requestToString(request));
+    statsRequestBegin(request, t);
+    traceEvent(TRACE_REQUEST_BEGIN, request, 0, (uintptr_t) t);
+    LOG_RATELIMITED(D, "onRequest: %s", requestToString(request));
 
     /* Ignore all requests except RIL_REQUEST_GET_SIM_STATUS
      * when RADIO_STATE_UNAVAILABLE.
@@ -1321,6 +2322,7 @@ onRequest (int request, void *data, size_t datalen, RIL_Token t)
             requestDTMF(data, datalen, t);
             break;
         case RIL_REQUEST_SEND_SMS:
+        case RIL_REQUEST_SEND_SMS_EXPECT_MORE:
             requestSendSMS(data, datalen, t);
             break;
         case RIL_REQUEST_SETUP_DATA_CALL:
@@ -1400,22 +2402,8 @@ onRequest (int request, void *data, size_t datalen, RIL_Token t)
 
 
         case RIL_REQUEST_OEM_HOOK_STRINGS:
-            {
-                int i;
-                const char ** cur;
-
-                LOGD("got OEM_HOOK_STRINGS: 0x%8p %lu", data, (long)datalen);
-
-
-                for (i = (datalen / sizeof (char *)), cur = (const char **)data ;
-                     i > 0 ; cur++, i --) {
-                    LOGD("> '%s'", *cur);
-                }
-
-                // echo back strings
-                RIL_onRequestComplete(t, RIL_E_SUCCESS, data, datalen);
-                break;
-            }
+            requestOemHookStrings(data, datalen, t);
+            break;
 
         case RIL_REQUEST_WRITE_SMS_TO_SIM:
             requestWriteSmsToSim(data, datalen, t);
@@ -1648,35 +2636,33 @@ static void* mainLoop(void *param)
 static void callPropertyChanged(DBusGProxy *proxy, const gchar *property,
                                 GValue *value, gpointer priv)
 {
-    int callIndex = (int) priv;
-    LOGD("callPropertyChanged(%d): %s->%s", callIndex, property, (char*)g_value_peek_pointer(value));
+    uint64_t start = statsNow();
+    int slot = GPOINTER_TO_INT(priv);
+    LOG_PROPERTY(D, "callPropertyChanged", property, value);
 
-    if (!g_strcmp0(property, "State")) {
-        GSList *l;
+    if (ofonoString(property) == OFONO_PROP_STATE) {
         int found = 0;
         RIL_CallState state = 0xffffffff;
 
         pthread_mutex_lock(&lock);
-        for (l = voiceCalls; l; l = l->next) {
-            ORIL_Call *call = (ORIL_Call*) l->data;
-            if (proxy == call->obj) {
-                found = 1;
-                state = ofonoStateToRILState(g_value_peek_pointer(value));
-                call->rilCall.state = state;
-                break;
-            }
+        ORIL_Call *call = &voiceCalls[slot];
+        if (proxy == call->obj) {
+            found = 1;
+            state = ofonoStateToRILState(g_value_peek_pointer(value));
+            call->rilCall.state = state;
         }
         pthread_mutex_unlock(&lock);
 
         // for disconnected calls we'll send it on vcm->CallRemoved signal
         if (0xffffffff != (unsigned int)state)
-            RIL_onUnsolicitedResponse(RIL_UNSOL_RESPONSE_CALL_STATE_CHANGED, NULL, 0);
+            sendCallStateChanged(NULL);
 
         if (!found)
             LOGW("BUG? Call not found");
     }
 
     g_value_unset(value);
+    signalHandled(STATS_SIGNAL_CALL, start);
 }
 
 static void callDisconnectReason(DBusGProxy *proxy, const gchar *reason,
@@ -1689,7 +2675,7 @@ static void vcmPropertyChanged(DBusGProxy *proxy, const gchar *property,
                                GValue *value, gpointer user_data)
 {
     // XXX
-    LOGW("vcm_property_changed %s->%s", property, g_strdup_value_contents(value));
+    LOG_PROPERTY(W, "vcm_property_changed", property, value);
 
     if (!g_strcmp0("Calls", property)) {
         GPtrArray *callArr = g_value_peek_pointer(value);
@@ -1697,8 +2683,7 @@ static void vcmPropertyChanged(DBusGProxy *proxy, const gchar *property,
             LOGD("Calls is empty. Disconnected?");
         }
 
-        RIL_onUnsolicitedResponse(RIL_UNSOL_RESPONSE_CALL_STATE_CHANGED,
-                                  NULL, 0);
+        sendCallStateChanged(NULL);
     }
     g_value_unset(value);
 }
@@ -1706,106 +2691,151 @@ static void vcmPropertyChanged(DBusGProxy *proxy, const gchar *property,
 static void vcmCallAdded(DBusGProxy *proxy, const char *objPath,
                          GHashTable *prop, gpointer priv)
 {
+    uint64_t start = statsNow();
     LOGD("vcmCallAdded: %s", objPath);
     g_hash_table_foreach(prop, (GHFunc)hash_entry_gvalue_print, NULL);
 
-    ORIL_Call *call = malloc(sizeof(ORIL_Call));
+    const GValue *number = g_hash_table_lookup(prop, "LineIdentification");
+    const GValue *name = g_hash_table_lookup(prop, "Name");
+    const GValue *state = g_hash_table_lookup(prop, "State");
+    unsigned callIndex = callIndexFromPath(objPath);
+
+    DBusGProxy *obj = dbus_g_proxy_new_for_name(connection, OFONO_SERVICE,
+                                                objPath, OFONO_IFACE_CALL);
+
+    pthread_mutex_lock(&lock);
+    ORIL_Call *call = callAllocSlot(callIndex);
     if (!call) {
-        LOGE("vcmCallAdded failed: ENOMEM");
+        pthread_mutex_unlock(&lock);
+        LOGE("vcmCallAdded failed: no free slot for %s", objPath);
+        if (obj)
+            g_object_unref(obj);
+        signalHandled(STATS_SIGNAL_CALL_ADDED, start);
         return;
     }
+    int slot = call - voiceCalls;
 
-    memset(call, sizeof(ORIL_Call), 0);
-    //call->rilCallPtr = &call->rilCall;
-    strncpy(call->objPath, objPath, sizeof(call->objPath));
+    memset(call, 0, sizeof(ORIL_Call));
+    call->obj = obj;
+    snprintf(call->objPath, sizeof(call->objPath), "%s", objPath);
+    snprintf(call->number, sizeof(call->number), "%s",
+             number ? (const char *) g_value_peek_pointer(number) : EMPTY);
+    snprintf(call->name, sizeof(call->name), "%s",
+             name ? (const char *) g_value_peek_pointer(name) : EMPTY);
 
-    const GValue *number = g_hash_table_lookup(prop, "LineIdentification");
-    strncpy(call->number, g_value_peek_pointer(number), sizeof(call->number));
-
-    const GValue *name = g_hash_table_lookup(prop, "Name");
-    strncpy(call->name, g_value_peek_pointer(name), sizeof(call->name));
-
-    const GValue *state = g_hash_table_lookup(prop, "State");
-    call->rilCall.state = ofonoStateToRILState(g_value_peek_pointer(state));
-
-    unsigned callIndex = 0;
-    sscanf(objPath, "/isimodem/voicecall%02u", &callIndex); // FIXME
+    call->rilCall.state = ofonoStateToRILState(state ? g_value_peek_pointer(state) : NULL);
     call->rilCall.index = callIndex;
     call->rilCall.toa = 145; // international format
     call->rilCall.isVoice = 1;
     call->rilCall.number = call->number;
     call->rilCall.name = call->name;
     call->rilCall.uusInfo = NULL;
-
-    if (RIL_CALL_INCOMING == call->rilCall.state) {
-        call->rilCall.isMT = 1;
-        RIL_onUnsolicitedResponse(RIL_UNSOL_CALL_RING, 0, 0);
-    }
-    else //if (RIL_CALL_INCOMING == call->rilCall.state)
-        call->rilCall.isMT = 0;
+    call->rilCall.isMT = (RIL_CALL_INCOMING == call->rilCall.state) ? 1 : 0;
     /* Presentation: 0=Allowed, 1=Restricted, 2=Not Specified/Unknown 3=Payphone */
-    call->rilCall.namePresentation = strlen(call->name) ? 0 : 2;
-    call->rilCall.numberPresentation = strlen(call->number) ? 0 : 2;
+    call->rilCall.namePresentation = call->name[0] ? 0 : 2;
+    call->rilCall.numberPresentation = call->number[0] ? 0 : 2;
+    int incoming = call->rilCall.isMT;
+    pthread_mutex_unlock(&lock);
 
-    call->obj = dbus_g_proxy_new_for_name(connection, OFONO_SERVICE,
-                                          objPath, OFONO_IFACE_CALL);
-    if (call->obj) {
+    if (obj) {
         // signal PropertyChanged(string property, variant value)
-        dbus_g_proxy_add_signal(call->obj, OFONO_SIGNAL_PROPERTY_CHANGED,
+        dbus_g_proxy_add_signal(obj, OFONO_SIGNAL_PROPERTY_CHANGED,
                                 G_TYPE_STRING, G_TYPE_VALUE, G_TYPE_INVALID);
-        dbus_g_proxy_connect_signal(call->obj,
+        dbus_g_proxy_connect_signal(obj,
                                     OFONO_SIGNAL_PROPERTY_CHANGED,
-                                    G_CALLBACK(callPropertyChanged), 0, NULL);
+                                    G_CALLBACK(callPropertyChanged),
+                                    GINT_TO_POINTER(slot), NULL);
 
         // signal DisconnectReason(string reason)
-        dbus_g_proxy_add_signal(call->obj, OFONO_SIGNAL_DISCONNECT_REASON,
+        dbus_g_proxy_add_signal(obj, OFONO_SIGNAL_DISCONNECT_REASON,
                                 G_TYPE_STRING, G_TYPE_INVALID);
-        dbus_g_proxy_connect_signal(call->obj,
+        dbus_g_proxy_connect_signal(obj,
                                     OFONO_SIGNAL_DISCONNECT_REASON,
                                     G_CALLBACK(callDisconnectReason), 0, NULL);
     }
 
-    pthread_mutex_lock(&lock);
-    voiceCalls = g_slist_append(voiceCalls, call);
-    pthread_mutex_unlock(&lock);
-
-    RIL_onUnsolicitedResponse(RIL_UNSOL_RESPONSE_CALL_STATE_CHANGED, 0, 0);
+    if (incoming)
+        RIL_onUnsolicitedResponse(RIL_UNSOL_CALL_RING, 0, 0);
+    sendCallStateChanged(NULL);
+    signalHandled(STATS_SIGNAL_CALL_ADDED, start);
 }
 
 static void vcmCallRemoved(DBusGProxy *proxy, const char *objPath, gpointer priv)
 {
+    uint64_t start = statsNow();
     LOGD("vcmCallRemoved: %s", objPath);
 
-    GSList *l;
+    DBusGProxy *obj = NULL;
     int found = 0;
+    int slot = 0;
 
     pthread_mutex_lock(&lock);
-    for (l = voiceCalls; l; l = l->next) {
-        ORIL_Call *call = (ORIL_Call*) l->data;
-        if (!g_strcmp0(objPath, call->objPath)) {
-            found = 1;
-            dbus_g_proxy_disconnect_signal(call->obj,
-                                           OFONO_SIGNAL_PROPERTY_CHANGED,
-                                           G_CALLBACK(callPropertyChanged), 0);
-            dbus_g_proxy_disconnect_signal(call->obj, OFONO_SIGNAL_DISCONNECT_REASON,
-                                           G_CALLBACK(callDisconnectReason), 0);
-            free(call);
-            voiceCalls = g_slist_delete_link(voiceCalls, l);
-            break;
-        }
+    ORIL_Call *call = callByPath(objPath);
+    if (call) {
+        found = 1;
+        slot = call - voiceCalls;
+        obj = call->obj;
+        memset(call, 0, sizeof(ORIL_Call));
     }
     pthread_mutex_unlock(&lock);
 
-    RIL_onUnsolicitedResponse(RIL_UNSOL_RESPONSE_CALL_STATE_CHANGED, 0, 0);
+    if (obj) {
+        dbus_g_proxy_disconnect_signal(obj,
+                                       OFONO_SIGNAL_PROPERTY_CHANGED,
+                                       G_CALLBACK(callPropertyChanged),
+                                       GINT_TO_POINTER(slot));
+        dbus_g_proxy_disconnect_signal(obj, OFONO_SIGNAL_DISCONNECT_REASON,
+                                       G_CALLBACK(callDisconnectReason), 0);
+        g_object_unref(obj);
+    }
+
+    sendCallStateChanged(NULL);
     if (!found)
         LOGE("call not found: %s", objPath);
+    signalHandled(STATS_SIGNAL_CALL_REMOVED, start);
+}
+
+/* Calls went away without CallRemoved (ofono is gone) */
+static void callsDropAll()
+{
+    DBusGProxy *objs[MAX_CALLS] = { NULL };
+    int count = 0;
+    int i;
+
+    pthread_mutex_lock(&lock);
+    for (i = 0; i < MAX_CALLS; i++) {
+        if (!voiceCalls[i].objPath[0])
+            continue;
+        objs[i] = voiceCalls[i].obj;
+        memset(&voiceCalls[i], 0, sizeof(ORIL_Call));
+        count++;
+    }
+    pthread_mutex_unlock(&lock);
+
+    for (i = 0; i < MAX_CALLS; i++) {
+        DBusGProxy *obj = objs[i];
+        if (!obj)
+            continue;
+        dbus_g_proxy_disconnect_signal(obj,
+                                       OFONO_SIGNAL_PROPERTY_CHANGED,
+                                       G_CALLBACK(callPropertyChanged),
+                                       GINT_TO_POINTER(i));
+        dbus_g_proxy_disconnect_signal(obj, OFONO_SIGNAL_DISCONNECT_REASON,
+                                       G_CALLBACK(callDisconnectReason), 0);
+        g_object_unref(obj);
+    }
+
+    if (count) {
+        LOGW("%d call(s) dropped", count);
+        sendCallStateChanged(NULL);
+    }
 }
 
 static void audioSettingsPropertyChanged(DBusGProxy *proxy, const gchar *property,
                                          GValue *value, gpointer priv)
 {
     // XXX
-    LOGW("audioSettingsPropertyChanged %s->%s", property, g_strdup_value_contents(value));
+    LOG_PROPERTY(W, "audioSettingsPropertyChanged", property, value);
     if (!g_strcmp0(property, "Active"))
         cmtAudioSetActive(g_value_get_boolean(value) ? 1 : 0);
 }
@@ -1814,13 +2844,19 @@ static void sim_property_changed(DBusGProxy *proxy, const gchar *property,
                                  GValue *value, gpointer user_data)
 {
     // XXX
-    LOGW("sim_property_changed %s->%s", property, g_strdup_value_contents(value));
+    LOG_PROPERTY(W, "sim_property_changed", property, value);
 
     // sometimes we don't have IMSI at interface creation time
-    // may be property is changing now?
-    if (!simIMSI[0] && !g_strcmp0(property, "SubscriberIdentity")) {
-        strncpy(simIMSI, g_value_peek_pointer(value), sizeof(simIMSI));
-        RIL_onUnsolicitedResponse(RIL_UNSOL_RESPONSE_SIM_STATUS_CHANGED, 0, 0);
+    // may be property is changing now? Or a different SIM than cached
+    if (!g_strcmp0(property, "SubscriberIdentity")) {
+        const char *imsi = g_value_peek_pointer(value);
+        if (imsi && strcmp(simIMSI, imsi)) {
+            if (simIMSI[0])
+                LOGW("IMSI differs from the cached one");
+            strncpy(simIMSI, imsi, sizeof(simIMSI) - 1);
+            identitySet(IDENTITY_IMSI, simIMSI);
+            RIL_onUnsolicitedResponse(RIL_UNSOL_RESPONSE_SIM_STATUS_CHANGED, 0, 0);
+        }
     }
     else if (SIM_ABSENT == simStatus && !g_strcmp0(property, "Present")) {
         simStatus = g_value_get_boolean(value) ? SIM_READY : SIM_ABSENT;
@@ -1852,15 +2888,17 @@ static void supsrvPropertyChanged(DBusGProxy *proxy, const gchar *property,
 static void supsrvRequestReceived(DBusGProxy *proxy, const gchar *message,
                                   gpointer user_data)
 {
+    uint64_t start = statsNow();
     // XXX
     LOGW("supsrvRequestReceived %s", message);
+    signalHandled(STATS_SIGNAL_REQUEST_RECEIVED, start);
 }
 
 static void sms_property_changed(DBusGProxy *proxy, const gchar *property,
                                  GValue *value, gpointer user_data)
 {
     // XXX
-    LOGW("sms_property_changed %s->%s", property, g_strdup_value_contents(value));
+    LOG_PROPERTY(W, "sms_property_changed", property, value);
     g_value_unset(value);
 }
 
@@ -1870,34 +2908,39 @@ static void smsImmediateMessage(DBusGProxy *proxy, const gchar *message,
     LOGD("smsImmediateMessage: %s", message);
 }
 
-extern int encodePDU(unsigned char *pdu, const char *message, const char *smsc, const char *sender);
-
 static void smsIncomingMessage(DBusGProxy *proxy, const gchar *message,
                                GHashTable *dict, gpointer userData)
 {
-    // TODO: more accurate guess about buffer length
-    unsigned char *pdu = malloc(240 + strlen(message)*4);
+    uint64_t start = statsNow();
 
     LOGD("smsIncomingMessage: %s", message);
     g_hash_table_foreach(dict, (GHFunc)hash_entry_gvalue_print, NULL);
     GValue *sender = g_hash_table_lookup(dict, "Sender");
 
     if (sender) {
-        if (encodePDU(pdu, message, "+79168999100", g_value_peek_pointer(sender))) {
-            LOGD("PDU: %s", pdu);
-            RIL_onUnsolicitedResponse(RIL_UNSOL_RESPONSE_NEW_SMS, pdu, sizeof(char*));
+        char **pdus;
+        int count = encodeDeliverPDUs(message, "+79168999100", g_value_peek_pointer(sender),
+                                      FALSE, &pdus);
+        int i;
+
+        // long messages arrive as a concatenated series, reassembled by the framework
+        for (i = 0; i < count; i++) {
+            LOGD("PDU %d/%d: %s", i + 1, count, pdus[i]);
+            RIL_onUnsolicitedResponse(RIL_UNSOL_RESPONSE_NEW_SMS, pdus[i], sizeof(char*));
         }
+        if (count)
+            g_free(pdus);
         g_value_unset(sender);
     }
     //g_hash_table_destroy(dict);
-    free(pdu);
+    signalHandled(STATS_SIGNAL_INCOMING_MESSAGE, start);
 }
 
 static void connman_property_changed(DBusGProxy *proxy, const gchar *property,
                                      GValue *value, gpointer user_data)
 {
     // XXX
-    LOGW("connman_property_changed %s->%s", property, g_strdup_value_contents(value));
+    LOG_PROPERTY(W, "connman_property_changed", property, value);
 
     if (!g_strcmp0(property, "Attached")) {
         connmanAttached = g_value_get_boolean(value);
@@ -1912,11 +2955,14 @@ static void pdc_property_changed(DBusGProxy *proxy, const gchar *property,
                                  GValue *value, gpointer user_data)
 {
     // XXX
-    LOGW("pcd_property_changed %s->%s", property, g_strdup_value_contents(value));
+    LOG_PROPERTY(W, "pcd_property_changed", property, value);
     if (!g_strcmp0(property, "Active")) {
+        gboolean wasActive = pdcActive;
         pdcActive = g_value_get_boolean(value);
         if (pdcActive) {
             getIP();
+        } else if (wasActive) {
+            requestDataCallList(NULL);
         }
     }
     g_value_unset(value);
@@ -1925,82 +2971,84 @@ static void pdc_property_changed(DBusGProxy *proxy, const gchar *property,
 static void netregPropertyChanged(DBusGProxy *proxy, const gchar *property,
                                   GValue *value, gpointer user_data)
 {
-    if (!g_strcmp0(property, "Strength")) {
-        //LOGD("Strength: %u, screenState=%d", g_value_get_uint(value), screenState);
-        if (screenState) {
-            netregStrength = (unsigned int)g_value_get_uchar(value);
-            requestSignalStrength(0, 0, 0);
-        }
-        g_value_unset(value);
-        return;
-    }
-    else if (!g_strcmp0(property, "BaseStation")) {
-        // Shut it up
-        return;
-    }
-    else if (!g_strcmp0(property, "CellId")) {
-        netregCID = g_value_get_uint(value);
-    }
-    else if (!g_strcmp0(property, "LocationAreaCode")) {
-        netregLAC = g_value_get_uint(value);
-    }
-    else if (!g_strcmp0(property, "Status")) {
-        const gchar *status = g_value_peek_pointer(value);
-        if (!g_strcmp0(status, "searching")) {
-            netregStatus = 2; // Not registered, but MT is currently searching
-        }
-        else if (!g_strcmp0(status, "registered")) {
-            netregStatus = 1;
-        }
-        else if (!g_strcmp0(status, "roaming")) {
-            netregStatus = 5;
-        }
-        else {
-            netregStatus = 0; // Not registered, not searching
-            netregMCC[0] = 0;
-            netregMNC[0] = 0;
-            netregOperator[0] = 0;
-        }
-    }
-    else if (!g_strcmp0(property, "Name")) {
-        snprintf(netregOperator, sizeof(netregOperator), "%s",
-                 (const char* )g_value_peek_pointer(value));
-    }
-    else if (!g_strcmp0(property, "MobileNetworkCode")) {
-        snprintf(netregMNC, sizeof(netregMNC), "%s",
-                 (const char*) g_value_peek_pointer(value));
-    }
-    else if (!g_strcmp0(property, "MobileCountryCode")) {
-        snprintf(netregMCC, sizeof(netregMCC), "%s",
-                 (const char*) g_value_peek_pointer(value));
-    }
-    else if (!g_strcmp0(property, "Technology")) {
-        const gchar *tech = g_value_peek_pointer(value);
-        if (!g_strcmp0(tech, "gsm")){
-            netregTech = 1;
-        }else if (!g_strcmp0(tech, "edge")){
-            netregTech = 2;
-        }else if (!g_strcmp0(tech, "umts")){
-            netregTech = 3;
-        }else if (!g_strcmp0(tech, "hspa")){
-            netregTech = 11;
-        }else if (!g_strcmp0(tech, "lte")){
-            /* RIL doesn't support LTE, report unknown */
-            netregTech = 11;
-        }
-    }
-    else if (!g_strcmp0(property, "Mode")) {
-        const gchar *mode = g_value_peek_pointer(value);
-        if (!g_strcmp0(mode, "auto")){
-            netregMode = 0;
-        }else if (!g_strcmp0(mode, "manual")){
-            netregMode = 1;
-        }
+    switch (ofonoString(property)) {
+        case OFONO_PROP_STRENGTH:
+            //LOGD("Strength: %u, screenState=%d", g_value_get_uint(value), screenState);
+            if (screenState) {
+                netregStrength = (unsigned int)g_value_get_uchar(value);
+                requestSignalStrength(0, 0, 0);
+            }
+            g_value_unset(value);
+            return;
+        case OFONO_PROP_BASE_STATION:
+            // Shut it up
+            return;
+        case OFONO_PROP_CELL_ID:
+            netregCID = g_value_get_uint(value);
+            break;
+        case OFONO_PROP_LAC:
+            netregLAC = g_value_get_uint(value);
+            break;
+        case OFONO_PROP_STATUS:
+            switch (ofonoString(g_value_peek_pointer(value))) {
+                case OFONO_STATUS_SEARCHING:
+                    netregStatus = 2; // Not registered, but MT is currently searching
+                    break;
+                case OFONO_STATUS_REGISTERED:
+                    netregStatus = 1;
+                    break;
+                case OFONO_STATUS_ROAMING:
+                    netregStatus = 5;
+                    break;
+                default:
+                    netregStatus = 0; // Not registered, not searching
+                    netregMCC[0] = 0;
+                    netregMNC[0] = 0;
+                    netregOperator[0] = 0;
+                    break;
+            }
+            break;
+        case OFONO_PROP_NAME:
+            snprintf(netregOperator, sizeof(netregOperator), "%s",
+                     (const char* )g_value_peek_pointer(value));
+            if (netregOperator[0])
+                identitySet(IDENTITY_OPERATOR, netregOperator);
+            break;
+        case OFONO_PROP_MNC:
+            snprintf(netregMNC, sizeof(netregMNC), "%s",
+                     (const char*) g_value_peek_pointer(value));
+            if (netregMNC[0])
+                identitySet(IDENTITY_MNC, netregMNC);
+            break;
+        case OFONO_PROP_MCC:
+            snprintf(netregMCC, sizeof(netregMCC), "%s",
+                     (const char*) g_value_peek_pointer(value));
+            if (netregMCC[0])
+                identitySet(IDENTITY_MCC, netregMCC);
+            break;
+        case OFONO_PROP_TECHNOLOGY:
+            switch (ofonoString(g_value_peek_pointer(value))) {
+                case OFONO_TECH_GSM:  netregTech = 1; break;
+                case OFONO_TECH_EDGE: netregTech = 2; break;
+                case OFONO_TECH_UMTS: netregTech = 3; break;
+                case OFONO_TECH_HSPA: netregTech = 11; break;
+                /* RIL doesn't support LTE, report unknown */
+                case OFONO_TECH_LTE:  netregTech = 11; break;
+                default: break;
+            }
+            break;
+        case OFONO_PROP_MODE:
+            switch (ofonoString(g_value_peek_pointer(value))) {
+                case OFONO_MODE_AUTO:   netregMode = 0; break;
+                case OFONO_MODE_MANUAL: netregMode = 1; break;
+                default: break;
+            }
+            break;
+        default:
+            break;
     }
 
-    gchar *valStr = g_strdup_value_contents(value);
-    LOGW("netreg_property_changed %s->%s", property, valStr);
-    g_free(valStr);
+    LOG_PROPERTY(W, "netreg_property_changed", property, value);
     sendNetworkStateChanged();
     g_value_unset(value);
 }
@@ -2008,7 +3056,7 @@ static void netregPropertyChanged(DBusGProxy *proxy, const gchar *property,
 static void radiosettingsPropertyChanged(DBusGProxy *proxy, const gchar *property,
                                          GValue *value, gpointer user_data)
 {
-    LOGD("RadioSettings property changed %s",property); 
+    LOG_RATELIMITED(D, "RadioSettings property changed %s", property);
 }
 
 static void initVoiceCallInterfaces()
@@ -2016,13 +3064,8 @@ static void initVoiceCallInterfaces()
     vcm = dbus_g_proxy_new_for_name(connection, OFONO_SERVICE, MODEM, OFONO_IFACE_CALLMAN);
     if (vcm) {
         // VoiceCallManager.PropertyChanged
-        dbus_g_proxy_add_signal(vcm, OFONO_SIGNAL_PROPERTY_CHANGED,
-                                G_TYPE_STRING, G_TYPE_VALUE,
-                                G_TYPE_INVALID);
-
-        dbus_g_proxy_connect_signal(vcm,
-                                    OFONO_SIGNAL_PROPERTY_CHANGED,
-                                    G_CALLBACK(vcmPropertyChanged), vcm, NULL);
+        watchProperties(vcm, G_CALLBACK(vcmPropertyChanged),
+                        STATS_SIGNAL_VCM);
 
         // VoiceCallManager.CallAdded
         dbus_g_proxy_add_signal(vcm, OFONO_SIGNAL_CALL_ADDED,
@@ -2049,11 +3092,8 @@ static void initSimInterface()
 {
     sim = dbus_g_proxy_new_for_name(connection, OFONO_SERVICE, MODEM, OFONO_IFACE_SIMMANAGER);
     if (sim) {
-        dbus_g_proxy_add_signal(sim, OFONO_SIGNAL_PROPERTY_CHANGED,
-                                G_TYPE_STRING, G_TYPE_VALUE, G_TYPE_INVALID);
-        dbus_g_proxy_connect_signal(sim,
-                                    OFONO_SIGNAL_PROPERTY_CHANGED,
-                                    G_CALLBACK(sim_property_changed), sim, NULL);
+        watchProperties(sim, G_CALLBACK(sim_property_changed),
+                        STATS_SIGNAL_SIM);
         LOGW("Sim proxy created");
 
 #if 0
@@ -2080,17 +3120,112 @@ static void initSimInterface()
         LOGE("Failed to create SIM proxy object");
 }
 
+static void attachContext(const char *pdcPath)
+{
+    LOGD("pdcPath: %s", pdcPath);
+    pdc = dbus_g_proxy_new_for_name(connection, OFONO_SERVICE, pdcPath, OFONO_IFACE_PDC);
+    if (pdc) {
+        watchProperties(pdc, G_CALLBACK(pdc_property_changed),
+                        STATS_SIGNAL_PDC);
+        LOGW("PrimaryDataContext proxy created");
+    }
+    else
+        LOGE("Failed to create PrimaryDataContext proxy object");
+}
+
+static gboolean pdcReleaseIdle(gpointer data)
+{
+    g_object_unref(data);
+    return FALSE;
+}
+
+/* The context is gone or another one is first now */
+static void detachContext()
+{
+    DBusGProxy *old = pdc;
+
+    LOGW("dropping context %s", dbus_g_proxy_get_path(old));
+    pdc = NULL;
+    unwatchProperties(old, G_CALLBACK(pdc_property_changed), STATS_SIGNAL_PDC);
+    // the request thread may have just read pdc, release it on the next iteration
+    g_idle_add(pdcReleaseIdle, old);
+
+    if (pdcActive) {
+        pdcActive = FALSE;
+        requestDataCallList(NULL);
+    }
+}
+
+static void addContextReply(OfonoRequest *req, DBusGProxyCall *call)
+{
+    GError *error = NULL;
+    char *pdcPath = NULL;
+
+    if (!dbus_g_proxy_end_call(req->proxy, call, &error,
+                               DBUS_TYPE_G_OBJECT_PATH, &pdcPath,
+                               G_TYPE_INVALID))
+    {
+        LOGE("ConnMan.AddContext failed: %s", error->message);
+        g_error_free(error);
+        return;
+    }
+    if (!pdc)
+        attachContext(pdcPath);
+    g_free(pdcPath);
+}
+
+static void getContextsReply(OfonoRequest *req, DBusGProxyCall *call)
+{
+    GError *error = NULL;
+    GPtrArray *arrContexts = 0;
+
+    if (!dbus_g_proxy_end_call(req->proxy, call, &error,
+                               type_a_oa_sv, &arrContexts,
+                               G_TYPE_INVALID))
+    {
+        LOGE("initConnManager: GetContexts error: %s", error->message);
+        LOGW("New context will be created");
+        g_error_free(error);
+    }
+
+    // we'll use first found context
+    if (arrContexts && arrContexts->len) {
+        GValueArray *ctx = g_ptr_array_index(arrContexts, 0);
+        const char *pdcPath = g_value_get_boxed(g_value_array_get_nth(ctx, 0));
+        if (pdc && g_strcmp0(dbus_g_proxy_get_path(pdc), pdcPath))
+            detachContext();
+        if (!pdc)
+            attachContext(pdcPath);
+        else
+            propertiesReseed(pdc);
+    } else {
+        if (pdc)
+            detachContext();
+        // create new context if nothing found
+        OfonoRequest *add = ofonoRequestNew(connman, "AddContext", addContextReply, 0);
+        ofonoRequestAddString(add, "internet");
+        ofonoRequestAddString(add, "internet");
+        ofonoRequestStart(add);
+    }
+
+    if (arrContexts)
+        g_boxed_free(type_a_oa_sv, arrContexts);
+}
+
+/* Contexts come and go with ConnectionManager (and ofono), look again */
+static void reattachConnManager()
+{
+    ofonoRequestStart(ofonoRequestNew(connman, "GetContexts", getContextsReply, 0));
+}
+
 static void initConnManager()
 {
     LOGD("initConnManager");
     // DataConnectionManager
     connman = dbus_g_proxy_new_for_name(connection, OFONO_SERVICE, MODEM, OFONO_IFACE_CONNMAN);
     if (connman) {
-        dbus_g_proxy_add_signal(connman, OFONO_SIGNAL_PROPERTY_CHANGED,
-                                G_TYPE_STRING, G_TYPE_VALUE, G_TYPE_INVALID);
-        dbus_g_proxy_connect_signal(connman,
-                                    OFONO_SIGNAL_PROPERTY_CHANGED,
-                                    G_CALLBACK(connman_property_changed), connman, NULL);
+        watchProperties(connman, G_CALLBACK(connman_property_changed),
+                        STATS_SIGNAL_CONNMAN);
         LOGW("DataConnectionManager proxy created");
     }
     else {
@@ -2098,286 +3233,584 @@ static void initConnManager()
         return;
     }
 
-    // find existing context
+    // find existing context, the reply creates one if there's none
     LOGD("Trying to find existing context");
-    char *pdcPath = NULL;
-    GPtrArray *arrContexts = 0;
-    GError *error = NULL;
-    if (!dbus_g_proxy_call(connman, "GetContexts", &error, G_TYPE_INVALID,
-                           type_a_oa_sv, &arrContexts,
-                           G_TYPE_INVALID))
-    {
-        LOGE("initConnManager: GetContexts error: %s", error->message);
-        LOGW("New context will be created");
+    ofonoRequestStart(ofonoRequestNew(connman, "GetContexts", getContextsReply, 0));
+}
+
+static void initNetRegInterface()
+{
+    netreg = dbus_g_proxy_new_for_name(connection, OFONO_SERVICE, MODEM, OFONO_IFACE_NETREG);
+    if (netreg) {
+        watchProperties(netreg, G_CALLBACK(netregPropertyChanged),
+                        STATS_SIGNAL_NETREG);
+        LOGW("NetReg proxy created");
     }
+    else
+        LOGE("Failed to create NetReg proxy object");
+}
 
-    // we'll use first found context
-    if (arrContexts && arrContexts->len) {
-        GValueArray *ctx = g_ptr_array_index(arrContexts, 0);
-        pdcPath = g_strdup(g_value_get_boxed(g_value_array_get_nth(ctx, 0)));
-        LOGD("existing pdcPath: %s", pdcPath);
+static void initRadioSettingsInterface()
+{
+    radiosettings = dbus_g_proxy_new_for_name(connection, OFONO_SERVICE, MODEM, OFONO_IFACE_RADIOSETTINGS);
+    if (radiosettings) {
+        watchProperties(radiosettings, G_CALLBACK(radiosettingsPropertyChanged),
+                        STATS_SIGNAL_RADIOSETTINGS);
+        LOGW("RadioSettings proxy created");
     }
+    else
+        LOGE("Failed to create RadioSettings proxy object");
+}
 
-    if (!pdcPath) {
-        // create new context if nothing found
-        GError *error = NULL;
-        LOGD("ConnMan.CreateContext preparing for crash...");
-        if ( !dbus_g_proxy_call(connman, "AddContext", &error,
-                                G_TYPE_STRING, "internet",
-                                G_TYPE_STRING, "internet",
-                                G_TYPE_INVALID,
-                                DBUS_TYPE_G_PROXY, &pdc, G_TYPE_INVALID) )
-        {
-            LOGE("ConnMan.CreateContext failed: %s", error->message);
-            g_error_free (error);
-            return;
+static void initMessageInterface()
+{
+    sms = dbus_g_proxy_new_for_name(connection, OFONO_SERVICE, MODEM, OFONO_IFACE_SMSMAN);
+    if (sms) {
+        watchProperties(sms, G_CALLBACK(sms_property_changed),
+                        STATS_SIGNAL_SMS);
+
+        dbus_g_proxy_add_signal(sms, OFONO_SIGNAL_IMMEDIATE_MESSAGE,
+                                G_TYPE_STRING,
+                                dbus_g_type_get_map("GHashTable", G_TYPE_STRING, G_TYPE_VALUE),
+                                G_TYPE_INVALID);
+        dbus_g_proxy_connect_signal(sms, OFONO_SIGNAL_IMMEDIATE_MESSAGE,
+                                    G_CALLBACK(smsImmediateMessage), sms, 0);
+
+        dbus_g_proxy_add_signal(sms, OFONO_SIGNAL_INCOMING_MESSAGE,
+                                G_TYPE_STRING,
+                                dbus_g_type_get_map("GHashTable", G_TYPE_STRING, G_TYPE_VALUE),
+                                G_TYPE_INVALID);
+        dbus_g_proxy_connect_signal(sms, OFONO_SIGNAL_INCOMING_MESSAGE,
+                                    G_CALLBACK(smsIncomingMessage), sms, 0);
+        LOGW("SmsManager proxy created");
+    }
+    else
+        LOGE("Failed to create SmsMan proxy object");
+}
+
+static void initSupplementaryServicesInterface()
+{
+    supsrv = dbus_g_proxy_new_for_name(connection, OFONO_SERVICE, MODEM, OFONO_IFACE_SUPSRV);
+    if (supsrv) {
+        watchProperties(supsrv, G_CALLBACK(supsrvPropertyChanged),
+                        STATS_SIGNAL_SUPSRV);
+
+        dbus_g_proxy_add_signal(supsrv, OFONO_SIGNAL_REQUEST_RECEIVED,
+                                G_TYPE_STRING, G_TYPE_INVALID);
+        dbus_g_proxy_connect_signal(supsrv, OFONO_SIGNAL_REQUEST_RECEIVED,
+                                    G_CALLBACK(supsrvRequestReceived), supsrv, 0);
+
+        LOGW("SupplementaryServices proxy created");
+    }
+    else
+        LOGE("Failed to create SupplementaryServices proxy object");
+}
+
+static void initAudioSettingsInterface()
+{
+    audioSettings = dbus_g_proxy_new_for_name(connection, OFONO_SERVICE, MODEM, OFONO_IFACE_AUDIOSETTINGS);
+    if (audioSettings) {
+        watchProperties(audioSettings, G_CALLBACK(audioSettingsPropertyChanged),
+                        STATS_SIGNAL_AUDIOSETTINGS);
+        LOGW("AudioSettings proxy created");
+    }
+    else
+        LOGE("Failed to create AudioSettings proxy object");
+}
+
+/* Modem interfaces we attach to, in the order they're set up */
+static const struct {
+    const gchar *iface;
+    DBusGProxy  **proxy;
+    void        (*init)();
+    void        (*reattach)();  // optional, after the proxy is reseeded
+} modemInterfaces[] = {
+    { OFONO_IFACE_CALLMAN,          &vcm,           initVoiceCallInterfaces },
+    { OFONO_IFACE_SIMMANAGER,       &sim,           initSimInterface },
+    { OFONO_IFACE_NETREG,           &netreg,        initNetRegInterface },
+    { OFONO_IFACE_RADIOSETTINGS,    &radiosettings, initRadioSettingsInterface },
+    { OFONO_IFACE_SMSMAN,           &sms,           initMessageInterface },
+    { OFONO_IFACE_SUPSRV,           &supsrv,        initSupplementaryServicesInterface },
+    { OFONO_IFACE_AUDIOSETTINGS,    &audioSettings, initAudioSettingsInterface },
+    { OFONO_IFACE_CONNMAN,          &connman,       initConnManager,    reattachConnManager },
+};
+
+// listed in Modem.Interfaces, main loop thread only
+static gboolean interfacePresent[G_N_ELEMENTS(modemInterfaces)];
+
+static gboolean interfaceListed(const gchar **ifArr, const gchar *iface)
+{
+    for (; *ifArr; ifArr++)
+        if (!g_strcmp0(*ifArr, iface))
+            return TRUE;
+    return FALSE;
+}
+
+/*
+ * Create proxies for the interfaces that just appeared. None of the init
+ * functions waits for ofono, so the initial queries of all of them are in
+ * flight together and applied as they come back. The proxies aren't
+ * dropped when an interface goes away (the modem went offline), they are
+ * seeded again when it's listed again.
+ */
+static void attachInterfaces(const gchar **ifArr)
+{
+    const gchar **iface;
+    unsigned i;
+
+    LOGD("Interfaces:");
+    for (iface = ifArr; *iface; iface++)
+        LOGD("  >> %s", *iface);
+
+    for (i = 0; i < G_N_ELEMENTS(modemInterfaces); i++) {
+        DBusGProxy *proxy = *modemInterfaces[i].proxy;
+        gboolean listed = interfaceListed(ifArr, modemInterfaces[i].iface);
+
+        if (listed && !interfacePresent[i]) {
+            if (!proxy) {
+                modemInterfaces[i].init();
+            } else {
+                LOGD("%s is back", modemInterfaces[i].iface);
+                propertiesReseed(proxy);
+                if (modemInterfaces[i].reattach)
+                    modemInterfaces[i].reattach();
+            }
+        } else if (!listed && interfacePresent[i]) {
+            LOGD("%s is gone", modemInterfaces[i].iface);
         }
-        dbus_g_proxy_set_interface(pdc, OFONO_IFACE_PDC);
+        interfacePresent[i] = listed;
     }
-    else {
-        // create org.ofono.PrimaryDataContext proxy
-        LOGD("pdcPath: %s", pdcPath);
-        pdc = dbus_g_proxy_new_for_name(connection, OFONO_SERVICE, pdcPath, OFONO_IFACE_PDC);
-        g_free(pdcPath);
+}
+
+/*** Radio power ***/
+
+/*
+ * Airplane mode only takes the modem offline. It stays powered, so most
+ * of its interfaces and all our proxies survive and leaving airplane mode
+ * is a single Online round trip. Powered is set when ofono reports the
+ * modem off: at first start or after the modem went away.
+ *
+ * radioSync() moves the modem one step towards what the framework asked
+ * for and is called again whenever a step is done or the modem changes
+ * on its own. Online can only be set once the modem has the "rat"
+ * feature. RADIO_POWER completes when the modem is powered (on) or
+ * offline (off), the toggle is timed until it's online or offline.
+ * Main loop thread only.
+ */
+
+typedef enum {
+    RADIO_STEP_NONE,
+    RADIO_STEP_POWER_UP,
+    RADIO_STEP_ONLINE,
+    RADIO_STEP_OFFLINE,
+} RadioStep;
+
+typedef struct {
+    int on;
+    RIL_Token t;
+} RadioPowerRequest;
+
+static int radioWanted = -1;        // last RADIO_POWER, -1 before the first
+static RIL_Token radioToken;        // RADIO_POWER waiting for radioSync()
+static RadioStep radioStep;         // SetProperty in flight
+static uint64_t radioToggleStart;   // 0 when not timing a toggle
+static gboolean modemPowered, modemOnline, modemHasRat;
+
+static void radioComplete(RIL_Errno e)
+{
+    if (radioToken) {
+        RIL_onRequestComplete(radioToken, e, NULL, 0);
+        radioToken = 0;
     }
+}
 
-    if (pdc) {
-        dbus_g_proxy_add_signal(pdc, OFONO_SIGNAL_PROPERTY_CHANGED,
-                                G_TYPE_STRING, G_TYPE_VALUE, G_TYPE_INVALID);
-        dbus_g_proxy_connect_signal(pdc,
-                                    OFONO_SIGNAL_PROPERTY_CHANGED,
-                                    G_CALLBACK(pdc_property_changed), pdc, NULL);
-        LOGW("PrimaryDataContext proxy created");
+static void radioSync();
+
+static void radioSetReply(OfonoRequest *req, DBusGProxyCall *call)
+{
+    GError *error = NULL;
+    RadioStep step = radioStep;
+
+    radioStep = RADIO_STEP_NONE;
+    if (!dbus_g_proxy_end_call(req->proxy, call, &error, G_TYPE_INVALID)) {
+        // no retry, the next RADIO_POWER or modem change will
+        LOGE("Modem.SetProperty failed: %s", error->message);
+        g_error_free(error);
+        radioToggleStart = 0;
+        radioComplete(RIL_E_GENERIC_FAILURE);
+        return;
     }
+
+    // PropertyChanged may come after the reply
+    if (RADIO_STEP_POWER_UP == step)
+        modemPowered = TRUE;
     else
-        LOGE("Failed to create PrimaryDataContext proxy object");
+        modemOnline = RADIO_STEP_ONLINE == step;
+    radioSync();
+}
+
+static void radioSet(RadioStep step, const gchar *prop, gboolean on)
+{
+    GValue value = G_VALUE_INITIALIZATOR;
+    g_value_init(&value, G_TYPE_BOOLEAN);
+    g_value_set_boolean(&value, on);
+
+    LOGD("radio: setting %s %s", prop, on ? "on" : "off");
+    radioStep = step;
+    OfonoRequest *req = ofonoRequestNew(modem, "SetProperty", radioSetReply, 0);
+    ofonoRequestAddString(req, prop);
+    ofonoRequestAddValue(req, &value);
+    ofonoRequestStart(req);
+}
+
+static void radioSync()
+{
+    if (radioWanted < 0 || RADIO_STEP_NONE != radioStep || !modem)
+        return;
+
+    if (radioWanted) {
+        if (!modemPowered) {
+            radioSet(RADIO_STEP_POWER_UP, "Powered", TRUE);
+            return;
+        }
+        radioComplete(RIL_E_SUCCESS);
+        if (!modemOnline) {
+            if (modemHasRat)
+                radioSet(RADIO_STEP_ONLINE, "Online", TRUE);
+            return;
+        }
+        if (RADIO_STATE_OFF == sState || RADIO_STATE_UNAVAILABLE == sState)
+            setRadioState(RADIO_STATE_SIM_READY);
+    } else {
+        if (modemOnline) {
+            radioSet(RADIO_STEP_OFFLINE, "Online", FALSE);
+            return;
+        }
+        radioComplete(RIL_E_SUCCESS);
+        if (RADIO_STATE_UNAVAILABLE == sState)
+            setRadioState(RADIO_STATE_OFF);
+    }
+
+    if (radioToggleStart) {
+        uint64_t us = statsNow() - radioToggleStart;
+        statsRadioToggle(radioWanted, us);
+        LOGI("radio %s in %llu ms", radioWanted ? "on" : "off",
+             (unsigned long long) us / 1000);
+        radioToggleStart = 0;
+    }
+}
+
+static gboolean radioPowerStart(gpointer data)
+{
+    RadioPowerRequest *req = (RadioPowerRequest *) data;
+
+    // a newer request overrides one still waiting for the modem
+    radioComplete(RIL_E_SUCCESS);
+    radioToken = req->t;
+    radioWanted = req->on;
+    radioToggleStart = statsNow();
+    if (!radioWanted)
+        setRadioState(RADIO_STATE_OFF);
+    g_free(req);
+
+    radioSync();
+    return FALSE;
+}
+
+/* Toggle radio on and off (for "airplane" mode) */
+static void requestRadioPower(void *data, size_t datalen, RIL_Token t)
+{
+    assert (datalen >= sizeof(int));
+
+    RadioPowerRequest *req = g_new(RadioPowerRequest, 1);
+    req->on = ((int *)data)[0] > 0;
+    req->t = t;
+    LOGD("requestRadioPower: %d", req->on);
+    g_idle_add(radioPowerStart, req);
 }
 
 static void modem_property_changed(DBusGProxy *proxy, const gchar *property,
                                    GValue *value, gpointer user_data)
 {
     // XXX
-    LOGD("modem_property_changed: %s->%s", property, g_strdup_value_contents(value));
-
-    if (!vcm && g_strcmp0(property, "Online") == 0) {
-        LOGD("Modem->Onlne: %s", g_value_get_boolean(value) ? "true" : "false");
-        //TODO: what?
-    }
-    else if (g_strcmp0(property, "Interfaces") == 0) {
-        const gchar **ifArr = g_value_peek_pointer(value);
-        LOGD("Interfaces:");
-        while(*ifArr) {
-            LOGD("  >> %s", *ifArr);
-            if (!vcm && !g_strcmp0(*ifArr, OFONO_IFACE_CALLMAN)) {
-                initVoiceCallInterfaces();
-            }
-            else if (!sim && !g_strcmp0(*ifArr, OFONO_IFACE_SIMMANAGER)) {
-                initSimInterface();
-            }
-            else if (!netreg && !g_strcmp0(*ifArr, OFONO_IFACE_NETREG)) {
-                netreg = dbus_g_proxy_new_for_name(connection, OFONO_SERVICE, MODEM, OFONO_IFACE_NETREG);
-                if (netreg) {
-                    dbus_g_proxy_add_signal(netreg, OFONO_SIGNAL_PROPERTY_CHANGED,
-                                            G_TYPE_STRING, G_TYPE_VALUE, G_TYPE_INVALID);
-                    dbus_g_proxy_connect_signal(netreg,
-                                                OFONO_SIGNAL_PROPERTY_CHANGED,
-                                                G_CALLBACK(netregPropertyChanged), netreg, NULL);
-                    LOGW("NetReg proxy created");
-                }
-                else
-                    LOGE("Failed to create NetReg proxy object");
-            }
-            else if (!radiosettings && !g_strcmp0(*ifArr, OFONO_IFACE_RADIOSETTINGS)) {
-                radiosettings = dbus_g_proxy_new_for_name(connection, OFONO_SERVICE, MODEM, OFONO_IFACE_RADIOSETTINGS);
-                if (radiosettings) {
-                    dbus_g_proxy_add_signal(radiosettings, OFONO_SIGNAL_PROPERTY_CHANGED,
-                                            G_TYPE_STRING, G_TYPE_VALUE, G_TYPE_INVALID);
-                    dbus_g_proxy_connect_signal(radiosettings,
-                                                OFONO_SIGNAL_PROPERTY_CHANGED,
-                                                G_CALLBACK(radiosettingsPropertyChanged), radiosettings, NULL);
-                    LOGW("NetReg proxy created");
-                }
-                else
-                    LOGE("Failed to create NetReg proxy object");
-            }
-            else if (!sms && !g_strcmp0(*ifArr, OFONO_IFACE_SMSMAN)) {
-                sms = dbus_g_proxy_new_for_name(connection, OFONO_SERVICE, MODEM, OFONO_IFACE_SMSMAN);
-                if (sms) {
-                    dbus_g_proxy_add_signal(sms, OFONO_SIGNAL_PROPERTY_CHANGED,
-                                            G_TYPE_STRING, G_TYPE_VALUE, G_TYPE_INVALID);
-                    dbus_g_proxy_connect_signal(sms,
-                                                OFONO_SIGNAL_PROPERTY_CHANGED,
-                                                G_CALLBACK(sms_property_changed), sms, NULL);
-
-                    dbus_g_proxy_add_signal(sms, OFONO_SIGNAL_IMMEDIATE_MESSAGE,
-                                            G_TYPE_STRING,
-                                            dbus_g_type_get_map("GHashTable", G_TYPE_STRING, G_TYPE_VALUE),
-                                            G_TYPE_INVALID);
-                    dbus_g_proxy_connect_signal(sms, OFONO_SIGNAL_IMMEDIATE_MESSAGE,
-                                                G_CALLBACK(smsImmediateMessage), sms, 0);
-
-                    dbus_g_proxy_add_signal(sms, OFONO_SIGNAL_INCOMING_MESSAGE,
-                                            G_TYPE_STRING,
-                                            dbus_g_type_get_map("GHashTable", G_TYPE_STRING, G_TYPE_VALUE),
-                                            G_TYPE_INVALID);
-                    dbus_g_proxy_connect_signal(sms, OFONO_SIGNAL_INCOMING_MESSAGE,
-                                                G_CALLBACK(smsIncomingMessage), sms, 0);
-                    LOGW("SmsManager proxy created");
-                }
-                else
-                    LOGE("Failed to create SmsMan proxy object");
-            }
-            else if (!supsrv && !g_strcmp0(*ifArr, OFONO_IFACE_SUPSRV)) {
-                supsrv = dbus_g_proxy_new_for_name(connection, OFONO_SERVICE, MODEM, OFONO_IFACE_SUPSRV);
-                if (supsrv) {
-                    dbus_g_proxy_add_signal(supsrv, OFONO_SIGNAL_PROPERTY_CHANGED,
-                                            G_TYPE_STRING, G_TYPE_VALUE, G_TYPE_INVALID);
-                    dbus_g_proxy_connect_signal(supsrv,
-                                                OFONO_SIGNAL_PROPERTY_CHANGED,
-                                                G_CALLBACK(supsrvPropertyChanged), supsrv, NULL);
-
-                    dbus_g_proxy_add_signal(supsrv, OFONO_SIGNAL_REQUEST_RECEIVED,
-                                            G_TYPE_STRING, G_TYPE_INVALID);
-                    dbus_g_proxy_connect_signal(supsrv, OFONO_SIGNAL_REQUEST_RECEIVED,
-                                                G_CALLBACK(supsrvRequestReceived), supsrv, 0);
-
-                    LOGW("SupplementaryServices proxy created");
-                }
-                else
-                    LOGE("Failed to create SupplementaryServices proxy object");
-            }
-            else if (!audioSettings && !g_strcmp0(*ifArr, OFONO_IFACE_AUDIOSETTINGS)) {
-                audioSettings = dbus_g_proxy_new_for_name(connection, OFONO_SERVICE, MODEM, OFONO_IFACE_AUDIOSETTINGS);
-                if (audioSettings) {
-                    dbus_g_proxy_add_signal(audioSettings, OFONO_SIGNAL_PROPERTY_CHANGED,
-                                            G_TYPE_STRING, G_TYPE_VALUE, G_TYPE_INVALID);
-                    dbus_g_proxy_connect_signal(audioSettings,
-                                                OFONO_SIGNAL_PROPERTY_CHANGED,
-                                                G_CALLBACK(audioSettingsPropertyChanged), audioSettings, NULL);
-                    LOGW("AudioSettings proxy created");
-                }
-                else
-                    LOGE("Failed to create AudioSettings proxy object");
-            }
-            else if (!connman && !g_strcmp0(*ifArr, OFONO_IFACE_CONNMAN)) {
-                initConnManager();
-            }
-            ifArr++;
-        }
+    LOG_PROPERTY(D, "modem_property_changed:", property, value);
+
+    OfonoString prop = ofonoString(property);
+
+    if (prop == OFONO_PROP_ONLINE) {
+        modemOnline = g_value_get_boolean(value);
+        radioSync();
     }
-    else if (g_strcmp0(property, "Powered") == 0) {
-        if (poweredToken) {
-            RIL_onRequestComplete(poweredToken, RIL_E_SUCCESS, NULL, 0);
-            poweredToken = 0;
-        }
+    else if (prop == OFONO_PROP_INTERFACES) {
+        attachInterfaces(g_value_peek_pointer(value));
+    }
+    else if (prop == OFONO_PROP_POWERED) {
+        modemPowered = g_value_get_boolean(value);
+        if (!modemPowered)
+            modemOnline = modemHasRat = FALSE;
+        radioSync();
     }
-    else if (g_strcmp0(property, "Serial") == 0) {
-        strncpy(modemIMEI, g_value_peek_pointer(value), sizeof(modemIMEI));
+    else if (prop == OFONO_PROP_SERIAL) {
+        if (modemIMEI[0] && strcmp(modemIMEI, g_value_peek_pointer(value)))
+            LOGW("IMEI differs from the cached one");
+        strncpy(modemIMEI, g_value_peek_pointer(value), sizeof(modemIMEI) - 1);
+        identitySet(IDENTITY_IMEI, modemIMEI);
         if (imeiToken) {
             RIL_onRequestComplete(imeiToken, RIL_E_SUCCESS,
                                   modemIMEI, sizeof(char *));
             imeiToken = 0;
         }
     }
-    else if (g_strcmp0(property, "Revision") == 0) {
-        strncpy(modemRev, g_value_peek_pointer(value), sizeof(modemRev));
+    else if (prop == OFONO_PROP_REVISION) {
+        if (modemRev[0] && strcmp(modemRev, g_value_peek_pointer(value)))
+            LOGW("baseband revision differs from the cached one");
+        strncpy(modemRev, g_value_peek_pointer(value), sizeof(modemRev) - 1);
+        identitySet(IDENTITY_REVISION, modemRev);
         if (modemRevToken) {
             RIL_onRequestComplete(modemRevToken, RIL_E_SUCCESS, 
                                   modemRev, sizeof(char *));
             modemRevToken = 0;
         }
     }
-    else if (g_strcmp0(property, "Features") == 0) {
+    else if (prop == OFONO_PROP_FEATURES) {
         const gchar **fArr = g_value_peek_pointer(value);
+        gboolean hadRat = modemHasRat;
+        modemHasRat = FALSE;
         while(*fArr) {
             LOGD("  >> %s", *fArr);
-            if (!goingOnline && g_strcmp0(*fArr, "rat") == 0) {
-                LOGW("rat available, going online");
-                GValue value = G_VALUE_INITIALIZATOR;
-                g_value_init(&value, G_TYPE_BOOLEAN);
-                g_value_set_boolean(&value, TRUE);
-                objSetProperty(modem, "Online", &value);
-                goingOnline = 1;
-                setRadioState(RADIO_STATE_SIM_READY);
+            if (g_strcmp0(*fArr, "rat") == 0) {
+                modemHasRat = TRUE;
             }
             else if (g_strcmp0(*fArr, "gprs") == 0) {
                 sendNetworkStateChanged();
             }
             fArr++;
         }
+        if (modemHasRat && !hadRat) {
+            LOGW("rat available");
+            radioSync();
+        }
     }
 
 
     g_value_unset(value);
 }
 
-static int initOfono()
+/*** Bring-up ***/
+
+/*
+ * RIL_Init only connects to the bus and the main loop runs right away.
+ * The modem is attached the moment ofono owns its name and lists the
+ * modem, whichever comes last, so there's no fixed settling delay and
+ * no failure when rild starts before ofono. How long each step took is
+ * reported by OEM_HOOK_STRINGS "stats".
+ */
+
+typedef enum {
+    BRINGUP_WAIT_OFONO,     // org.ofono has no owner
+    BRINGUP_WAIT_MODEM,     // GetModems pending, or the modem isn't there yet
+    BRINGUP_ATTACHED,
+} BringupState;
+
+static BringupState bringupState;   // main loop thread only
+static uint64_t ofonoLostAt;        // 0 unless recovering from an ofono restart
+
+static void attachModem()
 {
-    // give a chance to ofonod for settling
-    sleep(1);
+    if (BRINGUP_ATTACHED == bringupState)
+        return;
+    statsPhase(STATS_PHASE_MODEM);
 
-    GError *error = NULL;
-    connection = dbus_g_bus_get(DBUS_BUS_SYSTEM, &error);
-    if (!connection) {
-        LOGE("Failed to open connection to bus: %s\n", error->message);
-        g_error_free (error);
-        return 0;
+    // the proxy is for the name, it outlives an ofono restart
+    if (!modem) {
+        modem = dbus_g_proxy_new_for_name(connection, OFONO_SERVICE, MODEM, "org.ofono.Modem");
+        watchProperties(modem, G_CALLBACK(modem_property_changed),
+                        STATS_SIGNAL_MODEM);
+    } else {
+        propertiesReseed(modem);
     }
-    LOGW("dbus connect - ok");
+    bringupState = BRINGUP_ATTACHED;
 
-    error = NULL;
-    manager = dbus_g_proxy_new_for_name(connection, OFONO_SERVICE, "/", "org.ofono.Manager");
-    if (!manager) {
-        LOGE("Failed to create Manager proxy object: %s", error->message);
-        return 0;
+    // radioSync() takes over from the first RADIO_POWER, which the
+    // framework only sends while the radio is available
+    if (radioWanted < 0 && RADIO_STATE_UNAVAILABLE == sState)
+        setRadioState(RADIO_STATE_OFF);
+    statsPhase(STATS_PHASE_ATTACHED);
+    LOGW("modem %s attached", MODEM);
+
+    if (ofonoLostAt) {
+        uint64_t us = statsNow() - ofonoLostAt;
+        statsOfonoRestart(us);
+        LOGI("ofono restart: modem back in %llu ms", (unsigned long long) us / 1000);
+        ofonoLostAt = 0;
     }
-    LOGD("proxy manager - ok");
+}
 
+/*
+ * ofono went away (crash or restart). The proxies are for the name, so
+ * they talk to the next ofono as is and keep their property mirrors:
+ * seeding them again only passes on what differs. What ofono can't
+ * bring back is dropped now: calls, and the modem state, since a new
+ * ofono starts with the modem off. The radio state machine powers it up
+ * again if the framework wants the radio on.
+ */
+static void ofonoLost()
+{
+    bringupState = BRINGUP_WAIT_OFONO;
+    ofonoLostAt = statsNow();
+
+    callsDropAll();
+    if (modem)
+        propertiesForget(modem);
+    memset(interfacePresent, 0, sizeof(interfacePresent));
+    modemPowered = modemOnline = modemHasRat = FALSE;
+    setRadioState(RADIO_STATE_UNAVAILABLE);
+}
+
+static void getModemsReply(OfonoRequest *req, DBusGProxyCall *call)
+{
+    GError *error = NULL;
     GPtrArray *modems = 0;
-    if (!dbus_g_proxy_call(manager, "GetModems", &error, G_TYPE_INVALID,
-                           type_a_oa_sv, &modems,
-                           G_TYPE_INVALID))
+    guint i;
+
+    if (!dbus_g_proxy_end_call(req->proxy, call, &error,
+                               type_a_oa_sv, &modems, G_TYPE_INVALID))
     {
-        LOGE(".GetModems failed: %s", error->message);
-        return 0;
+        // ModemAdded or the next start of ofono will tell
+        LOGE("GetModems failed: %s", error->message);
+        g_error_free(error);
+        return;
     }
 
-    if (!modems || !modems->len) {
-        LOGE("modems->len is empty. Probably, modem isn't detected yet.");
-        return 0;
+    for (i = 0; i < modems->len; i++) {
+        GValueArray *mdm = g_ptr_array_index(modems, i);
+        const char *modemPath = g_value_get_boxed(g_value_array_get_nth(mdm, 0));
+        if (!g_strcmp0(MODEM, modemPath)) {
+            attachModem();
+            break;
+        }
+        LOGW("ignoring modem %s", modemPath);
     }
+    if (BRINGUP_ATTACHED != bringupState)
+        LOGW("no %s yet, waiting for ModemAdded", MODEM);
 
-    GValueArray *mdm = g_ptr_array_index(modems, 0);
-    const char *modemPath = g_value_get_boxed(g_value_array_get_nth(mdm, 0));
-    if (g_strcmp0(MODEM, modemPath) != 0) {
-        LOGE("Modem path dosn't match: \"%s\", but we expect \"%s\"", modemPath, MODEM);
-        return 0;
+    g_boxed_free(type_a_oa_sv, modems);
+}
+
+static void managerModemAdded(DBusGProxy *proxy, const char *modemPath,
+                              GHashTable *props, gpointer userData)
+{
+    LOGD("ModemAdded: %s", modemPath);
+    if (!g_strcmp0(MODEM, modemPath))
+        attachModem();
+}
+
+static void ofonoOwnerChanged(DBusGProxy *proxy, gboolean hasOwner, gpointer userData)
+{
+    if (!hasOwner) {
+        LOGW("ofono is gone");
+        if (BRINGUP_WAIT_OFONO != bringupState)
+            ofonoLost();
+        return;
     }
-    g_ptr_array_free(modems, TRUE);
 
-    error = NULL;
-    modem = dbus_g_proxy_new_for_name(connection, OFONO_SERVICE, MODEM, "org.ofono.Modem");
-    if (!modem) {
-        LOGE("Failed to create Modem proxy object: %s", error->message);
-        return 0;
+    LOGW("ofono is up");
+    statsPhase(STATS_PHASE_OFONO);
+    if (BRINGUP_ATTACHED != bringupState) {
+        bringupState = BRINGUP_WAIT_MODEM;
+        ofonoRequestStart(ofonoRequestNew(manager, "GetModems", getModemsReply, 0));
+    }
+}
+
+static int initOfono()
+{
+    GError *error = NULL;
+    connection = dbus_g_bus_get(DBUS_BUS_SYSTEM, &error);
+    if (!connection) {
+        LOGE("Failed to open connection to bus: %s\n", error->message);
+        g_error_free (error);
+        return -1;
     }
-    dbus_g_proxy_add_signal(modem, OFONO_SIGNAL_PROPERTY_CHANGED, G_TYPE_STRING, G_TYPE_VALUE, G_TYPE_INVALID);
-    dbus_g_proxy_connect_signal(modem,
-                                OFONO_SIGNAL_PROPERTY_CHANGED,
-                                G_CALLBACK(modem_property_changed), modem, NULL);
-    LOGW("modem proxy - ok");
+    LOGW("dbus connect - ok");
 
-    LOGW("Ofono initialization - ok");
+    // a proxy for a name works before the name has an owner
+    manager = dbus_g_proxy_new_for_name(connection, OFONO_SERVICE, "/", "org.ofono.Manager");
+
+    // Manager.ModemAdded(object path, dict properties)
+    dbus_g_proxy_add_signal(manager, OFONO_SIGNAL_MODEM_ADDED,
+                            DBUS_TYPE_G_OBJECT_PATH, type_a_sv,
+                            G_TYPE_INVALID);
+    dbus_g_proxy_connect_signal(manager, OFONO_SIGNAL_MODEM_ADDED,
+                                G_CALLBACK(managerModemAdded), NULL, NULL);
+
+    // runs from the main loop, once right away if ofono is already up
+    dbus_g_proxy_set_name_owner_notify(manager, ofonoOwnerChanged, NULL);
     return 0;
 }
 
 const RIL_RadioFunctions *RIL_Init(const struct RIL_Env *env, int argc, char **argv)
 {
     int ret;
+    int opt;
+    const char *tracePath = TRACE_PATH;
     pthread_attr_t attr;
     pthread_t s_tid_mainloop;
+    guint budgetMessages, budgetUsec;
 
     s_rilenv = env;
+    statsPhase(STATS_PHASE_INIT);
+    dbus_g_get_dispatch_budget(&budgetMessages, &budgetUsec);
+
+    while (-1 != (opt = getopt(argc, argv, "b:c:t:u:"))) {
+        switch (opt) {
+            case 'b':
+                // D-Bus messages dispatched per main loop iteration
+                if (atoi(optarg) < 1) {
+                    LOGW("Ignoring -b %s, the budget is at least one message", optarg);
+                    break;
+                }
+                budgetMessages = atoi(optarg);
+                break;
+            case 'u':
+                // time limit for dispatching D-Bus messages per iteration, us
+                if (atoi(optarg) < 0) {
+                    LOGW("Ignoring -u %s, 0 is no time limit", optarg);
+                    break;
+                }
+                budgetUsec = atoi(optarg);
+                break;
+            case 'c':
+                // window for merging NETWORK/CALL_STATE_CHANGED, ms
+                coalesceWindow = atoi(optarg);
+                LOGI("Coalescing unsolicited notifications within %u ms", coalesceWindow);
+                break;
+            case 't':
+                // trace file, tracing is off with an empty path
+                tracePath = optarg;
+                break;
+            default:
+                LOGW("Unknown option: -%c", opt);
+                break;
+        }
+    }
+
+    dbus_g_set_dispatch_budget(budgetMessages, budgetUsec);
+    LOGI("Dispatching up to %u D-Bus messages or %u us per iteration",
+         budgetMessages, budgetUsec);
+
+    if (tracePath[0])
+        traceInit(tracePath, TRACE_RECORDS);
+
+    // answer identity requests from the cache until ofono reports them
+    if (identityInit(IDENTITY_PATH) > 0) {
+        snprintf(modemIMEI, sizeof(modemIMEI), "%s", identityGet(IDENTITY_IMEI));
+        snprintf(modemRev, sizeof(modemRev), "%s", identityGet(IDENTITY_REVISION));
+        snprintf(simIMSI, sizeof(simIMSI), "%s", identityGet(IDENTITY_IMSI));
+        snprintf(netregOperator, sizeof(netregOperator), "%s", identityGet(IDENTITY_OPERATOR));
+        snprintf(netregMCC, sizeof(netregMCC), "%s", identityGet(IDENTITY_MCC));
+        snprintf(netregMNC, sizeof(netregMNC), "%s", identityGet(IDENTITY_MNC));
+        LOGI("identity: cached IMEI %s, revision %s", modemIMEI, modemRev);
+    }
 
     if (!g_thread_supported ())
     {
@@ -2385,6 +3818,7 @@ const RIL_RadioFunctions *RIL_Init(const struct RIL_Env *env, int argc, char **a
         dbus_g_thread_init();
     }
     g_type_init();
+    ofonoStringsInit();
 
     // types for DBus
     type_a_sv = dbus_g_type_get_map("GHashTable", G_TYPE_STRING, G_TYPE_VALUE);
@@ -2414,7 +3848,7 @@ const RIL_RadioFunctions *RIL_Init(const struct RIL_Env *env, int argc, char **a
 
     cmtAudioInit();
 
-    if (initOfono())
+    if (initOfono() < 0)
         return 0;
 
     pthread_attr_init (&attr);
@@ -0,0 +1,332 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#include <string.h>
+#include <time.h>
+#include <glib.h>
+#include <dbus/dbus-glib.h>
+
+#include "stats.h"
+
+extern const char * requestToString(int request);
+
+#define STATS_MAX_REQUEST   128 // larger request ids are counted in slot 0
+#define STATS_BUCKETS       24  // bucket i: [2^i, 2^(i+1)) us, the last one is open
+#define STATS_MAX_INFLIGHT  64  // requests timed at once, the rest are only counted
+#define STATS_MAX_UNSOL     64  // from RIL_UNSOL_RESPONSE_BASE, the rest aren't counted
+
+typedef struct {
+    volatile uint32_t count;
+    volatile uint32_t errors;
+    volatile uint32_t dbusCalls;
+    volatile uint32_t hist[STATS_BUCKETS];
+} RequestStats;
+
+typedef struct {
+    volatile uint32_t count;
+    volatile uint32_t hist[STATS_BUCKETS];
+} SignalStats;
+
+typedef struct {
+    volatile uint32_t sent;
+    volatile uint32_t merged;       // sent with others folded into them
+    volatile uint32_t suppressed;   // folded into another one
+} UnsolStats;
+
+typedef struct {
+    RIL_Token volatile t;   // NULL for a free slot
+    int request;
+    uint64_t start;
+} InFlight;
+
+static RequestStats requestStats[STATS_MAX_REQUEST];
+static SignalStats signalStats[STATS_SIGNAL_COUNT];
+static InFlight inFlight[STATS_MAX_INFLIGHT];
+static UnsolStats unsolStats[STATS_MAX_UNSOL];
+static volatile uint64_t phaseTimes[STATS_PHASE_COUNT];
+static SignalStats radioStats[2];   // off, on
+static volatile uint64_t radioLast[2];
+static SignalStats restartStats;
+static volatile uint64_t restartLast;
+
+static const char *signalNames[STATS_SIGNAL_COUNT] = {
+    "Modem",
+    "VoiceCallManager",
+    "SimManager",
+    "ConnectionManager",
+    "PrimaryDataContext",
+    "NetworkRegistration",
+    "RadioSettings",
+    "MessageManager",
+    "SupplementaryServices",
+    "AudioSettings",
+    "VoiceCall",
+    "CallAdded",
+    "CallRemoved",
+    "IncomingMessage",
+    "RequestReceived",
+};
+
+static const char *phaseNames[STATS_PHASE_COUNT] = {
+    "init",
+    "ofono",
+    "modem",
+    "attached",
+    "synced",
+};
+
+uint64_t statsNow()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static inline unsigned bucketOf(uint64_t us)
+{
+    unsigned bucket;
+
+    if (us < 2)
+        return 0;
+    bucket = 63 - __builtin_clzll(us);
+    return bucket < STATS_BUCKETS ? bucket : STATS_BUCKETS - 1;
+}
+
+static inline RequestStats *requestSlot(int request)
+{
+    if (request <= 0 || request >= STATS_MAX_REQUEST)
+        request = 0;
+    return &requestStats[request];
+}
+
+void statsRequestBegin(int request, RIL_Token t)
+{
+    int i;
+
+    __sync_fetch_and_add(&requestSlot(request)->count, 1);
+
+    if (!t)
+        return;
+    for (i = 0; i < STATS_MAX_INFLIGHT; i++) {
+        if (__sync_bool_compare_and_swap(&inFlight[i].t, NULL, t)) {
+            inFlight[i].request = request;
+            inFlight[i].start = statsNow();
+            return;
+        }
+    }
+}
+
+void statsRequestEnd(RIL_Token t, RIL_Errno e)
+{
+    int i;
+
+    if (!t)
+        return;
+    for (i = 0; i < STATS_MAX_INFLIGHT; i++) {
+        if (inFlight[i].t == t) {
+            RequestStats *stats = requestSlot(inFlight[i].request);
+            uint64_t latency = statsNow() - inFlight[i].start;
+
+            __sync_synchronize();
+            inFlight[i].t = NULL;
+
+            if (RIL_E_SUCCESS != e)
+                __sync_fetch_and_add(&stats->errors, 1);
+            __sync_fetch_and_add(&stats->hist[bucketOf(latency)], 1);
+            return;
+        }
+    }
+}
+
+int statsRequestOf(RIL_Token t)
+{
+    int i;
+
+    if (!t)
+        return 0;
+    for (i = 0; i < STATS_MAX_INFLIGHT; i++)
+        if (inFlight[i].t == t)
+            return inFlight[i].request;
+    return 0;
+}
+
+void statsDBusCall(int request)
+{
+    __sync_fetch_and_add(&requestSlot(request)->dbusCalls, 1);
+}
+
+void statsSignal(StatsSignal signal, uint64_t start)
+{
+    SignalStats *stats = &signalStats[signal];
+
+    __sync_fetch_and_add(&stats->count, 1);
+    __sync_fetch_and_add(&stats->hist[bucketOf(statsNow() - start)], 1);
+}
+
+void statsPhase(StatsPhase phase)
+{
+    phaseTimes[phase] = statsNow();
+}
+
+void statsUnsolSent(int unsol, unsigned merged)
+{
+    unsigned slot = unsol - RIL_UNSOL_RESPONSE_BASE;
+    UnsolStats *stats;
+
+    if (slot >= STATS_MAX_UNSOL)
+        return;
+    stats = &unsolStats[slot];
+    __sync_fetch_and_add(&stats->sent, 1);
+    if (merged) {
+        __sync_fetch_and_add(&stats->merged, 1);
+        __sync_fetch_and_add(&stats->suppressed, merged);
+    }
+}
+
+void statsRadioToggle(int on, uint64_t us)
+{
+    SignalStats *stats = &radioStats[!!on];
+
+    radioLast[!!on] = us;
+    __sync_fetch_and_add(&stats->count, 1);
+    __sync_fetch_and_add(&stats->hist[bucketOf(us)], 1);
+}
+
+void statsOfonoRestart(uint64_t us)
+{
+    restartLast = us;
+    __sync_fetch_and_add(&restartStats.count, 1);
+    __sync_fetch_and_add(&restartStats.hist[bucketOf(us)], 1);
+}
+
+static void appendHistogram(GString *str, volatile uint32_t *hist)
+{
+    int last = STATS_BUCKETS - 1;
+    int i;
+
+    while (last > 0 && !hist[last])
+        last--;
+    g_string_append(str, " hist=");
+    for (i = 0; i <= last; i++)
+        g_string_append_printf(str, i ? ",%u" : "%u", hist[i]);
+}
+
+char **statsFormat(int *count)
+{
+    GPtrArray *lines = g_ptr_array_new();
+    guint hits, misses;
+    int i;
+
+    g_ptr_array_add(lines, g_strdup_printf(
+        "hist: bucket i counts latencies in [2^i, 2^(i+1)) us"));
+
+    for (i = 0; i < STATS_MAX_REQUEST; i++) {
+        RequestStats *stats = &requestStats[i];
+        if (!stats->count && !stats->dbusCalls)
+            continue;
+
+        GString *str = g_string_new(NULL);
+        g_string_append_printf(str, "request %s: count=%u errors=%u dbus=%u",
+                               i ? requestToString(i) : "OTHER",
+                               stats->count, stats->errors, stats->dbusCalls);
+        appendHistogram(str, stats->hist);
+        g_ptr_array_add(lines, g_string_free(str, FALSE));
+    }
+
+    for (i = 0; i < STATS_SIGNAL_COUNT; i++) {
+        SignalStats *stats = &signalStats[i];
+        if (!stats->count)
+            continue;
+
+        GString *str = g_string_new(NULL);
+        g_string_append_printf(str, "signal %s: count=%u",
+                               signalNames[i], stats->count);
+        appendHistogram(str, stats->hist);
+        g_ptr_array_add(lines, g_string_free(str, FALSE));
+    }
+
+    for (i = 0; i < STATS_MAX_UNSOL; i++) {
+        UnsolStats *stats = &unsolStats[i];
+        if (!stats->sent)
+            continue;
+
+        g_ptr_array_add(lines, g_strdup_printf(
+            "unsolicited %s: sent=%u merged=%u suppressed=%u",
+            requestToString(RIL_UNSOL_RESPONSE_BASE + i),
+            stats->sent, stats->merged, stats->suppressed));
+    }
+
+    for (i = 1; i >= 0; i--) {
+        SignalStats *stats = &radioStats[i];
+        if (!stats->count)
+            continue;
+
+        GString *str = g_string_new(NULL);
+        g_string_append_printf(str, "radio %s: count=%u last=%llu",
+                               i ? "on" : "off", stats->count,
+                               (unsigned long long) radioLast[i]);
+        appendHistogram(str, stats->hist);
+        g_ptr_array_add(lines, g_string_free(str, FALSE));
+    }
+
+    if (restartStats.count) {
+        GString *str = g_string_new(NULL);
+        g_string_append_printf(str, "ofono restart: count=%u last=%llu",
+                               restartStats.count, (unsigned long long) restartLast);
+        appendHistogram(str, restartStats.hist);
+        g_ptr_array_add(lines, g_string_free(str, FALSE));
+    }
+
+    if (phaseTimes[STATS_PHASE_INIT]) {
+        GString *str = g_string_new("bringup, us after init:");
+        for (i = STATS_PHASE_INIT + 1; i < STATS_PHASE_COUNT; i++) {
+            if (phaseTimes[i])
+                g_string_append_printf(str, " %s=%llu", phaseNames[i],
+                    (unsigned long long) (phaseTimes[i] - phaseTimes[STATS_PHASE_INIT]));
+            else
+                g_string_append_printf(str, " %s=pending", phaseNames[i]);
+        }
+        g_ptr_array_add(lines, g_string_free(str, FALSE));
+    }
+
+    dbus_g_proxy_get_signal_cache_stats(&hits, &misses);
+    g_ptr_array_add(lines, g_strdup_printf("signal cache: hits=%u misses=%u",
+                                           hits, misses));
+
+    *count = lines->len;
+    return (char **) g_ptr_array_free(lines, FALSE);
+}
+
+void statsFree(char **lines, int count)
+{
+    int i;
+
+    for (i = 0; i < count; i++)
+        g_free(lines[i]);
+    g_free(lines);
+}
+
+/* Counters updated concurrently with the reset may survive it */
+void statsReset()
+{
+    memset(requestStats, 0, sizeof(requestStats));
+    memset(signalStats, 0, sizeof(signalStats));
+    memset(unsolStats, 0, sizeof(unsolStats));
+    memset(radioStats, 0, sizeof(radioStats));
+    memset(&restartStats, 0, sizeof(restartStats));
+}
@@ -0,0 +1,100 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef __STATS_H
+#define __STATS_H
+
+#include <stdint.h>
+#include <telephony/ril.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Request and signal statistics, queried with OEM_HOOK_STRINGS "stats".
+ * Every counter is updated with an atomic add, nothing takes a lock.
+ */
+
+typedef enum {
+    STATS_SIGNAL_MODEM = 0,
+    STATS_SIGNAL_VCM,
+    STATS_SIGNAL_SIM,
+    STATS_SIGNAL_CONNMAN,
+    STATS_SIGNAL_PDC,
+    STATS_SIGNAL_NETREG,
+    STATS_SIGNAL_RADIOSETTINGS,
+    STATS_SIGNAL_SMS,
+    STATS_SIGNAL_SUPSRV,
+    STATS_SIGNAL_AUDIOSETTINGS,
+    STATS_SIGNAL_CALL,
+    STATS_SIGNAL_CALL_ADDED,
+    STATS_SIGNAL_CALL_REMOVED,
+    STATS_SIGNAL_INCOMING_MESSAGE,
+    STATS_SIGNAL_REQUEST_RECEIVED,
+    STATS_SIGNAL_COUNT
+} StatsSignal;
+
+/* Bring-up milestones, reported relative to STATS_PHASE_INIT */
+typedef enum {
+    STATS_PHASE_INIT = 0,       // RIL_Init
+    STATS_PHASE_OFONO,          // org.ofono has an owner
+    STATS_PHASE_MODEM,          // ofono lists our modem
+    STATS_PHASE_ATTACHED,       // modem proxy created
+    STATS_PHASE_SYNCED,         // every interface seeded with its properties
+    STATS_PHASE_COUNT
+} StatsPhase;
+
+/* Monotonic time, us */
+uint64_t statsNow();
+
+/* onRequest entry and the matching RIL_onRequestComplete */
+void statsRequestBegin(int request, RIL_Token t);
+void statsRequestEnd(RIL_Token t, RIL_Errno e);
+
+/* Request type of an in-flight token, 0 if unknown */
+int statsRequestOf(RIL_Token t);
+
+/* D-Bus call made on behalf of a request (0 for the library's own calls) */
+void statsDBusCall(int request);
+
+/* Signal handler run that started at start (see statsNow) */
+void statsSignal(StatsSignal signal, uint64_t start);
+
+/* Bring-up phase reached now, a later run (ofono restart) overwrites it */
+void statsPhase(StatsPhase phase);
+
+/* Coalesced unsolicited response sent, merged more were folded into it */
+void statsUnsolSent(int unsol, unsigned merged);
+
+/* Radio power toggle that took us from RADIO_POWER until ofono settled */
+void statsRadioToggle(int on, uint64_t us);
+
+/* ofono restart, us from losing ofono until the modem was attached again */
+void statsOfonoRestart(uint64_t us);
+
+/* Statistics as text lines, free with statsFree */
+char **statsFormat(int *count);
+void statsFree(char **lines, int count);
+
+void statsReset();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __STATS_H
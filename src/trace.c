@@ -0,0 +1,100 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define LOG_TAG "RIL"
+#include <utils/Log.h>
+#include "logging.h"
+
+#include "stats.h"
+#include "trace.h"
+
+static TraceHeader *header;     // NULL while tracing is off
+static TraceRecord *records;
+static uint32_t mask;
+
+int traceInit(const char *path, uint32_t capacity)
+{
+    size_t size;
+    void *map;
+    int fd;
+
+    if (!capacity || (capacity & (capacity - 1))) {
+        LOGE("trace: capacity %u is not a power of two", capacity);
+        return -1;
+    }
+    size = sizeof(TraceHeader) + capacity * sizeof(TraceRecord);
+
+    fd = open(path, O_RDWR | O_CREAT, 0640);
+    if (fd < 0) {
+        LOGW("trace: can't open %s: %s", path, strerror(errno));
+        return -1;
+    }
+    if (ftruncate(fd, size) < 0) {
+        LOGW("trace: can't resize %s: %s", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == map) {
+        LOGW("trace: can't map %s: %s", path, strerror(errno));
+        return -1;
+    }
+
+    // a new run starts a new trace
+    TraceHeader *h = (TraceHeader *) map;
+    h->magic = TRACE_MAGIC;
+    h->version = TRACE_VERSION;
+    h->capacity = capacity;
+    h->head = 0;
+
+    records = (TraceRecord *) (h + 1);
+    mask = capacity - 1;
+    __sync_synchronize();
+    header = h;
+
+    LOGI("trace: %u events in %s", capacity, path);
+    return 0;
+}
+
+void traceRecord(TraceEvent type, uint64_t time, uint32_t id,
+                 uint16_t value, uint64_t arg)
+{
+    TraceRecord *rec;
+
+    if (!header)
+        return;
+
+    rec = &records[__sync_fetch_and_add(&header->head, 1) & mask];
+    rec->time = time;
+    rec->arg = arg;
+    rec->id = id;
+    rec->type = type;
+    rec->value = value;
+}
+
+void traceEvent(TraceEvent type, uint32_t id, uint16_t value, uint64_t arg)
+{
+    if (header)
+        traceRecord(type, statsNow(), id, value, arg);
+}
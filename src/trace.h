@@ -0,0 +1,77 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef __TRACE_H
+#define __TRACE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Binary event trace kept in a memory-mapped ring buffer file, decoded
+ * into a Chrome/Perfetto JSON trace by ofono-ril-tracedecode.
+ *
+ * File layout: TraceHeader, then capacity TraceRecords. Record i lives
+ * at slot i % capacity, head is the number of records ever written.
+ */
+
+#define TRACE_MAGIC   0x5254524f    // "ORTR"
+#define TRACE_VERSION 1
+
+typedef enum {
+    TRACE_REQUEST_BEGIN = 1,    // id: request, arg: token
+    TRACE_REQUEST_END,          // id: request, value: RIL_Errno, arg: token
+    TRACE_DBUS_BEGIN,           // id: request or 0, arg: call
+    TRACE_DBUS_END,             // id: request or 0, arg: call
+    TRACE_SIGNAL,               // id: StatsSignal, arg: handler time, us
+    TRACE_UNSOLICITED,          // id: unsolicited response
+    TRACE_AUDIO_IN,             // value: bytes
+    TRACE_AUDIO_OUT,            // value: bytes
+} TraceEvent;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;          // records, a power of two
+    volatile uint32_t head;
+} TraceHeader;
+
+typedef struct {
+    uint64_t time;              // CLOCK_MONOTONIC, us
+    uint64_t arg;
+    uint32_t id;
+    uint16_t type;              // TraceEvent
+    uint16_t value;
+} TraceRecord;
+
+/* Map the trace file, tracing stays off if this fails */
+int traceInit(const char *path, uint32_t capacity);
+
+void traceRecord(TraceEvent type, uint64_t time, uint32_t id,
+                 uint16_t value, uint64_t arg);
+
+/* Record an event happening now */
+void traceEvent(TraceEvent type, uint32_t id, uint16_t value, uint64_t arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __TRACE_H
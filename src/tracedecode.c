@@ -0,0 +1,144 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/*
+ * Turns a libofono-ril trace dump into Chrome/Perfetto JSON:
+ *
+ *   adb pull /data/radio/ofono-ril.trace
+ *   ofono-ril-tracedecode ofono-ril.trace > trace.json
+ *
+ * Requests and D-Bus calls become async slices, signal handlers complete
+ * slices on the main loop track, the rest instant events.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "trace.h"
+
+enum {
+    TID_REQUEST = 1,
+    TID_MAINLOOP,
+    TID_AUDIO,
+};
+
+static int first = 1;
+
+static void emit(const char *fmt, ...)
+{
+    va_list ap;
+
+    printf(first ? "\n  " : ",\n  ");
+    first = 0;
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+}
+
+static void decode(const TraceRecord *rec)
+{
+    unsigned long long ts = rec->time;
+    unsigned long long arg = rec->arg;
+
+    switch (rec->type) {
+        case TRACE_REQUEST_BEGIN:
+        case TRACE_REQUEST_END:
+            emit("{\"name\":\"request %u\",\"cat\":\"request\",\"ph\":\"%c\","
+                 "\"id\":\"0x%llx\",\"ts\":%llu,\"pid\":1,\"tid\":%d,"
+                 "\"args\":{\"error\":%u}}",
+                 rec->id, TRACE_REQUEST_BEGIN == rec->type ? 'b' : 'e',
+                 arg, ts, TID_REQUEST, rec->value);
+            break;
+        case TRACE_DBUS_BEGIN:
+        case TRACE_DBUS_END:
+            emit("{\"name\":\"dbus call\",\"cat\":\"dbus\",\"ph\":\"%c\","
+                 "\"id\":\"0x%llx\",\"ts\":%llu,\"pid\":1,\"tid\":%d,"
+                 "\"args\":{\"request\":%u}}",
+                 TRACE_DBUS_BEGIN == rec->type ? 'b' : 'e',
+                 arg, ts, TID_MAINLOOP, rec->id);
+            break;
+        case TRACE_SIGNAL:
+            emit("{\"name\":\"signal %u\",\"cat\":\"signal\",\"ph\":\"X\","
+                 "\"ts\":%llu,\"dur\":%llu,\"pid\":1,\"tid\":%d}",
+                 rec->id, ts, arg, TID_MAINLOOP);
+            break;
+        case TRACE_UNSOLICITED:
+            emit("{\"name\":\"unsolicited %u\",\"cat\":\"unsolicited\",\"ph\":\"i\","
+                 "\"s\":\"t\",\"ts\":%llu,\"pid\":1,\"tid\":%d}",
+                 rec->id, ts, TID_MAINLOOP);
+            break;
+        case TRACE_AUDIO_IN:
+        case TRACE_AUDIO_OUT:
+            emit("{\"name\":\"audio %s\",\"cat\":\"audio\",\"ph\":\"i\","
+                 "\"s\":\"t\",\"ts\":%llu,\"pid\":1,\"tid\":%d,"
+                 "\"args\":{\"bytes\":%u}}",
+                 TRACE_AUDIO_IN == rec->type ? "in" : "out",
+                 ts, TID_AUDIO, rec->value);
+            break;
+        default:
+            // unwritten slot or torn record
+            break;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    TraceHeader header;
+    TraceRecord *records;
+    uint32_t count, start, i;
+    FILE *f;
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <trace file>\n", argv[0]);
+        return 2;
+    }
+
+    f = fopen(argv[1], "rb");
+    if (!f) {
+        perror(argv[1]);
+        return 1;
+    }
+    if (fread(&header, sizeof(header), 1, f) != 1
+        || TRACE_MAGIC != header.magic || TRACE_VERSION != header.version
+        || !header.capacity || (header.capacity & (header.capacity - 1))) {
+        fprintf(stderr, "%s: not a version %d trace\n", argv[1], TRACE_VERSION);
+        fclose(f);
+        return 1;
+    }
+
+    records = calloc(header.capacity, sizeof(TraceRecord));
+    if (!records || fread(records, sizeof(TraceRecord), header.capacity, f) != header.capacity) {
+        fprintf(stderr, "%s: truncated trace\n", argv[1]);
+        free(records);
+        fclose(f);
+        return 1;
+    }
+    fclose(f);
+
+    // oldest record first
+    count = header.head < header.capacity ? header.head : header.capacity;
+    start = header.head - count;
+
+    printf("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (i = 0; i < count; i++)
+        decode(&records[(start + i) & (header.capacity - 1)]);
+    printf("\n]}\n");
+
+    free(records);
+    return 0;
+}
@@ -0,0 +1,34 @@
+#  Copyright (C) 2010 The NitDroid Project
+#
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License version 2 as
+#  published by the Free Software Foundation.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software
+#  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+#
+# The rest of test/ is built on the host by its Makefile.
+
+# ofono signal recorder, see sigtrace.h
+LOCAL_PATH:= $(call my-dir)
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+	sigrecord.c \
+	sigtrace.c
+##
+
+LOCAL_C_INCLUDES := $(call include-path-for, dbus)
+LOCAL_SHARED_LIBRARIES := libdbus
+LOCAL_CFLAGS := -std=c99
+
+LOCAL_MODULE := ofono-sigrecord
+LOCAL_MODULE_TAGS := optional
+
+include $(BUILD_EXECUTABLE)
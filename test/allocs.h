@@ -0,0 +1,40 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef __ALLOCS_H
+#define __ALLOCS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Linking allocs.o replaces malloc, calloc, realloc and the aligned
+ * variants for the whole process, glib and libdbus included, with
+ * glibc's own behind a per-thread counter. Not with SANITIZE, which
+ * has its own allocator. Set G_SLICE=always-malloc before glib starts
+ * for g_slice allocations to show up on older glib.
+ */
+
+/* Allocations made by the calling thread so far */
+unsigned long long allocsThread();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __ALLOCS_H
@@ -0,0 +1,194 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/*
+ * Bring-up and one round of each request family against fake-ofono.py,
+ * exits non-zero if any check failed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "harness.h"
+
+#define TIMEOUT 5000    // ms
+
+static const char *string(HarnessRequest *req, int i)
+{
+    if (!req || RIL_E_SUCCESS != req->error || i >= req->response.nstrings)
+        return "";
+    return req->response.strings[i] ? req->response.strings[i] : "";
+}
+
+static HarnessRequest *currentCalls()
+{
+    return harnessCall(RIL_REQUEST_GET_CURRENT_CALLS, NULL, 0, TIMEOUT);
+}
+
+static void testIdentity()
+{
+    HarnessRequest *req = harnessCall(RIL_REQUEST_GET_IMEI, NULL, 0, TIMEOUT);
+    CHECK(req && RIL_E_SUCCESS == req->error);
+    CHECK(!strcmp(string(req, 0), "004999010640000"));
+
+    req = harnessCall(RIL_REQUEST_GET_IMSI, NULL, 0, TIMEOUT);
+    CHECK(!strcmp(string(req, 0), "244051234567890"));
+
+    req = harnessCall(RIL_REQUEST_GET_SIM_STATUS, NULL, 0, TIMEOUT);
+    CHECK(req && RIL_E_SUCCESS == req->error);
+    CHECK(req && RIL_CARDSTATE_PRESENT == req->response.ints[0]);
+}
+
+static void testNetwork()
+{
+    HarnessRequest *req = harnessCall(RIL_REQUEST_REGISTRATION_STATE, NULL, 0, TIMEOUT);
+    CHECK(!strcmp(string(req, 0), "1"));
+    CHECK(!strcmp(string(req, 1), "1234"));
+
+    req = harnessCall(RIL_REQUEST_OPERATOR, NULL, 0, TIMEOUT);
+    CHECK(!strcmp(string(req, 0), "Elisa"));
+    CHECK(!strcmp(string(req, 2), "24405"));
+
+    // Strength is 0-100 in ofono, 0-31 in 27.007 +CSQ
+    req = harnessCall(RIL_REQUEST_SIGNAL_STRENGTH, NULL, 0, TIMEOUT);
+    CHECK(req && RIL_E_SUCCESS == req->error && 60 * 31 / 100 == req->response.ints[0]);
+
+    unsigned count = harnessUnsolCount(RIL_UNSOL_SIGNAL_STRENGTH);
+    CHECK(!harnessOfono(NULL, 0, "set /isimodem NetworkRegistration Strength y:80"));
+    CHECK(!harnessWaitUnsol(RIL_UNSOL_SIGNAL_STRENGTH, count + 1, TIMEOUT));
+
+    HarnessResponse last;
+    harnessUnsolLast(RIL_UNSOL_SIGNAL_STRENGTH, &last);
+    CHECK(80 * 31 / 100 == last.ints[0]);
+    harnessResponseClear(&last);
+
+    // the rest is coalesced into one NETWORK_STATE_CHANGED
+    count = harnessUnsolCount(RIL_UNSOL_RESPONSE_NETWORK_STATE_CHANGED);
+    CHECK(!harnessOfono(NULL, 0, "set /isimodem NetworkRegistration CellId u:0x1111"));
+    CHECK(!harnessOfono(NULL, 0, "set /isimodem NetworkRegistration LocationAreaCode q:0x4321"));
+    CHECK(!harnessWaitUnsol(RIL_UNSOL_RESPONSE_NETWORK_STATE_CHANGED, count + 1, TIMEOUT));
+
+    req = harnessCall(RIL_REQUEST_REGISTRATION_STATE, NULL, 0, TIMEOUT);
+    CHECK(!strcmp(string(req, 1), "4321"));
+    CHECK(!strcmp(string(req, 2), "1111"));
+}
+
+static void testCalls()
+{
+    char path[64];
+    unsigned rings = harnessUnsolCount(RIL_UNSOL_CALL_RING);
+    unsigned changes = harnessUnsolCount(RIL_UNSOL_RESPONSE_CALL_STATE_CHANGED);
+
+    CHECK(!harnessOfono(path, sizeof(path), "call-incoming +358401234567 Alice"));
+    CHECK(!harnessWaitUnsol(RIL_UNSOL_CALL_RING, rings + 1, TIMEOUT));
+    CHECK(!harnessWaitUnsol(RIL_UNSOL_RESPONSE_CALL_STATE_CHANGED, changes + 1, TIMEOUT));
+
+    HarnessRequest *req = currentCalls();
+    CHECK(req && 1 == req->response.ncalls);
+    if (req && 1 == req->response.ncalls) {
+        RIL_Call *call = &req->response.calls[0];
+        CHECK(RIL_CALL_INCOMING == call->state && call->isMT && 1 == call->index);
+        CHECK(call->number && !strcmp(call->number, "+358401234567"));
+        CHECK(call->name && !strcmp(call->name, "Alice"));
+    }
+
+    changes = harnessUnsolCount(RIL_UNSOL_RESPONSE_CALL_STATE_CHANGED);
+    req = harnessCall(RIL_REQUEST_ANSWER, NULL, 0, TIMEOUT);
+    CHECK(req && RIL_E_SUCCESS == req->error);
+    CHECK(!harnessWaitUnsol(RIL_UNSOL_RESPONSE_CALL_STATE_CHANGED, changes + 1, TIMEOUT));
+    CHECK(!harnessOfono(NULL, 0, "sync"));
+    req = currentCalls();
+    CHECK(req && 1 == req->response.ncalls && RIL_CALL_ACTIVE == req->response.calls[0].state);
+
+    int line = 1;
+    req = harnessCall(RIL_REQUEST_HANGUP, &line, sizeof(line), TIMEOUT);
+    CHECK(req && RIL_E_SUCCESS == req->error);
+    for (int i = 0; i < TIMEOUT / 10; i++) {
+        req = currentCalls();
+        if (!req || !req->response.ncalls)
+            break;
+        usleep(10000);
+    }
+    CHECK(req && 0 == req->response.ncalls);
+
+    // outgoing, the call shows up from CallAdded
+    RIL_Dial dial = { "+358409876543", 0, NULL };
+    req = harnessCall(RIL_REQUEST_DIAL, &dial, sizeof(dial), TIMEOUT);
+    CHECK(req && RIL_E_SUCCESS == req->error);
+    req = currentCalls();
+    CHECK(req && 1 == req->response.ncalls && RIL_CALL_DIALING == req->response.calls[0].state);
+    CHECK(!harnessOfono(NULL, 0, "call-remove /isimodem/voicecall01"));
+}
+
+static void testMessaging()
+{
+    unsigned count = harnessUnsolCount(RIL_UNSOL_RESPONSE_NEW_SMS);
+    HarnessResponse last;
+
+    CHECK(!harnessOfono(NULL, 0, "sms-incoming +358401234567 hello world"));
+    CHECK(!harnessWaitUnsol(RIL_UNSOL_RESPONSE_NEW_SMS, count + 1, TIMEOUT));
+    harnessUnsolLast(RIL_UNSOL_RESPONSE_NEW_SMS, &last);
+    CHECK(1 == last.nstrings && last.strings[0] && strlen(last.strings[0]) > 20);
+    harnessResponseClear(&last);
+
+    count = harnessUnsolCount(RIL_UNSOL_ON_USSD);
+    char *ussd = "*100#";
+    HarnessRequest *req = harnessCall(RIL_REQUEST_SEND_USSD, ussd, strlen(ussd) + 1, TIMEOUT);
+    CHECK(req && RIL_E_SUCCESS == req->error);
+    CHECK(!harnessWaitUnsol(RIL_UNSOL_ON_USSD, count + 1, TIMEOUT));
+    harnessUnsolLast(RIL_UNSOL_ON_USSD, &last);
+    CHECK(2 == last.nstrings && last.strings[1] && !strcmp(last.strings[1], "Reply to *100#"));
+    harnessResponseClear(&last);
+}
+
+static void testData()
+{
+    char *setup[7] = { "1", "0", "internet", "", "", "0", "IP" };
+    HarnessRequest *req = harnessCall(RIL_REQUEST_SETUP_DATA_CALL, setup, sizeof(setup), TIMEOUT);
+
+    CHECK(req && RIL_E_SUCCESS == req->error);
+    CHECK(!strcmp(string(req, 1), "gprs0"));
+    CHECK(!strcmp(string(req, 2), "10.0.0.2"));
+    CHECK(hostIfc.up && !strcmp(hostIfc.name, "gprs0"));
+    CHECK(inet_addr("10.0.0.2") == hostIfc.addr);
+}
+
+int main(int argc, char **argv)
+{
+    if (harnessStart(0, NULL, NULL)) {
+        fprintf(stderr, "bring-up failed\n");
+        return 1;
+    }
+
+    char *line = harnessStatsLine("bringup");
+    CHECK(line && !strstr(line, "pending"));
+    if (line)
+        printf("%s\n", line);
+    free(line);
+
+    testIdentity();
+    testNetwork();
+    testCalls();
+    testMessaging();
+    testData();
+
+    CHECK(0 == harnessBadCompletions());
+
+    return harnessResult();
+}
@@ -0,0 +1,210 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/*
+ * Call table under load: ANSWER, HANGUP and GET_CURRENT_CALLS hammered
+ * while fake-ofono.py floods CallAdded/CallRemoved, exits non-zero if
+ * any check failed.
+ *
+ *   callstress [-d seconds]
+ *
+ * First checks that signals are delivered while an Answer is waiting on
+ * ofono, which stalled when the call lock was held across the call.
+ * Then every request has to complete exactly once, the call lists have
+ * to be sane throughout, and the table has to be empty once the fake
+ * has no calls left.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <pthread.h>
+
+#include "harness.h"
+
+#define TIMEOUT         5000    // ms
+#define ANSWER_DELAY    500     // ms ofono holds the Answer reply
+#define MAX_CALLS       8       // as in ril.c
+#define DEPTH           4       // requests in flight
+
+static volatile int flooding;
+static unsigned floodRounds;
+
+/* Removes every call the fake has */
+static void removeAllCalls()
+{
+    char reply[1024], *path, *save = NULL;
+
+    if (harnessOfono(reply, sizeof(reply), "calls"))
+        return;
+    strtok_r(reply, " ", &save);    // count
+    while ((path = strtok_r(NULL, " ", &save)))
+        harnessOfono(NULL, 0, "call-remove %s", path);
+}
+
+static int waitNoCalls()
+{
+    int i;
+
+    for (i = 0; i < TIMEOUT / 10; i++) {
+        HarnessRequest *req = harnessCall(RIL_REQUEST_GET_CURRENT_CALLS, NULL, 0, TIMEOUT);
+        if (req && !req->response.ncalls)
+            return 0;
+        usleep(10000);
+    }
+    return -1;
+}
+
+/* Signals go through while an Answer is waiting on ofono */
+static void testAnswerInFlight()
+{
+    char path[64];
+    unsigned changes;
+
+    CHECK(!harnessOfono(NULL, 0, "delay VoiceCall.Answer %d", ANSWER_DELAY));
+    CHECK(!harnessOfono(path, sizeof(path), "call-incoming +358401111111"));
+    changes = harnessUnsolCount(RIL_UNSOL_RESPONSE_CALL_STATE_CHANGED);
+    CHECK(!harnessWaitUnsol(RIL_UNSOL_RESPONSE_CALL_STATE_CHANGED, changes + 1, TIMEOUT));
+
+    uint64_t start = harnessNow();
+    HarnessRequest *answer = harnessRequest(RIL_REQUEST_ANSWER, NULL, 0);
+
+    changes = harnessUnsolCount(RIL_UNSOL_RESPONSE_CALL_STATE_CHANGED);
+    CHECK(!harnessOfono(NULL, 0, "call-incoming +358402222222"));
+    CHECK(!harnessWaitUnsol(RIL_UNSOL_RESPONSE_CALL_STATE_CHANGED, changes + 1, ANSWER_DELAY / 2));
+
+    HarnessRequest *req = harnessCall(RIL_REQUEST_GET_CURRENT_CALLS, NULL, 0, ANSWER_DELAY / 2);
+    CHECK(req && 2 == req->response.ncalls);
+    CHECK(harnessNow() - start < ANSWER_DELAY * 1000);
+    CHECK(!answer->completed);
+
+    CHECK(!harnessWait(answer, TIMEOUT));
+    CHECK(!harnessOfono(NULL, 0, "delay VoiceCall.Answer 0"));
+    removeAllCalls();
+    CHECK(!waitNoCalls());
+}
+
+/* Flood thread, harnessOfono() is serialized */
+static void *flood(void *param)
+{
+    char path[64];
+    unsigned i = 0;
+
+    while (flooding) {
+        harnessOfono(NULL, 0, "storm calls 20");
+        // one that lives a little, for ANSWER and HANGUP to find
+        if (!harnessOfono(path, sizeof(path), "call-incoming +35840%07u", i++)) {
+            harnessOfono(NULL, 0, "storm calls 10");
+            harnessOfono(NULL, 0, "call-remove %s", path);
+        }
+        floodRounds++;
+    }
+    return NULL;
+}
+
+static void checkCallList(HarnessRequest *req)
+{
+    unsigned seen = 0;
+    int i;
+
+    CHECK(req->response.ncalls <= MAX_CALLS);
+    for (i = 0; i < req->response.ncalls && i < MAX_CALLS; i++) {
+        RIL_Call *call = &req->response.calls[i];
+
+        CHECK(call->index >= 1 && call->index <= MAX_CALLS);
+        CHECK(!(seen & (1u << call->index)));
+        seen |= 1u << call->index;
+        CHECK(call->state >= RIL_CALL_ACTIVE && call->state <= RIL_CALL_WAITING);
+    }
+}
+
+static void testFlood(int seconds)
+{
+    static const int requests[] = {
+        RIL_REQUEST_ANSWER,
+        RIL_REQUEST_HANGUP,
+        RIL_REQUEST_GET_CURRENT_CALLS,
+        RIL_REQUEST_GET_CURRENT_CALLS,
+        RIL_REQUEST_HANGUP_WAITING_OR_BACKGROUND,
+    };
+    unsigned issued = 0, timeouts = 0, seed = 1;
+    pthread_t thread;
+
+    flooding = 1;
+    pthread_create(&thread, NULL, flood, NULL);
+
+    uint64_t end = harnessNow() + (uint64_t) seconds * 1000000;
+    while (harnessNow() < end) {
+        HarnessRequest *batch[DEPTH];
+        int lines[DEPTH], i;
+
+        for (i = 0; i < DEPTH; i++) {
+            int request = requests[rand_r(&seed) % (sizeof(requests) / sizeof(requests[0]))];
+
+            lines[i] = 1 + rand_r(&seed) % MAX_CALLS;
+            batch[i] = RIL_REQUEST_HANGUP == request ?
+                       harnessRequest(request, &lines[i], sizeof(int)) :
+                       harnessRequest(request, NULL, 0);
+            issued++;
+        }
+        for (i = 0; i < DEPTH; i++) {
+            if (harnessWait(batch[i], TIMEOUT)) {
+                timeouts++;
+                continue;
+            }
+            if (RIL_REQUEST_GET_CURRENT_CALLS == batch[i]->request)
+                checkCallList(batch[i]);
+        }
+    }
+
+    flooding = 0;
+    pthread_join(thread, NULL);
+    printf("%u requests against %u flood rounds\n", issued, floodRounds);
+    CHECK(!timeouts);
+    CHECK(floodRounds > 0);
+
+    removeAllCalls();
+    CHECK(!waitNoCalls());
+}
+
+int main(int argc, char **argv)
+{
+    int seconds = 3, opt;
+
+    while ((opt = getopt(argc, argv, "d:")) != -1) {
+        switch (opt) {
+            case 'd': seconds = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-d seconds]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    if (harnessStart(0, NULL, NULL)) {
+        fprintf(stderr, "bring-up failed\n");
+        return 1;
+    }
+
+    testAnswerInFlight();
+    testFlood(seconds);
+
+    CHECK(0 == harnessBadCompletions());
+
+    return harnessResult();
+}
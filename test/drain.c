@@ -0,0 +1,211 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/*
+ * Time to drain a burst of queued signals for each dispatch budget, see
+ * dbus_g_set_dispatch_budget() and RIL_Init's -b and -u:
+ *
+ *   drain [-n signals] [-r rounds] [-x MESSAGES:USEC,...] [-l label] [-o out.json]
+ *
+ * The main loop is held while fake-ofono.py sends n Strength changes, so
+ * all of them are waiting on the socket when it's let go. The burst is
+ * drained once n SIGNAL_STRENGTH unsolicited responses went out. Every
+ * budget runs in its own process, the library can only start once.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include <glib.h>
+
+#include "harness.h"
+
+#define MAX_BUDGETS 8
+#define MAX_ROUNDS  100
+#define TIMEOUT     30000   // ms for a burst to drain
+
+typedef struct {
+    unsigned    messages;
+    unsigned    usec;
+} Budget;
+
+static pthread_mutex_t holdLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t holdCond = PTHREAD_COND_INITIALIZER;
+static int holding, held;
+
+/* Main loop thread, parks it until release() */
+static gboolean hold(gpointer data)
+{
+    pthread_mutex_lock(&holdLock);
+    held = 1;
+    pthread_cond_broadcast(&holdCond);
+    while (holding)
+        pthread_cond_wait(&holdCond, &holdLock);
+    held = 0;
+    pthread_mutex_unlock(&holdLock);
+    return FALSE;
+}
+
+static void holdMainLoop()
+{
+    pthread_mutex_lock(&holdLock);
+    holding = 1;
+    g_idle_add(hold, NULL);
+    while (!held)
+        pthread_cond_wait(&holdCond, &holdLock);
+    pthread_mutex_unlock(&holdLock);
+}
+
+static void release()
+{
+    pthread_mutex_lock(&holdLock);
+    holding = 0;
+    pthread_cond_broadcast(&holdCond);
+    pthread_mutex_unlock(&holdLock);
+}
+
+/* In the child, writes one JSON object to out, 0 on success */
+static int measure(Budget budget, int signals, int rounds, FILE *out)
+{
+    char messages[16], usec[16];
+    char *argv[] = { "libofono-ril.so", "-b", messages, "-u", usec, NULL };
+    uint64_t times[MAX_ROUNDS];
+    int round;
+
+    snprintf(messages, sizeof(messages), "%u", budget.messages);
+    snprintf(usec, sizeof(usec), "%u", budget.usec);
+    if (harnessStart(5, argv, NULL)) {
+        fprintf(stderr, "bring-up failed\n");
+        return -1;
+    }
+
+    for (round = 0; round < rounds; round++) {
+        unsigned count = harnessUnsolCount(RIL_UNSOL_SIGNAL_STRENGTH);
+
+        holdMainLoop();
+        // sync: every signal of the storm is on its way to us
+        if (harnessOfono(NULL, 0, "storm strength %d", signals) ||
+            harnessOfono(NULL, 0, "sync")) {
+            release();
+            return -1;
+        }
+
+        uint64_t start = harnessNow();
+        release();
+        if (harnessWaitUnsol(RIL_UNSOL_SIGNAL_STRENGTH, count + signals, TIMEOUT)) {
+            fprintf(stderr, "burst not drained, %u of %d\n",
+                    harnessUnsolCount(RIL_UNSOL_SIGNAL_STRENGTH) - count, signals);
+            return -1;
+        }
+        times[round] = harnessNow() - start;
+    }
+
+    uint64_t median = harnessMedian(times, rounds);
+    fprintf(out, "{ \"messages\": %u, \"usec\": %u, \"median_us\": %llu, \"min_us\": %llu, "
+            "\"max_us\": %llu, \"signals_per_s\": %.0f }",
+            budget.messages, budget.usec, (unsigned long long) median,
+            (unsigned long long) times[0], (unsigned long long) times[rounds - 1],
+            median ? signals * 1e6 / median : 0.0);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    Budget budgets[MAX_BUDGETS] = { { 1, 0 }, { 8, 0 }, { 32, 5000 }, { 128, 0 } };
+    int budgetCount = 4, signals = 1000, rounds = 10, opt, i;
+    const char *label = "", *outPath = NULL;
+
+    while ((opt = getopt(argc, argv, "n:r:x:l:o:")) != -1) {
+        switch (opt) {
+            case 'n': signals = atoi(optarg); break;
+            case 'r': rounds = atoi(optarg); break;
+            case 'x': {
+                char *item, *save = NULL;
+                budgetCount = 0;
+                for (item = strtok_r(optarg, ",", &save); item && budgetCount < MAX_BUDGETS;
+                     item = strtok_r(NULL, ",", &save)) {
+                    char *colon = strchr(item, ':');
+                    budgets[budgetCount].messages = atoi(item);
+                    budgets[budgetCount].usec = colon ? atoi(colon + 1) : 0;
+                    budgetCount++;
+                }
+                break;
+            }
+            case 'l': label = optarg; break;
+            case 'o': outPath = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-n signals] [-r rounds] [-x MESSAGES:USEC,...] "
+                        "[-l label] [-o out.json]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (signals <= 0 || rounds <= 0 || rounds > MAX_ROUNDS || !budgetCount) {
+        fprintf(stderr, "need signals > 0, rounds 1-%d and a budget\n", MAX_ROUNDS);
+        return 2;
+    }
+
+    FILE *out = outPath ? fopen(outPath, "w") : stdout;
+    if (!out) {
+        perror(outPath);
+        return 1;
+    }
+    fprintf(out, "{\n  \"benchmark\": \"drain\",\n  \"label\": \"%s\",\n", label);
+    fprintf(out, "  \"signals\": %d,\n  \"rounds\": %d,\n  \"budgets\": [", signals, rounds);
+
+    for (i = 0; i < budgetCount; i++) {
+        int fds[2];
+        char line[512];
+        ssize_t len = 0, n;
+
+        fflush(out);
+        if (pipe(fds))
+            return 1;
+
+        pid_t pid = fork();
+        if (!pid) {
+            FILE *result = fdopen(fds[1], "w");
+
+            close(fds[0]);
+            if (measure(budgets[i], signals, rounds, result))
+                exit(1);
+            fclose(result);
+            exit(0);        // atexit() stops the bus and the fake
+        }
+        close(fds[1]);
+        while (len < (ssize_t) sizeof(line) - 1 &&
+               (n = read(fds[0], line + len, sizeof(line) - 1 - len)) > 0)
+            len += n;
+        close(fds[0]);
+
+        int status;
+        waitpid(pid, &status, 0);
+        if (len <= 0 || !WIFEXITED(status) || WEXITSTATUS(status)) {
+            fprintf(stderr, "budget %u:%u failed\n", budgets[i].messages, budgets[i].usec);
+            return 1;
+        }
+        line[len] = 0;
+        fprintf(out, "%s\n    %s", i ? "," : "", line);
+    }
+    fprintf(out, "\n  ]\n}\n");
+    if (out != stdout)
+        fclose(out);
+    return 0;
+}
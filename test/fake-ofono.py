@@ -0,0 +1,587 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2010 The NitDroid Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Scriptable stand-in for ofono with one modem, /isimodem.
+
+Owns org.ofono on the bus at --address (DBUS_SYSTEM_BUS_ADDRESS by
+default) and answers the methods libofono-ril calls, with the properties
+and signals ofono would send. Prints "ready" once it owns the name, then
+reads one command per line from stdin and answers each with one line,
+"ok [result]" or "error <reason>".
+
+COMMANDS
+  set PATH IFACE PROP VALUE   change a property and send PropertyChanged
+  get PATH IFACE PROP
+  call-incoming NUMBER [NAME] add an incoming call, ok PATH
+  call-state PATH STATE       e.g. active, held, alerting
+  call-remove PATH [REASON]   DisconnectReason, then CallRemoved
+  calls                       ok COUNT PATH...
+  auto-hangup MS              remove dialed calls after MS, 0 to stop
+  sms-incoming SENDER TEXT    MessageManager.IncomingMessage
+  ussd-request TEXT           SupplementaryServices.RequestReceived
+  storm KIND N                N signals back to back, ok SECONDS
+                              KIND: strength, netreg, calls, sms, ussd
+  delay IFACE.METHOD MS       hold the replies, 0 to stop
+  fail IFACE.METHOD ERROR     reply with org.ofono.Error.ERROR, off to stop
+  drop IFACE.METHOD on|off    never reply
+  count IFACE.METHOD          ok CALLS
+  last IFACE.METHOD           ok ARGS of the latest call, space separated
+  sleep MS
+  sync                        ok once everything sent is on the bus
+  quit
+
+IFACE is given without the org.ofono. prefix. VALUE is TYPE:TEXT with TYPE
+one of b, y, q, u, i, s, o or as (comma separated), e.g. y:80 or b:true.
+"""
+
+import argparse
+import os
+import sys
+import time
+
+import dbus
+import dbus.bus
+import dbus.lowlevel
+from dbus.mainloop.glib import DBusGMainLoop
+from gi.repository import GLib
+
+OFONO = "org.ofono."
+MODEM = "/isimodem"
+CONTEXT = MODEM + "/context1"
+MAX_CALL_ID = 99
+
+POWERED_INTERFACES = ["SimManager", "VoiceCallManager", "MessageManager",
+                      "RadioSettings", "ConnectionManager", "AudioSettings"]
+POWERED_FEATURES = ["sim", "rat", "sms", "gprs"]
+ONLINE_INTERFACES = ["NetworkRegistration", "SupplementaryServices"]
+ONLINE_FEATURES = ["net", "ussd"]
+
+# methods without out arguments that only have to succeed
+NOOP = {"VoiceCallManager.SendTones", "VoiceCallManager.HangupAll",
+        "NetworkRegistration.Register", "SimManager.EnterPin",
+        "SimManager.ChangePin", "SimManager.ResetPin",
+        "SupplementaryServices.Cancel"}
+
+
+def strings(items):
+    return dbus.Array(items, signature="s")
+
+
+def interface_names(names):
+    # Modem.Interfaces has full names, Features short ones
+    return strings([OFONO + name for name in names])
+
+
+def props(d):
+    return dbus.Dictionary(d, signature="sv")
+
+
+def plain(value):
+    """The value without its variant level, so it can be sent again"""
+    if isinstance(value, dbus.Array):
+        return dbus.Array(value, signature=value.signature)
+    if isinstance(value, dbus.Dictionary):
+        return dbus.Dictionary(value, signature=value.signature)
+    return type(value)(value)
+
+
+def parse_value(text):
+    kind, _, data = text.partition(":")
+    if kind == "b":
+        return dbus.Boolean(data.lower() in ("1", "true", "yes"))
+    if kind == "y":
+        return dbus.Byte(int(data, 0))
+    if kind == "q":
+        return dbus.UInt16(int(data, 0))
+    if kind == "u":
+        return dbus.UInt32(int(data, 0))
+    if kind == "i":
+        return dbus.Int32(int(data, 0))
+    if kind == "s":
+        return dbus.String(data)
+    if kind == "o":
+        return dbus.ObjectPath(data)
+    if kind == "as":
+        return strings(data.split(",") if data else [])
+    raise ValueError("bad value " + text)
+
+
+class Reply(Exception):
+    """A D-Bus error reply from a handler"""
+
+    def __init__(self, name, text=""):
+        Exception.__init__(self, text)
+        self.name = OFONO + "Error." + name
+
+
+class Ofono:
+    def __init__(self, conn, state, modem_delay_ms):
+        self.conn = conn
+        self.objects = {}           # path -> {interface -> properties}
+        self.delays = {}            # "Iface.Method" -> ms
+        self.failures = {}          # "Iface.Method" -> error name
+        self.drops = set()
+        self.counts = {}
+        self.last_args = {}         # "Iface.Method" -> arguments
+        self.auto_hangup_ms = 0
+        self.message_ref = 0
+        self.modem_visible = modem_delay_ms <= 0
+
+        self.objects[MODEM] = {"Modem": {
+            "Powered": dbus.Boolean(False),
+            "Online": dbus.Boolean(False),
+            "Interfaces": strings([]),
+            "Features": strings([]),
+            "Name": dbus.String("Fake modem"),
+            "Manufacturer": dbus.String("Nokia"),
+            "Model": dbus.String("RX-51"),
+            "Revision": dbus.String("V 21.2011.38-1_PR_F01"),
+            "Serial": dbus.String("004999010640000"),
+        }}
+        self.objects[MODEM].update({
+            "SimManager": {
+                "Present": dbus.Boolean(True),
+                "SubscriberIdentity": dbus.String("244051234567890"),
+                "MobileCountryCode": dbus.String("244"),
+                "MobileNetworkCode": dbus.String("05"),
+                "PinRequired": dbus.String("none"),
+            },
+            "NetworkRegistration": {
+                "Status": dbus.String("registered"),
+                "Name": dbus.String("Elisa"),
+                "MobileCountryCode": dbus.String("244"),
+                "MobileNetworkCode": dbus.String("05"),
+                "LocationAreaCode": dbus.UInt16(0x1234),
+                "CellId": dbus.UInt32(0x56789),
+                "Technology": dbus.String("umts"),
+                "Strength": dbus.Byte(60),
+                "Mode": dbus.String("auto"),
+            },
+            "VoiceCallManager": {},
+            "MessageManager": {
+                "ServiceCenterAddress": dbus.String("+358405202000"),
+                "UseDeliveryReports": dbus.Boolean(False),
+            },
+            "ConnectionManager": {
+                "Attached": dbus.Boolean(True),
+                "RoamingAllowed": dbus.Boolean(False),
+                "Powered": dbus.Boolean(True),
+            },
+            "SupplementaryServices": {"State": dbus.String("idle")},
+            "RadioSettings": {
+                "TechnologyPreference": dbus.String("any"),
+                "FastDormancy": dbus.Boolean(False),
+            },
+            "AudioSettings": {"Active": dbus.Boolean(False)},
+        })
+
+        if state in ("powered", "online"):
+            self.power(True, signal=False)
+        if state == "online":
+            self.online(True, signal=False)
+        if not self.modem_visible:
+            GLib.timeout_add(modem_delay_ms, self.modem_added)
+
+    # --- signals ---
+
+    def signal(self, path, iface, member, signature, *args):
+        msg = dbus.lowlevel.SignalMessage(path, OFONO + iface, member)
+        msg.append(*args, signature=signature)
+        self.conn.send_message(msg)
+
+    def set_property(self, path, iface, name, value, signal=True):
+        self.objects[path][iface][name] = value
+        if signal:
+            self.signal(path, iface, "PropertyChanged", "sv", name, value)
+
+    def modem_added(self):
+        self.modem_visible = True
+        self.signal("/", "Manager", "ModemAdded", "oa{sv}",
+                    dbus.ObjectPath(MODEM), props(self.objects[MODEM]["Modem"]))
+        return False
+
+    # --- modem ---
+
+    def power(self, on, signal=True):
+        if not on:
+            self.online(False, signal)
+        self.set_property(MODEM, "Modem", "Powered", dbus.Boolean(on), signal)
+        self.set_property(MODEM, "Modem", "Interfaces",
+                          interface_names(POWERED_INTERFACES if on else []), signal)
+        self.set_property(MODEM, "Modem", "Features",
+                          strings(POWERED_FEATURES if on else []), signal)
+        if not on:
+            for path in self.call_paths():
+                self.remove_call(path, "local")
+
+    def online(self, on, signal=True):
+        modem = self.objects[MODEM]["Modem"]
+        if on == bool(modem["Online"]):
+            return
+        self.set_property(MODEM, "Modem", "Online", dbus.Boolean(on), signal)
+        extra = ONLINE_INTERFACES if on else []
+        self.set_property(MODEM, "Modem", "Interfaces",
+                          interface_names(POWERED_INTERFACES + extra), signal)
+        extra = ONLINE_FEATURES if on else []
+        self.set_property(MODEM, "Modem", "Features",
+                          strings(POWERED_FEATURES + extra), signal)
+
+    def interfaces(self, path):
+        if path == MODEM:
+            present = self.objects[MODEM]["Modem"]["Interfaces"]
+            return ["Modem"] + [str(i).replace(OFONO, "") for i in present]
+        return list(self.objects.get(path, {}))
+
+    # --- calls ---
+
+    def call_paths(self):
+        return sorted(p for p, o in self.objects.items() if "VoiceCall" in o)
+
+    def add_call(self, number, name, state):
+        for n in range(1, MAX_CALL_ID + 1):
+            path = "%s/voicecall%02d" % (MODEM, n)
+            if path not in self.objects:
+                break
+        else:
+            raise Reply("Failed", "no free call id")
+        call = {
+            "LineIdentification": dbus.String(number),
+            "Name": dbus.String(name),
+            "State": dbus.String(state),
+            "Multiparty": dbus.Boolean(False),
+        }
+        self.objects[path] = {"VoiceCall": call}
+        self.signal(MODEM, "VoiceCallManager", "CallAdded", "oa{sv}",
+                    dbus.ObjectPath(path), props(call))
+        return path
+
+    def remove_call(self, path, reason):
+        if path not in self.objects:
+            return False
+        del self.objects[path]
+        self.signal(path, "VoiceCall", "DisconnectReason", "s", reason)
+        self.signal(MODEM, "VoiceCallManager", "CallRemoved", "o",
+                    dbus.ObjectPath(path))
+        return True
+
+    # --- methods, each returns (signature, args) ---
+
+    def GetModems(self, path, iface, args):
+        modems = []
+        if self.modem_visible:
+            modems.append((dbus.ObjectPath(MODEM),
+                           props(self.objects[MODEM]["Modem"])))
+        return "a(oa{sv})", [modems]
+
+    def GetProperties(self, path, iface, args):
+        return "a{sv}", [props(self.objects[path][iface])]
+
+    def SetProperty(self, path, iface, args):
+        name, value = str(args[0]), plain(args[1])
+        after = []
+        if iface == "Modem" and name == "Powered":
+            after.append(lambda: self.power(bool(value)))
+        elif iface == "Modem" and name == "Online":
+            if value and not self.objects[MODEM]["Modem"]["Powered"]:
+                raise Reply("NotAvailable", "modem is off")
+            after.append(lambda: self.online(bool(value)))
+        elif iface == "ConnectionContext" and name == "Active":
+            after.append(lambda: self.activate(path, bool(value)))
+        else:
+            after.append(lambda: self.set_property(path, iface, name, value))
+        return "", [], after
+
+    def activate(self, path, on):
+        if on == bool(self.objects[path]["ConnectionContext"]["Active"]):
+            return
+        settings = {}
+        if on:
+            settings = {
+                "Interface": dbus.String("gprs0"),
+                "Method": dbus.String("static"),
+                "Address": dbus.String("10.0.0.2"),
+                "Netmask": dbus.String("255.255.255.0"),
+                "DomainNameServers": strings(["10.0.0.1"]),
+            }
+        # like ofono, Settings is announced before Active
+        self.set_property(path, "ConnectionContext", "Settings", props(settings))
+        self.set_property(path, "ConnectionContext", "Active", dbus.Boolean(on))
+
+    def GetContexts(self, path, iface, args):
+        contexts = [(dbus.ObjectPath(p), props(o["ConnectionContext"]))
+                    for p, o in sorted(self.objects.items())
+                    if "ConnectionContext" in o]
+        return "a(oa{sv})", [contexts]
+
+    def AddContext(self, path, iface, args):
+        if CONTEXT not in self.objects:
+            self.objects[CONTEXT] = {"ConnectionContext": {
+                "Active": dbus.Boolean(False),
+                "AccessPointName": dbus.String(""),
+                "Type": dbus.String(str(args[0]) if args else "internet"),
+                "Name": dbus.String("Internet"),
+                "Settings": props({}),
+            }}
+        return "o", [dbus.ObjectPath(CONTEXT)]
+
+    def Dial(self, path, iface, args):
+        # CallAdded goes out before the reply, as from ofono
+        call = self.add_call(str(args[0]), "", "dialing")
+        if self.auto_hangup_ms:
+            GLib.timeout_add(self.auto_hangup_ms,
+                             lambda: self.remove_call(call, "remote") and False)
+        return "o", [dbus.ObjectPath(call)]
+
+    def GetCalls(self, path, iface, args):
+        calls = [(dbus.ObjectPath(p), props(self.objects[p]["VoiceCall"]))
+                 for p in self.call_paths()]
+        return "a(oa{sv})", [calls]
+
+    def Answer(self, path, iface, args):
+        if path not in self.objects:
+            raise Reply("NotFound")
+        return "", [], [lambda: self.set_property(path, "VoiceCall", "State",
+                                                  dbus.String("active"))]
+
+    def Hangup(self, path, iface, args):
+        if path not in self.objects:
+            raise Reply("NotFound")
+        return "", [], [lambda: self.remove_call(path, "local")]
+
+    def SendMessage(self, path, iface, args):
+        self.message_ref = (self.message_ref + 1) % 256
+        return "o", [dbus.ObjectPath("%s/message_%d" % (MODEM, self.message_ref))]
+
+    def SendPdu(self, path, iface, args):
+        self.message_ref = (self.message_ref + 1) % 256
+        return "v", [dbus.Byte(self.message_ref)]
+
+    def Scan(self, path, iface, args):
+        netreg = self.objects[MODEM]["NetworkRegistration"]
+        operator = {
+            "Name": netreg["Name"],
+            "Status": dbus.String("current"),
+            "MobileCountryCode": netreg["MobileCountryCode"],
+            "MobileNetworkCode": netreg["MobileNetworkCode"],
+        }
+        path = "%s/operator/%s%s" % (MODEM, operator["MobileCountryCode"],
+                                     operator["MobileNetworkCode"])
+        return "a(oa{sv})", [[(dbus.ObjectPath(path), props(operator))]]
+
+    GetOperators = Scan
+
+    def Initiate(self, path, iface, args):
+        return "sv", ["USSD", dbus.String("Reply to " + str(args[0]))]
+
+    def Respond(self, path, iface, args):
+        return "s", ["Reply to " + str(args[0])]
+
+    # --- dispatch ---
+
+    def handle(self, conn, msg):
+        if msg.get_type() != dbus.lowlevel.MESSAGE_TYPE_METHOD_CALL:
+            return dbus.lowlevel.HANDLER_RESULT_NOT_YET_HANDLED
+        if not (msg.get_interface() or "").startswith(OFONO):
+            return dbus.lowlevel.HANDLER_RESULT_NOT_YET_HANDLED
+
+        path, member = msg.get_path(), msg.get_member()
+        iface = msg.get_interface()[len(OFONO):]
+        key = iface + "." + member
+        self.counts[key] = self.counts.get(key, 0) + 1
+        self.last_args[key] = msg.get_args_list()
+        after = []
+
+        try:
+            if path != "/" and iface not in self.interfaces(path):
+                raise Reply("NotImplemented", "no %s on %s" % (iface, path))
+            if key in self.failures:
+                raise Reply(self.failures[key], "failure injected")
+            if key in NOOP:
+                signature, args = "", []
+            elif hasattr(self, member):
+                result = getattr(self, member)(path, iface, msg.get_args_list())
+                signature, args = result[:2]
+                if len(result) > 2:
+                    after = result[2]
+            else:
+                raise Reply("NotImplemented", key)
+            reply = dbus.lowlevel.MethodReturnMessage(msg)
+            if signature:
+                reply.append(*args, signature=signature)
+        except Reply as e:
+            reply = dbus.lowlevel.ErrorMessage(msg, e.name, str(e))
+
+        if key in self.drops:
+            return dbus.lowlevel.HANDLER_RESULT_HANDLED
+
+        def send():
+            conn.send_message(reply)
+            # effects of the call follow its reply
+            for effect in after:
+                effect()
+            return False
+
+        if self.delays.get(key):
+            GLib.timeout_add(self.delays[key], send)
+        else:
+            send()
+        return dbus.lowlevel.HANDLER_RESULT_HANDLED
+
+    # --- stdin commands, each returns the reply line ---
+
+    def command(self, words, done):
+        cmd, args = words[0], words[1:]
+        if cmd == "set":
+            path, iface, name = args[0], args[1], args[2]
+            self.objects[path][iface]       # KeyError if unknown
+            self.set_property(path, iface, name, parse_value(args[3]))
+        elif cmd == "get":
+            value = self.objects[args[0]][args[1]][args[2]]
+            if isinstance(value, dbus.Array):
+                return "ok " + ",".join(str(v) for v in value)
+            if isinstance(value, int):      # Byte prints as a character
+                return "ok %d" % value
+            return "ok %s" % value
+        elif cmd == "call-incoming":
+            name = " ".join(args[1:])
+            return "ok " + self.add_call(args[0], name, "incoming")
+        elif cmd == "call-state":
+            self.objects[args[0]]["VoiceCall"]
+            self.set_property(args[0], "VoiceCall", "State", dbus.String(args[1]))
+        elif cmd == "call-remove":
+            if not self.remove_call(args[0], args[1] if len(args) > 1 else "remote"):
+                return "error no call " + args[0]
+        elif cmd == "calls":
+            paths = self.call_paths()
+            return " ".join(["ok", str(len(paths))] + paths)
+        elif cmd == "auto-hangup":
+            self.auto_hangup_ms = int(args[0])
+        elif cmd == "sms-incoming":
+            info = props({"Sender": dbus.String(args[0]),
+                          "LocalSentTime": dbus.String("2010-10-10T10:10:10+0300"),
+                          "SentTime": dbus.String("2010-10-10T10:10:10+0300")})
+            self.signal(MODEM, "MessageManager", "IncomingMessage", "sa{sv}",
+                        " ".join(args[1:]), info)
+        elif cmd == "ussd-request":
+            self.signal(MODEM, "SupplementaryServices", "RequestReceived", "s",
+                        " ".join(args))
+        elif cmd == "storm":
+            start = time.monotonic()
+            self.storm(args[0], int(args[1]))
+            self.conn.flush()
+            return "ok %.6f" % (time.monotonic() - start)
+        elif cmd == "delay":
+            self.delays[args[0]] = int(args[1])
+        elif cmd == "fail":
+            if args[1] == "off":
+                self.failures.pop(args[0], None)
+            else:
+                self.failures[args[0]] = args[1]
+        elif cmd == "drop":
+            (self.drops.add if args[1] == "on" else self.drops.discard)(args[0])
+        elif cmd == "count":
+            return "ok %d" % self.counts.get(args[0], 0)
+        elif cmd == "last":
+            if args[0] not in self.last_args:
+                return "error no call to " + args[0]
+            return " ".join(["ok"] + [str(a) for a in self.last_args[args[0]]])
+        elif cmd == "sleep":
+            GLib.timeout_add(int(args[0]), lambda: done("ok") and False)
+            return None
+        elif cmd == "sync":
+            self.conn.flush()
+        elif cmd == "quit":
+            self.conn.flush()
+            done("ok")
+            sys.exit(0)
+        else:
+            return "error unknown command " + cmd
+        return "ok"
+
+    def storm(self, kind, count):
+        netreg = self.objects[MODEM]["NetworkRegistration"]
+        for i in range(count):
+            if kind == "strength":
+                self.set_property(MODEM, "NetworkRegistration", "Strength",
+                                  dbus.Byte(i % 101))
+            elif kind == "netreg":
+                self.set_property(MODEM, "NetworkRegistration", "CellId",
+                                  dbus.UInt32(netreg["CellId"] + 1))
+            elif kind == "calls":
+                path = self.add_call("+35840%07d" % i, "", "incoming")
+                self.remove_call(path, "remote")
+            elif kind == "sms":
+                self.command(["sms-incoming", "+358401234567", "storm", str(i)], None)
+            elif kind == "ussd":
+                self.command(["ussd-request", "storm", str(i)], None)
+            else:
+                raise ValueError("unknown storm " + kind)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--address", default=os.environ.get("DBUS_SYSTEM_BUS_ADDRESS"),
+                        help="bus to serve on, DBUS_SYSTEM_BUS_ADDRESS by default")
+    parser.add_argument("--state", choices=("off", "powered", "online"), default="off",
+                        help="modem state at start, off like a fresh ofono")
+    parser.add_argument("--modem-delay-ms", type=int, default=0,
+                        help="announce the modem with ModemAdded this late")
+    options = parser.parse_args()
+    if not options.address:
+        parser.error("no bus address")
+
+    DBusGMainLoop(set_as_default=True)
+    conn = dbus.bus.BusConnection(options.address)
+    ofono = Ofono(conn, options.state, options.modem_delay_ms)
+    conn.add_message_filter(ofono.handle)
+    if conn.request_name("org.ofono", dbus.bus.NAME_FLAG_DO_NOT_QUEUE) \
+            != dbus.bus.REQUEST_NAME_REPLY_PRIMARY_OWNER:
+        sys.exit("org.ofono is taken")
+
+    def done(line):
+        sys.stdout.write(line + "\n")
+        sys.stdout.flush()
+
+    pending = [b""]
+
+    def readable(fd, condition):
+        data = os.read(fd, 4096)
+        if not data:
+            loop.quit()
+            return False
+        pending[0] += data
+        while b"\n" in pending[0]:
+            line, pending[0] = pending[0].split(b"\n", 1)
+            words = line.decode().split()
+            if not words:
+                continue
+            try:
+                reply = ofono.command(words, done)
+            except (KeyError, IndexError, ValueError) as e:
+                reply = "error %s: %r" % (words[0], e)
+            if reply is not None:
+                done(reply)
+        return True
+
+    loop = GLib.MainLoop()
+    GLib.io_add_watch(sys.stdin.fileno(), GLib.IO_IN | GLib.IO_HUP, readable)
+    done("ready")
+    loop.run()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,312 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/*
+ * Incoming SMS text encoding over a corpus: the GSM 7-bit tables and
+ * septet packing of pdu.c against the iconv UCS2 encodePDU they
+ * replaced, kept below as it was.
+ *
+ *   gsm7bench [-c corpus] [-n messages] [-l label] [-o out.json]
+ *
+ * convert is UTF-8 to user data octets only, g_convert() against
+ * utf8ToGsm() and packSeptets() with the UCS2 fallback. encode is the
+ * whole thing, encodePDU() into the buffer smsIncomingMessage()
+ * allocated against encodeDeliverPDUs(). The corpus is sms-corpus.txt
+ * unless -c gives another, one message per line.
+ */
+
+// the encoder is static
+#include "../src/pdu.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include <time.h>
+
+/*** The encoder before the GSM alphabet ***/
+
+static inline void oldSetOctet(unsigned char *pdu, int *offset, guint8 oct)
+{
+    setSemiOctet(pdu, offset, makeSemiOctet((oct & 0xf0) >> 4));
+    setSemiOctet(pdu, offset, makeSemiOctet(oct & 0x0f));
+}
+
+static int encodePDU(unsigned char *pdu, const char *message, const char *smsc, const char *sender)
+{
+    int ofs = 0;
+    setSemiOctet(pdu, &ofs, '0');
+
+    // SMS Service Center
+    int smcSize = encodeNumber(&pdu[2], smsc[0] == '+' ? &smsc[1] : "0000");
+    if (!smcSize) return 0;
+    setSemiOctet(pdu, &ofs, makeSemiOctet(smcSize/2 + (smcSize & 0x1) + 1)); // length (in octets)
+    ofs += smcSize + (smcSize & 0x1) + 2;
+
+    setSemiOctet(pdu, &ofs, '0');
+    setSemiOctet(pdu, &ofs, '4'); // First octet of the SMS-DELIVER PDU
+
+    // Sender
+    int senderSize = encodeNumber(&pdu[ofs+2], sender[0] == '+' ? &sender[1] : "0000");
+    if (!senderSize) return 0;
+    setSemiOctet(pdu, &ofs, '0');
+    setSemiOctet(pdu, &ofs, makeSemiOctet(senderSize));// length
+    ofs += senderSize + (senderSize & 0x1) + 2;
+
+    oldSetOctet(pdu, &ofs, 0x00); // TP-PID
+    oldSetOctet(pdu, &ofs, 0x08); // TP-DCS (Class Unspecified, UCS2)
+    oldSetOctet(pdu, &ofs, 0x99); // TP-SCTS
+
+    // Timestamp (whatever, don't realy care about it)
+    oldSetOctet(pdu, &ofs, 0x30);
+    oldSetOctet(pdu, &ofs, 0x92);
+    oldSetOctet(pdu, &ofs, 0x51);
+    oldSetOctet(pdu, &ofs, 0x61);
+    oldSetOctet(pdu, &ofs, 0x95);
+    oldSetOctet(pdu, &ofs, 0x80);
+
+    gsize converted;
+    char *ucs2_encoded = g_convert(message, -1, "UCS-2BE//TRANSLIT", "UTF-8",
+                                   NULL, &converted, NULL);
+
+    if (!ucs2_encoded || !converted)
+        return 0;
+
+    if (converted > 254)
+        converted = 254;
+
+    oldSetOctet(pdu, &ofs, (guint8)converted); // TP-TP-User-Data-Length
+    const char *strPtr = ucs2_encoded;
+    while(converted-- > 0)
+        oldSetOctet(pdu, &ofs, (guint8) *strPtr++);
+
+    g_free(ucs2_encoded);
+    pdu[ofs] = 0;
+    return ofs;
+}
+
+/*** Corpus ***/
+
+#define MAX_MESSAGES 1024
+
+static char *corpus[MAX_MESSAGES];
+static int corpusSize;
+
+/* One message per line, # comments, \n for a line break */
+static int loadCorpus(const char *path)
+{
+    char line[2048];
+    FILE *file = fopen(path, "r");
+
+    if (!file) {
+        perror(path);
+        return -1;
+    }
+    while (corpusSize < MAX_MESSAGES && fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\n")] = 0;
+        if (!line[0] || '#' == line[0])
+            continue;
+
+        char *in = line, *out = line;
+        while (*in) {
+            if ('\\' == in[0] && 'n' == in[1]) {
+                *out++ = '\n';
+                in += 2;
+            } else {
+                *out++ = *in++;
+            }
+        }
+        *out = 0;
+        corpus[corpusSize++] = g_strdup(line);
+    }
+    fclose(file);
+    return corpusSize ? 0 : -1;
+}
+
+/*** Conversions, the user data octets of a message ***/
+
+static guint8 text[4096], packed[4096];
+
+static int convertIconv(const char *message)
+{
+    gsize converted = 0;
+    char *ucs2 = g_convert(message, -1, "UCS-2BE//TRANSLIT", "UTF-8", NULL, &converted, NULL);
+
+    g_free(ucs2);
+    return ucs2 ? (int) converted : -1;
+}
+
+static int convertTable(const char *message)
+{
+    int length = utf8ToGsm(message, text);
+
+    if (length < 0)
+        return utf8ToUcs2(message, text);
+    return packSeptets(text, length, 0, packed);
+}
+
+/* Both kernels give back the text, and iconv's UCS2 where it has one */
+static int check()
+{
+    int i;
+
+    for (i = 0; i < corpusSize; i++) {
+        const char *message = corpus[i];
+        int length = utf8ToGsm(message, text);
+        gchar *back;
+
+        if (length >= 0) {
+            packSeptets(text, length, 0, packed);
+            back = gsmToUtf8(packed, length, 0);
+        } else {
+            length = utf8ToUcs2(message, text);
+            back = ucs2ToUtf8(text, length);
+
+            gsize converted = 0;
+            char *ucs2 = g_convert(message, -1, "UCS-2BE", "UTF-8", NULL, &converted, NULL);
+            if (ucs2 && ((int) converted != length || memcmp(ucs2, text, length))) {
+                fprintf(stderr, "UCS2 differs from iconv: %s\n", message);
+                return -1;
+            }
+            g_free(ucs2);
+        }
+        if (strcmp(back, message)) {
+            fprintf(stderr, "round trip failed: %s -> %s\n", message, back);
+            return -1;
+        }
+        g_free(back);
+    }
+    return 0;
+}
+
+/*** Timing ***/
+
+static uint64_t nowNs()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static volatile int sink;
+
+typedef int (*EncodeFunc)(const char *message);
+
+static int encodeOld(const char *message)
+{
+    // as smsIncomingMessage sized it
+    unsigned char *pdu = malloc(240 + strlen(message) * 4);
+    int len = encodePDU(pdu, message, "+79168999100", "+358401234567");
+
+    free(pdu);
+    return len;
+}
+
+static int encodeNew(const char *message)
+{
+    char **pdus;
+    int count = encodeDeliverPDUs(message, "+79168999100", "+358401234567", FALSE, &pdus);
+
+    g_free(pdus);
+    return count;
+}
+
+/* ns per message, best of three, over the corpus in order */
+static double measure(EncodeFunc encode, unsigned long messages)
+{
+    double best = 0;
+    int round;
+
+    for (round = 0; round < 3; round++) {
+        uint64_t start = nowNs();
+        unsigned long i;
+        int acc = 0;
+
+        for (i = 0; i < messages; i++)
+            acc += encode(corpus[i % corpusSize]);
+        sink = acc;
+
+        double ns = (double) (nowNs() - start) / messages;
+        if (!round || ns < best)
+            best = ns;
+    }
+    return best;
+}
+
+int main(int argc, char **argv)
+{
+    const char *corpusPath = SMS_CORPUS, *label = "", *outPath = NULL;
+    unsigned long messages = 200000;
+    int opt, i;
+
+    while ((opt = getopt(argc, argv, "c:n:l:o:")) != -1) {
+        switch (opt) {
+            case 'c': corpusPath = optarg; break;
+            case 'n': messages = strtoul(optarg, NULL, 0); break;
+            case 'l': label = optarg; break;
+            case 'o': outPath = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-c corpus] [-n messages] [-l label] [-o out.json]\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+
+    if (loadCorpus(corpusPath) || check())
+        return 1;
+
+    // what the corpus is, and what each encoding puts on the air
+    int gsm = 0, dropped = 0;
+    long bytes = 0, ucs2Octets = 0, tableOctets = 0;
+    for (i = 0; i < corpusSize; i++) {
+        int octets = convertIconv(corpus[i]);
+        bytes += strlen(corpus[i]);
+        if (utf8ToGsm(corpus[i], text) >= 0)
+            gsm++;
+        if (octets < 0)
+            dropped++;
+        else
+            ucs2Octets += octets;
+        tableOctets += convertTable(corpus[i]);
+    }
+
+    double convertOld = measure(convertIconv, messages);
+    double convertNew = measure(convertTable, messages);
+    double encodeOldNs = measure(encodeOld, messages);
+    double encodeNewNs = measure(encodeNew, messages);
+    double mbPerNs = (double) bytes / corpusSize / 1e6 * 1e9;
+
+    FILE *out = outPath ? fopen(outPath, "w") : stdout;
+    if (!out) {
+        perror(outPath);
+        return 1;
+    }
+    fprintf(out, "{\n  \"benchmark\": \"gsm7bench\",\n  \"label\": \"%s\",\n", label);
+    fprintf(out, "  \"corpus\": { \"messages\": %d, \"gsm7\": %d, \"ucs2\": %d, \"utf8_bytes\": %ld },\n",
+            corpusSize, gsm, corpusSize - gsm, bytes);
+    fprintf(out, "  \"user_data_octets\": { \"iconv_ucs2\": %ld, \"gsm7_or_ucs2\": %ld, "
+            "\"iconv_failed\": %d },\n", ucs2Octets, tableOctets, dropped);
+    fprintf(out, "  \"messages\": %lu,\n  \"unit\": \"ns per message\",\n", messages);
+    fprintf(out, "  \"convert\": { \"iconv\": %.1f, \"table\": %.1f, "
+            "\"iconv_mb_s\": %.1f, \"table_mb_s\": %.1f },\n",
+            convertOld, convertNew, mbPerNs / convertOld, mbPerNs / convertNew);
+    fprintf(out, "  \"encode\": { \"encodePDU\": %.1f, \"encodeDeliverPDUs\": %.1f }\n}\n",
+            encodeOldNs, encodeNewNs);
+    if (out != stdout)
+        fclose(out);
+    return 0;
+}
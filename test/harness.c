@@ -0,0 +1,773 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
+#include <dbus/dbus.h>
+
+#define LOG_TAG "HARNESS"
+#include <utils/Log.h>
+
+#include "harness.h"
+
+#ifndef FAKE_OFONO
+#define FAKE_OFONO "fake-ofono.py"
+#endif
+
+#define HARNESS_MAGIC       0x4f52494c
+#define REPLY_TIMEOUT       60000   // ms for a fake ofono command, storms take a while
+#define START_TIMEOUT       10000   // ms for dbus-daemon and the fake ofono to come up
+#define MAX_UNSOL           32      // from RIL_UNSOL_RESPONSE_BASE
+
+typedef struct {
+    HarnessRequest  req;            // first, the token points here
+    uint32_t        magic;
+} Token;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond;
+static pthread_once_t condOnce = PTHREAD_ONCE_INIT;
+
+static const RIL_RadioFunctions *funcs;
+static unsigned badCompletions;
+static unsigned unsolCount[MAX_UNSOL];
+static HarnessResponse unsolLast[MAX_UNSOL];
+
+static pid_t busPid, ofonoPid;
+static int ofonoIn = -1, ofonoOut = -1;
+static pthread_mutex_t ofonoLock = PTHREAD_MUTEX_INITIALIZER;
+
+uint64_t harnessNow()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*** Checks and statistics ***/
+
+int harnessFailures;
+
+int harnessResult()
+{
+    printf("%s\n", harnessFailures ? "FAILED" : "PASSED");
+    return harnessFailures ? 1 : 0;
+}
+
+static int compareTimes(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+
+    return x < y ? -1 : x > y;
+}
+
+void harnessSortTimes(uint64_t *times, unsigned count)
+{
+    qsort(times, count, sizeof(uint64_t), compareTimes);
+}
+
+uint64_t harnessPercentile(const uint64_t *times, unsigned count, double p)
+{
+    unsigned rank = (unsigned) (p / 100 * count + 0.999999);
+
+    if (!count)
+        return 0;
+    return times[rank ? rank - 1 : 0];
+}
+
+uint64_t harnessMedian(uint64_t *times, unsigned count)
+{
+    harnessSortTimes(times, count);
+    return harnessPercentile(times, count, 50);
+}
+
+// deadlines are on CLOCK_MONOTONIC, so cond has to wait on it too
+static void condInit()
+{
+    pthread_condattr_t attr;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static void deadline(struct timespec *ts, int timeoutMs)
+{
+    pthread_once(&condOnce, condInit);
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += timeoutMs / 1000;
+    ts->tv_nsec += (timeoutMs % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+/*** Responses ***/
+
+static char *strdupOrNull(const char *str)
+{
+    return str ? strdup(str) : NULL;
+}
+
+static void copyStrings(HarnessResponse *out, char **strings, int count)
+{
+    int i;
+
+    out->strings = calloc(count + 1, sizeof(char *));
+    out->nstrings = count;
+    for (i = 0; i < count; i++)
+        out->strings[i] = strdupOrNull(strings[i]);
+}
+
+static void copyInts(HarnessResponse *out, const int *ints, int count)
+{
+    if (count > (int) (sizeof(out->ints) / sizeof(out->ints[0])))
+        count = sizeof(out->ints) / sizeof(out->ints[0]);
+    memcpy(out->ints, ints, count * sizeof(int));
+    out->nints = count;
+}
+
+/*
+ * Deep copy of what the framework would get, libril marshals the response
+ * by request type before OnRequestComplete returns in the same way.
+ */
+static void copyResponse(int request, void *response, size_t len, HarnessResponse *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->len = len;
+    if (!response)
+        return;
+
+    switch (request) {
+        // a single string passed as the response itself
+        case RIL_REQUEST_GET_IMSI:
+        case RIL_REQUEST_GET_IMEI:
+        case RIL_REQUEST_GET_IMEISV:
+        case RIL_REQUEST_BASEBAND_VERSION:
+        case RIL_UNSOL_RESPONSE_NEW_SMS:
+            copyStrings(out, (char **) &response, 1);
+            break;
+
+        case RIL_REQUEST_REGISTRATION_STATE:
+        case RIL_REQUEST_GPRS_REGISTRATION_STATE:
+        case RIL_REQUEST_OPERATOR:
+        case RIL_REQUEST_SETUP_DATA_CALL:
+        case RIL_REQUEST_OEM_HOOK_STRINGS:
+        case RIL_REQUEST_QUERY_AVAILABLE_NETWORKS:
+        case RIL_UNSOL_ON_USSD:
+            copyStrings(out, (char **) response, len / sizeof(char *));
+            break;
+
+        case RIL_REQUEST_GET_CURRENT_CALLS: {
+            RIL_Call **calls = (RIL_Call **) response;
+            int i;
+
+            out->ncalls = len / sizeof(RIL_Call *);
+            out->calls = calloc(out->ncalls + 1, sizeof(RIL_Call));
+            for (i = 0; i < out->ncalls; i++) {
+                out->calls[i] = *calls[i];
+                out->calls[i].number = strdupOrNull(calls[i]->number);
+                out->calls[i].name = strdupOrNull(calls[i]->name);
+                out->calls[i].uusInfo = NULL;
+            }
+            break;
+        }
+
+        case RIL_REQUEST_GET_SIM_STATUS: {
+            RIL_CardStatus *status = (RIL_CardStatus *) response;
+            int ints[3] = { status->card_state, status->num_applications,
+                            status->num_applications ? status->applications[0].app_state : 0 };
+            copyInts(out, ints, 3);
+            break;
+        }
+
+        case RIL_REQUEST_SEND_SMS:
+        case RIL_REQUEST_SEND_SMS_EXPECT_MORE: {
+            RIL_SMS_Response *sms = (RIL_SMS_Response *) response;
+            int ints[2] = { sms->messageRef, sms->errorCode };
+            copyInts(out, ints, 2);
+            break;
+        }
+
+        case RIL_REQUEST_SIGNAL_STRENGTH:
+        case RIL_REQUEST_QUERY_NETWORK_SELECTION_MODE:
+        case RIL_REQUEST_GET_PREFERRED_NETWORK_TYPE:
+        case RIL_REQUEST_CDMA_QUERY_ROAMING_PREFERENCE:
+        case RIL_UNSOL_SIGNAL_STRENGTH:
+            copyInts(out, (const int *) response, len / sizeof(int));
+            break;
+
+        default:
+            break;
+    }
+}
+
+void harnessResponseClear(HarnessResponse *response)
+{
+    int i;
+
+    for (i = 0; i < response->nstrings; i++)
+        free(response->strings[i]);
+    free(response->strings);
+    for (i = 0; i < response->ncalls; i++) {
+        free(response->calls[i].number);
+        free(response->calls[i].name);
+    }
+    free(response->calls);
+    memset(response, 0, sizeof(*response));
+}
+
+/*** RIL_Env ***/
+
+static void onRequestComplete(RIL_Token t, RIL_Errno e, void *response, size_t responselen)
+{
+    Token *token = (Token *) t;
+    uint64_t now = harnessNow();
+
+    pthread_mutex_lock(&lock);
+    if (!token || HARNESS_MAGIC != token->magic || token->req.completions) {
+        badCompletions++;
+        if (token && HARNESS_MAGIC == token->magic)
+            token->req.completions++;
+        pthread_mutex_unlock(&lock);
+        LOGE("bad completion of %p (%s), error %d", t,
+             token && HARNESS_MAGIC == token->magic ?
+                requestToString(token->req.request) : "unknown token", e);
+        return;
+    }
+
+    token->req.error = e;
+    token->req.completions = 1;
+    copyResponse(token->req.request, response, responselen, &token->req.response);
+    token->req.completed = now;
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&lock);
+}
+
+static void onUnsolicitedResponse(int unsol, const void *data, size_t datalen)
+{
+    int slot = unsol - RIL_UNSOL_RESPONSE_BASE;
+
+    if (slot < 0 || slot >= MAX_UNSOL) {
+        LOGE("unknown unsolicited response %d", unsol);
+        return;
+    }
+
+    pthread_mutex_lock(&lock);
+    unsolCount[slot]++;
+    harnessResponseClear(&unsolLast[slot]);
+    copyResponse(unsol, (void *) data, datalen, &unsolLast[slot]);
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&lock);
+}
+
+typedef struct {
+    RIL_TimedCallback   callback;
+    void                *param;
+    struct timeval      delay;
+} TimedCallback;
+
+static void *timedCallbackThread(void *data)
+{
+    TimedCallback *tc = (TimedCallback *) data;
+    struct timespec ts = { tc->delay.tv_sec, tc->delay.tv_usec * 1000 };
+
+    while (nanosleep(&ts, &ts) && EINTR == errno)
+        ;
+    tc->callback(tc->param);
+    free(tc);
+    return NULL;
+}
+
+static void requestTimedCallback(RIL_TimedCallback callback, void *param,
+                                 const struct timeval *relativeTime)
+{
+    TimedCallback *tc = calloc(1, sizeof(TimedCallback));
+    pthread_attr_t attr;
+    pthread_t tid;
+
+    tc->callback = callback;
+    tc->param = param;
+    if (relativeTime)
+        tc->delay = *relativeTime;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_create(&tid, &attr, timedCallbackThread, tc);
+    pthread_attr_destroy(&attr);
+}
+
+static const struct RIL_Env env = {
+    onRequestComplete,
+    onUnsolicitedResponse,
+    requestTimedCallback,
+};
+
+const RIL_RadioFunctions *harnessRilInit(int argc, char **argv)
+{
+    char *defaultArgv[] = { "libofono-ril.so", NULL };
+
+    pthread_once(&condOnce, condInit);
+    if (!argc) {
+        argc = 1;
+        argv = defaultArgv;
+    }
+    // RIL_Init parses its arguments with getopt, as rild hands them over
+    optind = 1;
+    funcs = RIL_Init(&env, argc, argv);
+    if (!funcs) {
+        LOGE("RIL_Init failed");
+        return NULL;
+    }
+
+    // the library shares the system bus connection, which would _exit()
+    // the process when harnessStop() takes the bus down
+    DBusConnection *conn = dbus_bus_get(DBUS_BUS_SYSTEM, NULL);
+    if (conn) {
+        dbus_connection_set_exit_on_disconnect(conn, FALSE);
+        dbus_connection_unref(conn);
+    }
+    return funcs;
+}
+
+HarnessRequest *harnessRequest(int request, void *data, size_t datalen)
+{
+    // tokens live as long as the process, a late completion must not
+    // land in freed memory
+    Token *token = calloc(1, sizeof(Token));
+
+    token->magic = HARNESS_MAGIC;
+    token->req.request = request;
+    token->req.issued = harnessNow();
+    funcs->onRequest(request, data, datalen, (RIL_Token) token);
+    return &token->req;
+}
+
+int harnessWait(HarnessRequest *req, int timeoutMs)
+{
+    struct timespec ts;
+    int ret = 0;
+
+    deadline(&ts, timeoutMs);
+    pthread_mutex_lock(&lock);
+    while (!req->completions && ETIMEDOUT != ret)
+        ret = pthread_cond_timedwait(&cond, &lock, &ts);
+    ret = req->completions ? 0 : -1;
+    pthread_mutex_unlock(&lock);
+    return ret;
+}
+
+HarnessRequest *harnessCall(int request, void *data, size_t datalen, int timeoutMs)
+{
+    HarnessRequest *req = harnessRequest(request, data, datalen);
+
+    if (harnessWait(req, timeoutMs)) {
+        LOGE("%s: no completion in %d ms", requestToString(request), timeoutMs);
+        return NULL;
+    }
+    return req;
+}
+
+unsigned harnessBadCompletions()
+{
+    unsigned count;
+
+    pthread_mutex_lock(&lock);
+    count = badCompletions;
+    pthread_mutex_unlock(&lock);
+    return count;
+}
+
+unsigned harnessUnsolCount(int unsol)
+{
+    int slot = unsol - RIL_UNSOL_RESPONSE_BASE;
+    unsigned count;
+
+    if (slot < 0 || slot >= MAX_UNSOL)
+        return 0;
+    pthread_mutex_lock(&lock);
+    count = unsolCount[slot];
+    pthread_mutex_unlock(&lock);
+    return count;
+}
+
+int harnessWaitUnsol(int unsol, unsigned count, int timeoutMs)
+{
+    int slot = unsol - RIL_UNSOL_RESPONSE_BASE;
+    struct timespec ts;
+    int ret = 0;
+
+    if (slot < 0 || slot >= MAX_UNSOL)
+        return -1;
+
+    deadline(&ts, timeoutMs);
+    pthread_mutex_lock(&lock);
+    while (unsolCount[slot] < count && ETIMEDOUT != ret)
+        ret = pthread_cond_timedwait(&cond, &lock, &ts);
+    ret = unsolCount[slot] >= count ? 0 : -1;
+    pthread_mutex_unlock(&lock);
+    return ret;
+}
+
+void harnessUnsolLast(int unsol, HarnessResponse *out)
+{
+    int slot = unsol - RIL_UNSOL_RESPONSE_BASE;
+    HarnessResponse *last;
+    int i;
+
+    memset(out, 0, sizeof(*out));
+    if (slot < 0 || slot >= MAX_UNSOL)
+        return;
+
+    pthread_mutex_lock(&lock);
+    last = &unsolLast[slot];
+    *out = *last;
+    if (last->strings)
+        copyStrings(out, last->strings, last->nstrings);
+    if (last->calls) {
+        out->calls = calloc(last->ncalls + 1, sizeof(RIL_Call));
+        for (i = 0; i < last->ncalls; i++) {
+            out->calls[i] = last->calls[i];
+            out->calls[i].number = strdupOrNull(last->calls[i].number);
+            out->calls[i].name = strdupOrNull(last->calls[i].name);
+        }
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+int harnessWaitRadio(RIL_RadioState state, int timeoutMs)
+{
+    struct timespec ts;
+    int ret = 0;
+
+    deadline(&ts, timeoutMs);
+    pthread_mutex_lock(&lock);
+    // every change is announced with RADIO_STATE_CHANGED, which wakes us
+    while (funcs->onStateRequest() != state && ETIMEDOUT != ret)
+        ret = pthread_cond_timedwait(&cond, &lock, &ts);
+    ret = funcs->onStateRequest() == state ? 0 : -1;
+    pthread_mutex_unlock(&lock);
+    return ret;
+}
+
+/*** Private bus ***/
+
+static pid_t spawn(char *const argv[], int *in, int *out)
+{
+    int inPipe[2] = { -1, -1 }, outPipe[2] = { -1, -1 };
+    pid_t pid;
+
+    if ((in && pipe(inPipe)) || (out && pipe(outPipe))) {
+        LOGE("pipe: %s", strerror(errno));
+        return -1;
+    }
+
+    pid = fork();
+    if (pid < 0) {
+        LOGE("fork: %s", strerror(errno));
+        return -1;
+    }
+    if (!pid) {
+        // don't outlive the harness, even if it crashes
+        prctl(PR_SET_PDEATHSIG, SIGKILL);
+        if (in) {
+            dup2(inPipe[0], 0);
+            close(inPipe[0]);
+            close(inPipe[1]);
+        }
+        if (out) {
+            dup2(outPipe[1], 1);
+            close(outPipe[0]);
+            close(outPipe[1]);
+        }
+        execvp(argv[0], argv);
+        fprintf(stderr, "can't run %s: %s\n", argv[0], strerror(errno));
+        _exit(127);
+    }
+
+    if (in) {
+        close(inPipe[0]);
+        *in = inPipe[1];
+        fcntl(*in, F_SETFD, FD_CLOEXEC);
+    }
+    if (out) {
+        close(outPipe[1]);
+        *out = outPipe[0];
+        fcntl(*out, F_SETFD, FD_CLOEXEC);
+    }
+    return pid;
+}
+
+/* One line from fd, without the newline; -1 on timeout or EOF */
+static int readLine(int fd, char *buf, size_t size, int timeoutMs)
+{
+    uint64_t end = harnessNow() + (uint64_t) timeoutMs * 1000;
+    size_t len = 0;
+
+    while (len + 1 < size) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        uint64_t now = harnessNow();
+        char c;
+
+        if (now >= end || poll(&pfd, 1, (end - now) / 1000 + 1) <= 0)
+            return -1;
+        if (read(fd, &c, 1) != 1)
+            return -1;
+        if ('\n' == c)
+            break;
+        buf[len++] = c;
+    }
+    buf[len] = 0;
+    return 0;
+}
+
+static void reap(pid_t *pid, int sig)
+{
+    if (*pid > 0) {
+        kill(*pid, sig);
+        waitpid(*pid, NULL, 0);
+        *pid = 0;
+    }
+}
+
+static void ofonoClose()
+{
+    if (ofonoIn >= 0)
+        close(ofonoIn);
+    if (ofonoOut >= 0)
+        close(ofonoOut);
+    ofonoIn = ofonoOut = -1;
+}
+
+void harnessStop()
+{
+    pthread_mutex_lock(&ofonoLock);
+    ofonoClose();
+    reap(&ofonoPid, SIGTERM);
+    pthread_mutex_unlock(&ofonoLock);
+    reap(&busPid, SIGTERM);
+}
+
+int harnessBusStart()
+{
+    const char *daemon = getenv("HARNESS_DBUS_DAEMON");
+    char *argv[] = { (char *) (daemon ? daemon : "dbus-daemon"), "--session",
+                     "--nofork", "--nopidfile", "--print-address=1", NULL };
+    char address[512];
+    int out;
+
+    busPid = spawn(argv, NULL, &out);
+    if (busPid < 0)
+        return -1;
+    atexit(harnessStop);
+
+    if (readLine(out, address, sizeof(address), START_TIMEOUT) || !address[0]) {
+        LOGE("dbus-daemon didn't tell its address");
+        close(out);
+        return -1;
+    }
+    close(out);
+
+    // the library connects to the system bus, fake-ofono.py to the session bus
+    setenv("DBUS_SYSTEM_BUS_ADDRESS", address, 1);
+    setenv("DBUS_SESSION_BUS_ADDRESS", address, 1);
+    LOGI("private bus at %s", address);
+    return 0;
+}
+
+/*** Fake ofono ***/
+
+int harnessOfonoStart(const char *options)
+{
+    const char *python = getenv("HARNESS_PYTHON");
+    const char *script = getenv("HARNESS_FAKE_OFONO");
+    char command[1024];
+    char line[256];
+
+    // through the shell, so options are split like on the command line
+    snprintf(command, sizeof(command), "exec %s %s %s",
+             python ? python : "python3", script ? script : FAKE_OFONO,
+             options ? options : "");
+    char *argv[] = { "/bin/sh", "-c", command, NULL };
+
+    pthread_mutex_lock(&ofonoLock);
+    ofonoPid = spawn(argv, &ofonoIn, &ofonoOut);
+    if (ofonoPid < 0) {
+        pthread_mutex_unlock(&ofonoLock);
+        return -1;
+    }
+
+    if (readLine(ofonoOut, line, sizeof(line), START_TIMEOUT) || strcmp(line, "ready")) {
+        LOGE("fake ofono didn't start: %s", command);
+        ofonoClose();
+        reap(&ofonoPid, SIGKILL);
+        pthread_mutex_unlock(&ofonoLock);
+        return -1;
+    }
+    pthread_mutex_unlock(&ofonoLock);
+    return 0;
+}
+
+void harnessOfonoKill()
+{
+    pthread_mutex_lock(&ofonoLock);
+    ofonoClose();
+    reap(&ofonoPid, SIGKILL);
+    pthread_mutex_unlock(&ofonoLock);
+}
+
+int harnessOfono(char *reply, size_t size, const char *fmt, ...)
+{
+    char command[1024];
+    char line[4096];
+    va_list ap;
+    int len;
+
+    va_start(ap, fmt);
+    len = vsnprintf(command, sizeof(command) - 1, fmt, ap);
+    va_end(ap);
+    if (len < 0 || len >= (int) sizeof(command) - 1)
+        return -1;
+    command[len++] = '\n';
+
+    pthread_mutex_lock(&ofonoLock);
+    if (ofonoIn < 0 || write(ofonoIn, command, len) != len
+        || readLine(ofonoOut, line, sizeof(line), REPLY_TIMEOUT))
+    {
+        pthread_mutex_unlock(&ofonoLock);
+        LOGE("fake ofono: no reply to %.*s", len - 1, command);
+        return -1;
+    }
+    pthread_mutex_unlock(&ofonoLock);
+
+    if (reply)
+        snprintf(reply, size, "%s", strncmp(line, "ok", 2) ? line : line + (line[2] ? 3 : 2));
+    if (strncmp(line, "ok", 2)) {
+        LOGE("fake ofono: %.*s: %s", len - 1, command, line);
+        return -1;
+    }
+    return 0;
+}
+
+/*** Bring-up ***/
+
+static char **statsLines(int *count)
+{
+    char *command = "stats";
+    HarnessRequest *req = harnessCall(RIL_REQUEST_OEM_HOOK_STRINGS,
+                                      &command, sizeof(char *), 5000);
+
+    if (!req || RIL_E_SUCCESS != req->error) {
+        *count = 0;
+        return NULL;
+    }
+    *count = req->response.nstrings;
+    return req->response.strings;
+}
+
+char *harnessStatsLine(const char *prefix)
+{
+    int count, i;
+    char **lines = statsLines(&count);
+
+    for (i = 0; i < count; i++)
+        if (lines[i] && !strncmp(lines[i], prefix, strlen(prefix)))
+            return strdup(lines[i]);
+    return NULL;
+}
+
+int harnessWaitSynced(int timeoutMs)
+{
+    uint64_t end = harnessNow() + (uint64_t) timeoutMs * 1000;
+
+    do {
+        char *line = harnessStatsLine("bringup");
+        int synced = line && !strstr(line, "pending");
+
+        free(line);
+        if (synced)
+            return 0;
+        usleep(10000);
+    } while (harnessNow() < end);
+    return -1;
+}
+
+int harnessWaitRegistered(int timeoutMs)
+{
+    uint64_t end = harnessNow() + (uint64_t) timeoutMs * 1000;
+
+    do {
+        HarnessRequest *req = harnessCall(RIL_REQUEST_REGISTRATION_STATE, NULL, 0, timeoutMs);
+
+        if (req && RIL_E_SUCCESS == req->error && req->response.nstrings > 0 &&
+            req->response.strings[0] && !strcmp(req->response.strings[0], "1"))
+            return 0;
+        usleep(10000);
+    } while (harnessNow() < end);
+    return -1;
+}
+
+int harnessStart(int argc, char **argv, const char *ofonoOptions)
+{
+    int on = 1;
+    HarnessRequest *req;
+
+    if (harnessBusStart() || harnessOfonoStart(ofonoOptions) || !harnessRilInit(argc, argv))
+        return -1;
+
+    // the modem is attached, the framework powers the radio up from here
+    if (harnessWaitRadio(RADIO_STATE_OFF, START_TIMEOUT)) {
+        LOGE("the modem wasn't attached");
+        return -1;
+    }
+    req = harnessCall(RIL_REQUEST_RADIO_POWER, &on, sizeof(on), START_TIMEOUT);
+    if (!req || RIL_E_SUCCESS != req->error) {
+        LOGE("RADIO_POWER failed");
+        return -1;
+    }
+    if (harnessWaitRadio(RADIO_STATE_SIM_READY, START_TIMEOUT)) {
+        LOGE("the radio didn't come up");
+        return -1;
+    }
+    if (harnessWaitSynced(START_TIMEOUT)) {
+        LOGE("the interfaces weren't seeded");
+        return -1;
+    }
+    // synced covers the interfaces of a powered modem, NetworkRegistration
+    // only shows up once it's online
+    if (harnessWaitRegistered(START_TIMEOUT)) {
+        LOGE("the modem didn't register");
+        return -1;
+    }
+    return 0;
+}
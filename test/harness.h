@@ -0,0 +1,185 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef __HARNESS_H
+#define __HARNESS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <arpa/inet.h>
+#include <telephony/ril.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Host harness: libofono-ril is loaded with RIL_Init and a RIL_Env that
+ * records every completion and unsolicited response, and talks to
+ * fake-ofono.py on a private dbus-daemon (the library connects to the
+ * system bus, so DBUS_SYSTEM_BUS_ADDRESS points it there).
+ *
+ * Requests are issued from a single thread, like libril does, and
+ * their tokens are HarnessRequest records owned by the harness.
+ */
+
+/* CLOCK_MONOTONIC, us */
+uint64_t harnessNow();
+
+/*** Checks and statistics ***/
+
+extern int harnessFailures;
+
+/* Counts and reports a failed check, the test goes on */
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: FAILED: %s\n", __FILE__, __LINE__, #cond); \
+            harnessFailures++; \
+        } \
+    } while (0)
+
+/* Prints PASSED or FAILED, the exit status of a test */
+int harnessResult();
+
+/* Sorts times in place, min and max are the first and the last then */
+void harnessSortTimes(uint64_t *times, unsigned count);
+
+/* Nearest rank percentile of sorted times, 0 if there are none */
+uint64_t harnessPercentile(const uint64_t *times, unsigned count, double p);
+
+/* harnessSortTimes() and the 50th percentile */
+uint64_t harnessMedian(uint64_t *times, unsigned count);
+
+/*** Private bus and fake ofono ***/
+
+/* Start dbus-daemon --session and export its address, 0 on success */
+int harnessBusStart();
+
+/*
+ * Start fake-ofono.py, returns 0 once it owns org.ofono
+ *
+ * @options  extra command line, see fake-ofono.py --help, may be NULL
+ */
+int harnessOfonoStart(const char *options);
+
+/* Kill the fake ofono with SIGKILL, as in a crash */
+void harnessOfonoKill();
+
+/**
+ * Run one fake-ofono.py command, see its COMMANDS
+ *
+ * @reply   the rest of the reply line, may be NULL
+ * @return  0 on "ok", -1 on "error" or if ofono isn't running
+ */
+int harnessOfono(char *reply, size_t size, const char *fmt, ...)
+    __attribute__ ((format (printf, 3, 4)));
+
+/* Stop the fake ofono and the bus, also done at exit */
+void harnessStop();
+
+/*** The library ***/
+
+typedef struct {
+    size_t      len;            // responselen as passed
+    int         ints[8];        // int responses, see copyResponse()
+    int         nints;
+    char        **strings;      // string responses, entries may be NULL
+    int         nstrings;
+    RIL_Call    *calls;         // GET_CURRENT_CALLS, with number and name
+    int         ncalls;
+} HarnessResponse;
+
+typedef struct {
+    int             request;
+    RIL_Errno       error;
+    uint64_t        issued;     // us
+    uint64_t        completed;  // us, 0 while pending
+    unsigned        completions;// more than one is a bug
+    HarnessResponse response;
+} HarnessRequest;
+
+/* RIL_Init with the recording RIL_Env, argv[0] is skipped like in libril */
+const RIL_RadioFunctions *harnessRilInit(int argc, char **argv);
+
+/* onRequest with a new token, from the request thread only */
+HarnessRequest *harnessRequest(int request, void *data, size_t datalen);
+
+/* 0 once completed, -1 after timeoutMs */
+int harnessWait(HarnessRequest *req, int timeoutMs);
+
+/* harnessRequest() and harnessWait(), the completed request or NULL */
+HarnessRequest *harnessCall(int request, void *data, size_t datalen, int timeoutMs);
+
+/* Completions for tokens already completed or not issued by the harness */
+unsigned harnessBadCompletions();
+
+unsigned harnessUnsolCount(int unsol);
+
+/* 0 once unsol was sent at least count times in total */
+int harnessWaitUnsol(int unsol, unsigned count, int timeoutMs);
+
+/* Copy of the latest unsol payload, release with harnessResponseClear() */
+void harnessUnsolLast(int unsol, HarnessResponse *out);
+
+void harnessResponseClear(HarnessResponse *response);
+
+/* 0 once onStateRequest() returns state */
+int harnessWaitRadio(RIL_RadioState state, int timeoutMs);
+
+/*
+ * Whole bring-up: bus, fake ofono, RIL_Init, RADIO_POWER on and every
+ * interface seeded. argv is for RIL_Init, ofonoOptions for the fake.
+ */
+int harnessStart(int argc, char **argv, const char *ofonoOptions);
+
+/* 0 once OEM_HOOK_STRINGS "stats" reports the bring-up done */
+int harnessWaitSynced(int timeoutMs);
+
+/* 0 once REGISTRATION_STATE reports registered, home network */
+int harnessWaitRegistered(int timeoutMs);
+
+/* First OEM_HOOK_STRINGS "stats" line starting with prefix, free() it */
+char *harnessStatsLine(const char *prefix);
+
+/*** Host stand-ins, see hoststubs.c ***/
+
+/* libril's name of a request or unsolicited response */
+const char *requestToString(int request);
+
+typedef struct {
+    volatile unsigned inits;    // ifc_init() calls
+    int         up;
+    char        name[16];
+    in_addr_t   addr;
+    in_addr_t   gateway;
+} HostIfcState;
+
+typedef struct {
+    unsigned    inits;
+    volatile int active;
+    int         muted;
+    volatile unsigned changes;  // of active
+} HostAudioState;
+
+extern HostIfcState hostIfc;
+extern HostAudioState hostAudio;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HARNESS_H
@@ -0,0 +1,45 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef _IFC_UTILS_H_
+#define _IFC_UTILS_H_
+
+/*
+ * Host stand-in for libnetutils, see test/hoststubs.c: nothing touches a
+ * real interface, the calls are only recorded.
+ */
+
+#include <arpa/inet.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int ifc_init(void);
+void ifc_close(void);
+
+int ifc_up(const char *name);
+int ifc_down(const char *name);
+
+int ifc_set_addr(const char *name, in_addr_t addr);
+int ifc_set_default_route(const char *ifname, in_addr_t gateway);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _IFC_UTILS_H_
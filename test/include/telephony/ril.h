@@ -0,0 +1,395 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+** Copyright 2006, The Android Open Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef ANDROID_RIL_H
+#define ANDROID_RIL_H 1
+
+/*
+ * Host stand-in for hardware/ril/include/telephony/ril.h (RIL_VERSION 6),
+ * only what libofono-ril uses. Values and layouts are the AOSP ones, the
+ * host build takes the real header with RIL_INCLUDE=.../hardware/ril/include
+ */
+
+#include <stdlib.h>
+#include <sys/time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RIL_VERSION 6
+#define RIL_CARD_MAX_APPS 8
+
+typedef void * RIL_Token;
+
+typedef enum {
+    RIL_E_SUCCESS = 0,
+    RIL_E_RADIO_NOT_AVAILABLE = 1,
+    RIL_E_GENERIC_FAILURE = 2,
+    RIL_E_PASSWORD_INCORRECT = 3,
+    RIL_E_SIM_PIN2 = 4,
+    RIL_E_SIM_PUK2 = 5,
+    RIL_E_REQUEST_NOT_SUPPORTED = 6,
+    RIL_E_CANCELLED = 7,
+    RIL_E_OP_NOT_ALLOWED_DURING_VOICE_CALL = 8,
+    RIL_E_OP_NOT_ALLOWED_BEFORE_REG_TO_NW = 9,
+    RIL_E_SMS_SEND_FAIL_RETRY = 10,
+    RIL_E_SIM_ABSENT = 11,
+    RIL_E_SUBSCRIPTION_NOT_AVAILABLE = 12,
+    RIL_E_MODE_NOT_SUPPORTED = 13,
+    RIL_E_FDN_CHECK_FAILURE = 14,
+    RIL_E_ILLEGAL_SIM_OR_ME = 15
+} RIL_Errno;
+
+typedef enum {
+    RIL_CALL_ACTIVE = 0,
+    RIL_CALL_HOLDING = 1,
+    RIL_CALL_DIALING = 2,
+    RIL_CALL_ALERTING = 3,
+    RIL_CALL_INCOMING = 4,
+    RIL_CALL_WAITING = 5
+} RIL_CallState;
+
+typedef enum {
+    RADIO_STATE_OFF = 0,
+    RADIO_STATE_UNAVAILABLE = 1,
+    RADIO_STATE_SIM_NOT_READY = 2,
+    RADIO_STATE_SIM_LOCKED_OR_ABSENT = 3,
+    RADIO_STATE_SIM_READY = 4,
+    RADIO_STATE_RUIM_NOT_READY = 5,
+    RADIO_STATE_RUIM_READY = 6,
+    RADIO_STATE_RUIM_LOCKED_OR_ABSENT = 7,
+    RADIO_STATE_NV_NOT_READY = 8,
+    RADIO_STATE_NV_READY = 9
+} RIL_RadioState;
+
+typedef enum {
+    RIL_UUS_TYPE1_IMPLICIT = 0,
+    RIL_UUS_TYPE1_REQUIRED = 1,
+    RIL_UUS_TYPE1_NOT_REQUIRED = 2,
+    RIL_UUS_TYPE2_REQUIRED = 3,
+    RIL_UUS_TYPE2_NOT_REQUIRED = 4,
+    RIL_UUS_TYPE3_REQUIRED = 5,
+    RIL_UUS_TYPE3_NOT_REQUIRED = 6
+} RIL_UUS_Type;
+
+typedef enum {
+    RIL_UUS_DCS_USP = 0,
+    RIL_UUS_DCS_OSIHLP = 1,
+    RIL_UUS_DCS_X244 = 2,
+    RIL_UUS_DCS_RMCF = 3,
+    RIL_UUS_DCS_IA5c = 4
+} RIL_UUS_DCS;
+
+typedef struct {
+    RIL_UUS_Type    uusType;
+    RIL_UUS_DCS     uusDcs;
+    int             uusLength;
+    char *          uusData;
+} RIL_UUS_Info;
+
+typedef struct {
+    RIL_CallState   state;
+    int             index;
+    int             toa;
+    char            isMpty;
+    char            isMT;
+    char            als;
+    char            isVoice;
+    char            isVoicePrivacy;
+    char *          number;
+    int             numberPresentation;
+    char *          name;
+    int             namePresentation;
+    RIL_UUS_Info *  uusInfo;
+} RIL_Call;
+
+typedef struct {
+    char *          address;
+    int             clir;
+    RIL_UUS_Info *  uusInfo;
+} RIL_Dial;
+
+typedef struct {
+    int command;
+    int fileid;
+    char *path;
+    int p1;
+    int p2;
+    int p3;
+    char *data;
+    char *pin2;
+} RIL_SIM_IO;
+
+typedef struct {
+    int sw1;
+    int sw2;
+    char *simResponse;
+} RIL_SIM_IO_Response;
+
+typedef struct {
+    int messageRef;
+    char *ackPDU;
+    int errorCode;
+} RIL_SMS_Response;
+
+typedef struct {
+    int status;
+    char * pdu;
+    char * smsc;
+} RIL_SMS_WriteArgs;
+
+typedef struct {
+    int signalStrength;
+    int bitErrorRate;
+} RIL_GW_SignalStrength;
+
+typedef struct {
+    int dbm;
+    int ecio;
+} RIL_CDMA_SignalStrength;
+
+typedef struct {
+    int dbm;
+    int ecio;
+    int signalNoiseRatio;
+} RIL_EVDO_SignalStrength;
+
+typedef struct {
+    RIL_GW_SignalStrength   GW_SignalStrength;
+    RIL_CDMA_SignalStrength CDMA_SignalStrength;
+    RIL_EVDO_SignalStrength EVDO_SignalStrength;
+} RIL_SignalStrength;
+
+typedef enum {
+    RIL_CARDSTATE_ABSENT = 0,
+    RIL_CARDSTATE_PRESENT = 1,
+    RIL_CARDSTATE_ERROR = 2
+} RIL_CardState;
+
+typedef enum {
+    RIL_PERSOSUBSTATE_UNKNOWN = 0,
+    RIL_PERSOSUBSTATE_IN_PROGRESS = 1,
+    RIL_PERSOSUBSTATE_READY = 2,
+    RIL_PERSOSUBSTATE_SIM_NETWORK = 3,
+    RIL_PERSOSUBSTATE_SIM_NETWORK_SUBSET = 4,
+    RIL_PERSOSUBSTATE_SIM_CORPORATE = 5,
+    RIL_PERSOSUBSTATE_SIM_SERVICE_PROVIDER = 6,
+    RIL_PERSOSUBSTATE_SIM_SIM = 7,
+    RIL_PERSOSUBSTATE_SIM_NETWORK_PUK = 8,
+    RIL_PERSOSUBSTATE_SIM_NETWORK_SUBSET_PUK = 9,
+    RIL_PERSOSUBSTATE_SIM_CORPORATE_PUK = 10,
+    RIL_PERSOSUBSTATE_SIM_SERVICE_PROVIDER_PUK = 11,
+    RIL_PERSOSUBSTATE_SIM_SIM_PUK = 12,
+    RIL_PERSOSUBSTATE_RUIM_NETWORK1 = 13,
+    RIL_PERSOSUBSTATE_RUIM_NETWORK2 = 14,
+    RIL_PERSOSUBSTATE_RUIM_HRPD = 15,
+    RIL_PERSOSUBSTATE_RUIM_CORPORATE = 16,
+    RIL_PERSOSUBSTATE_RUIM_SERVICE_PROVIDER = 17,
+    RIL_PERSOSUBSTATE_RUIM_RUIM = 18,
+    RIL_PERSOSUBSTATE_RUIM_NETWORK1_PUK = 19,
+    RIL_PERSOSUBSTATE_RUIM_NETWORK2_PUK = 20,
+    RIL_PERSOSUBSTATE_RUIM_HRPD_PUK = 21,
+    RIL_PERSOSUBSTATE_RUIM_CORPORATE_PUK = 22,
+    RIL_PERSOSUBSTATE_RUIM_SERVICE_PROVIDER_PUK = 23,
+    RIL_PERSOSUBSTATE_RUIM_RUIM_PUK = 24
+} RIL_PersoSubstate;
+
+typedef enum {
+    RIL_APPSTATE_UNKNOWN = 0,
+    RIL_APPSTATE_DETECTED = 1,
+    RIL_APPSTATE_PIN = 2,
+    RIL_APPSTATE_PUK = 3,
+    RIL_APPSTATE_SUBSCRIPTION_PERSO = 4,
+    RIL_APPSTATE_READY = 5
+} RIL_AppState;
+
+typedef enum {
+    RIL_PINSTATE_UNKNOWN = 0,
+    RIL_PINSTATE_ENABLED_NOT_VERIFIED = 1,
+    RIL_PINSTATE_ENABLED_VERIFIED = 2,
+    RIL_PINSTATE_DISABLED = 3,
+    RIL_PINSTATE_ENABLED_BLOCKED = 4,
+    RIL_PINSTATE_ENABLED_PERM_BLOCKED = 5
+} RIL_PinState;
+
+typedef enum {
+    RIL_APPTYPE_UNKNOWN = 0,
+    RIL_APPTYPE_SIM = 1,
+    RIL_APPTYPE_USIM = 2,
+    RIL_APPTYPE_RUIM = 3,
+    RIL_APPTYPE_CSIM = 4
+} RIL_AppType;
+
+typedef struct {
+    RIL_AppType      app_type;
+    RIL_AppState     app_state;
+    RIL_PersoSubstate perso_substate;
+    char             *aid_ptr;
+    char             *app_label_ptr;
+    int              pin1_replaced;
+    RIL_PinState     pin1;
+    RIL_PinState     pin2;
+} RIL_AppStatus;
+
+typedef struct {
+    RIL_CardState card_state;
+    RIL_PinState  universal_pin_state;
+    int           gsm_umts_subscription_app_index;
+    int           cdma_subscription_app_index;
+    int           num_applications;
+    RIL_AppStatus applications[RIL_CARD_MAX_APPS];
+} RIL_CardStatus;
+
+#define RIL_REQUEST_GET_SIM_STATUS 1
+#define RIL_REQUEST_ENTER_SIM_PIN 2
+#define RIL_REQUEST_ENTER_SIM_PUK 3
+#define RIL_REQUEST_ENTER_SIM_PIN2 4
+#define RIL_REQUEST_ENTER_SIM_PUK2 5
+#define RIL_REQUEST_CHANGE_SIM_PIN 6
+#define RIL_REQUEST_CHANGE_SIM_PIN2 7
+#define RIL_REQUEST_ENTER_NETWORK_DEPERSONALIZATION 8
+#define RIL_REQUEST_GET_CURRENT_CALLS 9
+#define RIL_REQUEST_DIAL 10
+#define RIL_REQUEST_GET_IMSI 11
+#define RIL_REQUEST_HANGUP 12
+#define RIL_REQUEST_HANGUP_WAITING_OR_BACKGROUND 13
+#define RIL_REQUEST_HANGUP_FOREGROUND_RESUME_BACKGROUND 14
+#define RIL_REQUEST_SWITCH_WAITING_OR_HOLDING_AND_ACTIVE 15
+#define RIL_REQUEST_CONFERENCE 16
+#define RIL_REQUEST_UDUB 17
+#define RIL_REQUEST_LAST_CALL_FAIL_CAUSE 18
+#define RIL_REQUEST_SIGNAL_STRENGTH 19
+#define RIL_REQUEST_REGISTRATION_STATE 20
+#define RIL_REQUEST_GPRS_REGISTRATION_STATE 21
+#define RIL_REQUEST_OPERATOR 22
+#define RIL_REQUEST_RADIO_POWER 23
+#define RIL_REQUEST_DTMF 24
+#define RIL_REQUEST_SEND_SMS 25
+#define RIL_REQUEST_SEND_SMS_EXPECT_MORE 26
+#define RIL_REQUEST_SETUP_DATA_CALL 27
+#define RIL_REQUEST_SIM_IO 28
+#define RIL_REQUEST_SEND_USSD 29
+#define RIL_REQUEST_CANCEL_USSD 30
+#define RIL_REQUEST_GET_CLIR 31
+#define RIL_REQUEST_SET_CLIR 32
+#define RIL_REQUEST_QUERY_CALL_FORWARD_STATUS 33
+#define RIL_REQUEST_SET_CALL_FORWARD 34
+#define RIL_REQUEST_QUERY_CALL_WAITING 35
+#define RIL_REQUEST_SET_CALL_WAITING 36
+#define RIL_REQUEST_SMS_ACKNOWLEDGE 37
+#define RIL_REQUEST_GET_IMEI 38
+#define RIL_REQUEST_GET_IMEISV 39
+#define RIL_REQUEST_ANSWER 40
+#define RIL_REQUEST_DEACTIVATE_DATA_CALL 41
+#define RIL_REQUEST_QUERY_FACILITY_LOCK 42
+#define RIL_REQUEST_SET_FACILITY_LOCK 43
+#define RIL_REQUEST_CHANGE_BARRING_PASSWORD 44
+#define RIL_REQUEST_QUERY_NETWORK_SELECTION_MODE 45
+#define RIL_REQUEST_SET_NETWORK_SELECTION_AUTOMATIC 46
+#define RIL_REQUEST_SET_NETWORK_SELECTION_MANUAL 47
+#define RIL_REQUEST_QUERY_AVAILABLE_NETWORKS 48
+#define RIL_REQUEST_DTMF_START 49
+#define RIL_REQUEST_DTMF_STOP 50
+#define RIL_REQUEST_BASEBAND_VERSION 51
+#define RIL_REQUEST_SEPARATE_CONNECTION 52
+#define RIL_REQUEST_SET_MUTE 53
+#define RIL_REQUEST_GET_MUTE 54
+#define RIL_REQUEST_QUERY_CLIP 55
+#define RIL_REQUEST_LAST_DATA_CALL_FAIL_CAUSE 56
+#define RIL_REQUEST_DATA_CALL_LIST 57
+#define RIL_REQUEST_RESET_RADIO 58
+#define RIL_REQUEST_OEM_HOOK_RAW 59
+#define RIL_REQUEST_OEM_HOOK_STRINGS 60
+#define RIL_REQUEST_SCREEN_STATE 61
+#define RIL_REQUEST_SET_SUPP_SVC_NOTIFICATION 62
+#define RIL_REQUEST_WRITE_SMS_TO_SIM 63
+#define RIL_REQUEST_DELETE_SMS_ON_SIM 64
+#define RIL_REQUEST_SET_BAND_MODE 65
+#define RIL_REQUEST_QUERY_AVAILABLE_BAND_MODE 66
+#define RIL_REQUEST_STK_GET_PROFILE 67
+#define RIL_REQUEST_STK_SET_PROFILE 68
+#define RIL_REQUEST_STK_SEND_ENVELOPE_COMMAND 69
+#define RIL_REQUEST_STK_SEND_TERMINAL_RESPONSE 70
+#define RIL_REQUEST_STK_HANDLE_CALL_SETUP_REQUESTED_FROM_SIM 71
+#define RIL_REQUEST_EXPLICIT_CALL_TRANSFER 72
+#define RIL_REQUEST_SET_PREFERRED_NETWORK_TYPE 73
+#define RIL_REQUEST_GET_PREFERRED_NETWORK_TYPE 74
+#define RIL_REQUEST_GET_NEIGHBORING_CELL_IDS 75
+#define RIL_REQUEST_SET_LOCATION_UPDATES 76
+#define RIL_REQUEST_CDMA_SET_SUBSCRIPTION 77
+#define RIL_REQUEST_CDMA_SET_ROAMING_PREFERENCE 78
+#define RIL_REQUEST_CDMA_QUERY_ROAMING_PREFERENCE 79
+
+#define RIL_UNSOL_RESPONSE_BASE 1000
+#define RIL_UNSOL_RESPONSE_RADIO_STATE_CHANGED 1000
+#define RIL_UNSOL_RESPONSE_CALL_STATE_CHANGED 1001
+#define RIL_UNSOL_RESPONSE_NETWORK_STATE_CHANGED 1002
+#define RIL_UNSOL_RESPONSE_NEW_SMS 1003
+#define RIL_UNSOL_RESPONSE_NEW_SMS_STATUS_REPORT 1004
+#define RIL_UNSOL_RESPONSE_NEW_SMS_ON_SIM 1005
+#define RIL_UNSOL_ON_USSD 1006
+#define RIL_UNSOL_ON_USSD_REQUEST 1007
+#define RIL_UNSOL_NITZ_TIME_RECEIVED 1008
+#define RIL_UNSOL_SIGNAL_STRENGTH 1009
+#define RIL_UNSOL_DATA_CALL_LIST_CHANGED 1010
+#define RIL_UNSOL_SUPP_SVC_NOTIFICATION 1011
+#define RIL_UNSOL_STK_SESSION_END 1012
+#define RIL_UNSOL_STK_PROACTIVE_COMMAND 1013
+#define RIL_UNSOL_STK_EVENT_NOTIFY 1014
+#define RIL_UNSOL_STK_CALL_SETUP 1015
+#define RIL_UNSOL_SIM_SMS_STORAGE_FULL 1016
+#define RIL_UNSOL_SIM_REFRESH 1017
+#define RIL_UNSOL_CALL_RING 1018
+#define RIL_UNSOL_RESPONSE_SIM_STATUS_CHANGED 1019
+
+typedef void (*RIL_RequestFunc) (int request, void *data,
+                                 size_t datalen, RIL_Token t);
+typedef RIL_RadioState (*RIL_RadioStateRequest)();
+typedef int (*RIL_Supports)(int requestCode);
+typedef void (*RIL_Cancel)(RIL_Token t);
+typedef void (*RIL_TimedCallback) (void *param);
+typedef const char * (*RIL_GetVersion) (void);
+
+typedef struct {
+    int version;
+    RIL_RequestFunc onRequest;
+    RIL_RadioStateRequest onStateRequest;
+    RIL_Supports supports;
+    RIL_Cancel onCancel;
+    RIL_GetVersion getVersion;
+} RIL_RadioFunctions;
+
+struct RIL_Env {
+    void (*OnRequestComplete)(RIL_Token t, RIL_Errno e,
+                              void *response, size_t responselen);
+    void (*OnUnsolicitedResponse)(int unsolResponse, const void *data,
+                                  size_t datalen);
+    void (*RequestTimedCallback) (RIL_TimedCallback callback,
+                                  void *param, const struct timeval *relativeTime);
+};
+
+#ifdef RIL_SHLIB
+const RIL_RadioFunctions *RIL_Init(const struct RIL_Env *env, int argc, char **argv);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ANDROID_RIL_H */
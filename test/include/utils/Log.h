@@ -0,0 +1,60 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef _LIBS_UTILS_LOG_H
+#define _LIBS_UTILS_LOG_H
+
+/*
+ * Host stand-in for the Android log macros, writes to stderr. The level
+ * is read from RIL_HOST_LOG (V, D, I, W or E, W by default), the
+ * arguments of a disabled message aren't evaluated.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef LOG_TAG
+#define LOG_TAG NULL
+#endif
+
+typedef enum {
+    HOST_LOG_VERBOSE = 2,
+    HOST_LOG_DEBUG,
+    HOST_LOG_INFO,
+    HOST_LOG_WARN,
+    HOST_LOG_ERROR,
+} HostLogPriority;
+
+int hostLogEnabled(int prio);
+void hostLog(int prio, const char *tag, const char *fmt, ...)
+    __attribute__ ((format (printf, 3, 4)));
+
+#define HOST_LOG(prio, ...) \
+    ((void) (hostLogEnabled(prio) ? hostLog(prio, LOG_TAG, __VA_ARGS__), 0 : 0))
+
+#define LOGV(...) HOST_LOG(HOST_LOG_VERBOSE, __VA_ARGS__)
+#define LOGD(...) HOST_LOG(HOST_LOG_DEBUG, __VA_ARGS__)
+#define LOGI(...) HOST_LOG(HOST_LOG_INFO, __VA_ARGS__)
+#define LOGW(...) HOST_LOG(HOST_LOG_WARN, __VA_ARGS__)
+#define LOGE(...) HOST_LOG(HOST_LOG_ERROR, __VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _LIBS_UTILS_LOG_H
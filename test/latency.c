@@ -0,0 +1,285 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/*
+ * Request latency, onRequest to RIL_onRequestComplete, for a mix of the
+ * requests the framework polls with after every state change. Requests
+ * are issued in batches of -p back to back, like a poll storm, and the
+ * p50/p99/p99.9 per request type are written as JSON.
+ *
+ *   latency [-n requests] [-w warmup] [-p depth] [-s seed] [-m mix]
+ *           [-O "fake-ofono command"]... [-l label] [-o out.json]
+ *
+ * mix is TYPE:WEIGHT,... with the types below, e.g. -m DIAL:1,OPERATOR:3.
+ * -O runs a fake-ofono.py command before the run, e.g. to delay replies:
+ * -O "delay VoiceCallManager.Dial 20".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+
+#include "harness.h"
+
+#define TIMEOUT     5000    // ms per request
+#define MAX_DEPTH   64
+#define MAX_OFONO   16
+#define HANGUP_MS   50      // dialed calls are gone after this
+
+typedef struct {
+    const char  *name;
+    int         request;
+    int         weight;     // default mix
+    uint64_t    *samples;   // us
+    unsigned    count;
+    unsigned    errors;
+    unsigned    timeouts;
+} RequestType;
+
+static RequestType types[] = {
+    { "GET_CURRENT_CALLS",  RIL_REQUEST_GET_CURRENT_CALLS,  30 },
+    { "SIGNAL_STRENGTH",    RIL_REQUEST_SIGNAL_STRENGTH,    20 },
+    { "REGISTRATION_STATE", RIL_REQUEST_REGISTRATION_STATE, 20 },
+    { "OPERATOR",           RIL_REQUEST_OPERATOR,           20 },
+    { "DIAL",               RIL_REQUEST_DIAL,               4 },
+    { "SEND_USSD",          RIL_REQUEST_SEND_USSD,          3 },
+    { "SETUP_DATA_CALL",    RIL_REQUEST_SETUP_DATA_CALL,    3 },
+};
+
+#define TYPE_COUNT (sizeof(types) / sizeof(types[0]))
+
+static RIL_Dial dial = { "+358409876543", 0, NULL };
+static char ussd[] = "*100#";
+static char *setup[7] = { "1", "0", "internet", "", "", "0", "IP" };
+
+static HarnessRequest *issue(RequestType *type)
+{
+    switch (type->request) {
+        case RIL_REQUEST_DIAL:
+            return harnessRequest(type->request, &dial, sizeof(dial));
+        case RIL_REQUEST_SEND_USSD:
+            return harnessRequest(type->request, ussd, sizeof(ussd));
+        case RIL_REQUEST_SETUP_DATA_CALL:
+            return harnessRequest(type->request, setup, sizeof(setup));
+        default:
+            return harnessRequest(type->request, NULL, 0);
+    }
+}
+
+static int parseMix(char *mix)
+{
+    char *item, *save = NULL;
+    unsigned i;
+
+    for (i = 0; i < TYPE_COUNT; i++)
+        types[i].weight = 0;
+
+    for (item = strtok_r(mix, ",", &save); item; item = strtok_r(NULL, ",", &save)) {
+        char *colon = strchr(item, ':');
+
+        if (colon)
+            *colon = 0;
+        for (i = 0; i < TYPE_COUNT; i++)
+            if (!strcmp(types[i].name, item))
+                break;
+        if (i == TYPE_COUNT) {
+            fprintf(stderr, "unknown request type %s\n", item);
+            return -1;
+        }
+        types[i].weight = colon ? atoi(colon + 1) : 1;
+    }
+    return 0;
+}
+
+static RequestType *pick(unsigned *seed, int totalWeight)
+{
+    int r = rand_r(seed) % totalWeight;
+    unsigned i;
+
+    for (i = 0; i < TYPE_COUNT - 1; i++) {
+        if (r < types[i].weight)
+            break;
+        r -= types[i].weight;
+    }
+    return &types[i];
+}
+
+static void writeJson(FILE *out, const char *label, int requests, int depth, unsigned seed)
+{
+    unsigned i, printed = 0;
+
+    fprintf(out, "{\n  \"benchmark\": \"latency\",\n");
+    fprintf(out, "  \"label\": \"%s\",\n", label);
+    fprintf(out, "  \"requests\": %d,\n  \"depth\": %d,\n  \"seed\": %u,\n", requests, depth, seed);
+    fprintf(out, "  \"unit\": \"us\",\n  \"types\": {");
+    for (i = 0; i < TYPE_COUNT; i++) {
+        RequestType *type = &types[i];
+
+        if (!type->weight)
+            continue;
+        harnessSortTimes(type->samples, type->count);
+        fprintf(out, "%s\n    \"%s\": { \"count\": %u, \"errors\": %u, \"timeouts\": %u, "
+                "\"p50\": %llu, \"p99\": %llu, \"p99.9\": %llu, \"max\": %llu }",
+                printed++ ? "," : "", type->name, type->count, type->errors, type->timeouts,
+                (unsigned long long) harnessPercentile(type->samples, type->count, 50),
+                (unsigned long long) harnessPercentile(type->samples, type->count, 99),
+                (unsigned long long) harnessPercentile(type->samples, type->count, 99.9),
+                (unsigned long long) (type->count ? type->samples[type->count - 1] : 0));
+    }
+    fprintf(out, "\n  }\n}\n");
+}
+
+/*
+ * Context back to inactive for the next SETUP_DATA_CALL. The library
+ * sends Active=false from the main loop, it could reach ofono after the
+ * next setup's Active=true, so wait until ofono has it.
+ */
+static void deactivate()
+{
+    char *cid[1] = { "1" };
+    char active[16];
+    int i;
+
+    harnessCall(RIL_REQUEST_DEACTIVATE_DATA_CALL, cid, sizeof(cid), TIMEOUT);
+    for (i = 0; i < TIMEOUT; i++) {
+        if (harnessOfono(active, sizeof(active), "get /isimodem/context1 ConnectionContext Active") ||
+            !strcmp(active, "0"))
+            return;
+        usleep(1000);
+    }
+}
+
+static void run(int requests, int depth, unsigned seed, int record)
+{
+    HarnessRequest *batch[MAX_DEPTH];
+    RequestType *batchType[MAX_DEPTH];
+    int totalWeight = 0, done = 0;
+    unsigned i;
+
+    for (i = 0; i < TYPE_COUNT; i++)
+        totalWeight += types[i].weight;
+
+    while (done < requests) {
+        int n = 0, data = 0, j;
+
+        // the library handles one data call at a time, it ends a batch
+        while (n < depth && done < requests && !data) {
+            batchType[n] = pick(&seed, totalWeight);
+            data = RIL_REQUEST_SETUP_DATA_CALL == batchType[n]->request;
+            batch[n] = issue(batchType[n]);
+            n++;
+            done++;
+        }
+
+        for (j = 0; j < n; j++) {
+            RequestType *type = batchType[j];
+
+            if (harnessWait(batch[j], TIMEOUT)) {
+                type->timeouts += record;
+                continue;
+            }
+            if (!record)
+                continue;
+            if (RIL_E_SUCCESS != batch[j]->error)
+                type->errors++;
+            type->samples[type->count++] = batch[j]->completed - batch[j]->issued;
+        }
+
+        if (data)
+            deactivate();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *ofonoCommands[MAX_OFONO];
+    const char *label = "", *outPath = NULL;
+    int requests = 10000, warmup = 200, depth = 4, nofono = 0;
+    unsigned seed = 1, i;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:w:p:s:m:O:l:o:")) != -1) {
+        switch (opt) {
+            case 'n': requests = atoi(optarg); break;
+            case 'w': warmup = atoi(optarg); break;
+            case 'p': depth = atoi(optarg); break;
+            case 's': seed = strtoul(optarg, NULL, 0); break;
+            case 'm':
+                if (parseMix(optarg))
+                    return 2;
+                break;
+            case 'O':
+                if (nofono < MAX_OFONO)
+                    ofonoCommands[nofono++] = optarg;
+                break;
+            case 'l': label = optarg; break;
+            case 'o': outPath = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-n requests] [-w warmup] [-p depth] [-s seed] "
+                        "[-m TYPE:WEIGHT,...] [-O command]... [-l label] [-o out.json]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (requests <= 0 || depth <= 0 || depth > MAX_DEPTH) {
+        fprintf(stderr, "requests must be > 0 and depth 1-%d\n", MAX_DEPTH);
+        return 2;
+    }
+
+    int totalWeight = 0;
+    for (i = 0; i < TYPE_COUNT; i++) {
+        totalWeight += types[i].weight;
+        types[i].samples = calloc(requests, sizeof(uint64_t));
+    }
+    if (totalWeight <= 0) {
+        fprintf(stderr, "empty mix\n");
+        return 2;
+    }
+
+    if (harnessStart(0, NULL, NULL)) {
+        fprintf(stderr, "bring-up failed\n");
+        return 1;
+    }
+    // dialed calls would pile up past MAX_CALLS otherwise
+    harnessOfono(NULL, 0, "auto-hangup %d", HANGUP_MS);
+    for (i = 0; i < (unsigned) nofono; i++) {
+        if (harnessOfono(NULL, 0, "%s", ofonoCommands[i])) {
+            fprintf(stderr, "fake ofono refused: %s\n", ofonoCommands[i]);
+            return 1;
+        }
+    }
+
+    if (warmup > 0)
+        run(warmup, depth, seed + 1, 0);
+    run(requests, depth, seed, 1);
+
+    FILE *out = outPath ? fopen(outPath, "w") : stdout;
+    if (!out) {
+        perror(outPath);
+        return 1;
+    }
+    writeJson(out, label, requests, depth, seed);
+    if (out != stdout)
+        fclose(out);
+
+    if (harnessBadCompletions()) {
+        fprintf(stderr, "%u bad completions\n", harnessBadCompletions());
+        return 1;
+    }
+    return 0;
+}
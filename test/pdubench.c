@@ -0,0 +1,345 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/*
+ * SMS-DELIVER series of 1 to 10 parts: encodeDeliverPDUs() against the
+ * one before the bulk hex writer, kept below, which wrote every octet
+ * through the branching setOctet() and gave each part the largest PDU.
+ *
+ *   pdubench [-n messages] [-l label] [-o out.json]
+ *
+ * Texts are GSM 7-bit and UCS2 of exactly 1..10 full parts. Both
+ * encoders have to give the same PDUs. hex is setOctets() alone on 140
+ * octets of user data, against the old per-octet loop; which kernel it
+ * is (NEON, SSE2 or scalar) is in the output.
+ */
+
+// the encoder is static
+#include "../src/pdu.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include <time.h>
+
+#define MAX_PARTS   10
+
+/*** The encoder before the bulk hex writer ***/
+
+static inline void oldSetOctet(unsigned char *pdu, int *offset, guint8 oct)
+{
+    setSemiOctet(pdu, offset, makeSemiOctet((oct & 0xf0) >> 4));
+    setSemiOctet(pdu, offset, makeSemiOctet(oct & 0x0f));
+}
+
+static int oldEncodeDeliverPDUs(const char *message, const char *smsc, const char *sender,
+                                gboolean ref16, char ***pdus, size_t *allocated)
+{
+    guint8 *text = g_malloc(2 * strlen(message) + 1);
+    int length = utf8ToGsm(message, text);
+    gboolean ucs2 = length < 0;
+    if (ucs2)
+        length = utf8ToUcs2(message, text);
+
+    int udhSize = ref16 ? UDH_CONCAT16_SIZE : UDH_CONCAT8_SIZE;
+    int udhSeptets = (udhSize * 8 + 6) / 7;
+    int maxSingle = ucs2 ? SMS_MAX_UD : SMS_MAX_SEPTETS;
+    // UCS2 parts hold whole UTF-16 code units, 133 octets after a 16-bit reference don't
+    int maxPart = ucs2 ? (SMS_MAX_UD - udhSize) & ~1 : SMS_MAX_SEPTETS - udhSeptets;
+
+    int parts = 1;
+    if (length > maxSingle) {
+        int ofs;
+        for (parts = 0, ofs = 0; ofs < length; parts++)
+            ofs += partLength(&text[ofs], length - ofs, maxPart, ucs2);
+    }
+
+    size_t maxPdu = 2 + 2 + strlen(smsc) + 1 + 2 + 2 + 2 + strlen(sender) + 1
+                    + 2 + 2 + 14 + 2 + 2 * SMS_MAX_UD + 1;
+    *allocated = (parts + 1) * sizeof(char *) + parts * maxPdu;
+    char **result = g_malloc(*allocated);
+    unsigned char *pdu = (unsigned char *) &result[parts + 1];
+    guint8 udh[UDH_CONCAT16_SIZE];
+    guint8 packed[SMS_MAX_UD];
+    guint16 ref = concatRef++;
+    int textOfs = 0;
+    int i;
+
+    for (i = 0; i < parts; i++, pdu += maxPdu) {
+        gboolean concat = parts > 1;
+        int len = partLength(&text[textOfs], length - textOfs, concat ? maxPart : maxSingle, ucs2);
+        int ofs = encodeDeliverHeader(pdu, smsc, sender, concat ? 0x44 : 0x04, ucs2 ? 0x08 : 0x00);
+
+        int udhLen = 0;
+        if (concat) {
+            udh[udhLen++] = udhSize - 1;    // UDHL
+            if (ref16) {
+                udh[udhLen++] = 0x08;
+                udh[udhLen++] = 4;
+                udh[udhLen++] = ref >> 8;
+            } else {
+                udh[udhLen++] = 0x00;
+                udh[udhLen++] = 3;
+            }
+            udh[udhLen++] = ref & 0xff;
+            udh[udhLen++] = parts;
+            udh[udhLen++] = i + 1;
+        }
+
+        const guint8 *ud = &text[textOfs];
+        int udOctets = len;
+        if (ucs2) {
+            oldSetOctet(pdu, &ofs, udhLen + len); // TP-User-Data-Length, octets
+        } else {
+            int fillBits = udhLen ? udhSeptets * 7 - udhLen * 8 : 0;
+            oldSetOctet(pdu, &ofs, (udhLen ? udhSeptets : 0) + len); // TP-UDL, septets
+            udOctets = packSeptets(ud, len, fillBits, packed);
+            ud = packed;
+        }
+
+        int j;
+        for (j = 0; j < udhLen; j++)
+            oldSetOctet(pdu, &ofs, udh[j]);
+        for (j = 0; j < udOctets; j++)
+            oldSetOctet(pdu, &ofs, ud[j]);
+        pdu[ofs] = 0;
+
+        result[i] = (char *) pdu;
+        textOfs += len;
+    }
+    result[parts] = NULL;
+
+    g_free(text);
+    *pdus = result;
+    return parts;
+}
+
+/*** Texts ***/
+
+#define SMSC    "+79168999100"
+#define SENDER  "+358401234567"
+
+/* Characters of a text that fills exactly parts PDUs, 8-bit reference */
+static int fullLength(int parts, gboolean ucs2)
+{
+    if (1 == parts)
+        return ucs2 ? SMS_MAX_UD / 2 : SMS_MAX_SEPTETS;
+    return parts * (ucs2 ? (SMS_MAX_UD - UDH_CONCAT8_SIZE) / 2
+                         : SMS_MAX_SEPTETS - (UDH_CONCAT8_SIZE * 8 + 6) / 7);
+}
+
+static char *makeText(int parts, gboolean ucs2)
+{
+    static const char latin[] = "The quick brown fox jumps over the lazy dog. ";
+    static const char *cyrillic[] = { "С", "ъ", "е", "ш", "ь", " " };
+    int length = fullLength(parts, ucs2), i;
+    GString *str = g_string_new(NULL);
+
+    for (i = 0; i < length; i++) {
+        if (ucs2)
+            g_string_append(str, cyrillic[i % G_N_ELEMENTS(cyrillic)]);
+        else
+            g_string_append_c(str, latin[i % (sizeof(latin) - 1)]);
+    }
+    return g_string_free(str, FALSE);
+}
+
+/*** Timing ***/
+
+static uint64_t nowNs()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static volatile int sink;
+
+/* Same PDUs from both, and the bytes each allocated */
+static int check(const char *text, int parts, size_t *oldSize, size_t *newSize)
+{
+    char **a, **b;
+    int i;
+
+    concatRef = 0;
+    int na = oldEncodeDeliverPDUs(text, SMSC, SENDER, FALSE, &a, oldSize);
+    concatRef = 0;
+    int nb = encodeDeliverPDUs(text, SMSC, SENDER, FALSE, &b);
+
+    int ok = na == parts && nb == parts;
+    for (i = 0; ok && i < parts; i++)
+        ok = !strcmp(a[i], b[i]);
+    if (!ok) {
+        fprintf(stderr, "encoders disagree on %d parts\n", parts);
+        return -1;
+    }
+
+    // the PDUs and their pointers, what encodeDeliverPDUs() allocates
+    *newSize = (parts + 1) * sizeof(char *);
+    for (i = 0; i < parts; i++)
+        *newSize += strlen(b[i]) + 1;
+    g_free(a);
+    g_free(b);
+    return 0;
+}
+
+/* ns per message, best of three */
+static void measure(const char *text, unsigned long messages, double *oldNs, double *newNs)
+{
+    int round;
+
+    *oldNs = *newNs = 0;
+    for (round = 0; round < 3; round++) {
+        unsigned long i;
+        size_t size;
+        char **pdus;
+        int acc = 0;
+
+        uint64_t start = nowNs();
+        for (i = 0; i < messages; i++) {
+            acc += oldEncodeDeliverPDUs(text, SMSC, SENDER, FALSE, &pdus, &size);
+            g_free(pdus);
+        }
+        double ns = (double) (nowNs() - start) / messages;
+        if (!round || ns < *oldNs)
+            *oldNs = ns;
+
+        start = nowNs();
+        for (i = 0; i < messages; i++) {
+            acc += encodeDeliverPDUs(text, SMSC, SENDER, FALSE, &pdus);
+            g_free(pdus);
+        }
+        ns = (double) (nowNs() - start) / messages;
+        if (!round || ns < *newNs)
+            *newNs = ns;
+        sink = acc;
+    }
+}
+
+/* setOctets() against the per-octet loop on one part's user data, ns */
+static void measureHex(unsigned long rounds, double *oldNs, double *newNs)
+{
+    guint8 ud[SMS_MAX_UD];
+    unsigned char a[2 * SMS_MAX_UD + 1], b[2 * SMS_MAX_UD + 1];
+    unsigned long i;
+    int ofs, j, round;
+
+    for (j = 0; j < SMS_MAX_UD; j++)
+        ud[j] = j * 37 + 11;
+
+    *oldNs = *newNs = 0;
+    for (round = 0; round < 3; round++) {
+        uint64_t start = nowNs();
+        for (i = 0; i < rounds; i++) {
+            ofs = 0;
+            for (j = 0; j < SMS_MAX_UD; j++)
+                oldSetOctet(a, &ofs, ud[j]);
+            sink = a[ofs - 1];
+            ud[i % SMS_MAX_UD]++;
+        }
+        double ns = (double) (nowNs() - start) / rounds;
+        if (!round || ns < *oldNs)
+            *oldNs = ns;
+
+        start = nowNs();
+        for (i = 0; i < rounds; i++) {
+            ofs = 0;
+            setOctets(b, &ofs, ud, SMS_MAX_UD);
+            sink = b[ofs - 1];
+            ud[i % SMS_MAX_UD]++;
+        }
+        ns = (double) (nowNs() - start) / rounds;
+        if (!round || ns < *newNs)
+            *newNs = ns;
+    }
+
+    // and the same digits
+    ofs = 0;
+    for (j = 0; j < SMS_MAX_UD; j++)
+        oldSetOctet(a, &ofs, ud[j]);
+    ofs = 0;
+    setOctets(b, &ofs, ud, SMS_MAX_UD);
+    if (memcmp(a, b, 2 * SMS_MAX_UD)) {
+        fprintf(stderr, "setOctets differs from setOctet\n");
+        exit(1);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long messages = 5000;
+    const char *label = "", *outPath = NULL;
+    int opt, parts, alphabet;
+
+    while ((opt = getopt(argc, argv, "n:l:o:")) != -1) {
+        switch (opt) {
+            case 'n': messages = strtoul(optarg, NULL, 0); break;
+            case 'l': label = optarg; break;
+            case 'o': outPath = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-n messages] [-l label] [-o out.json]\n", argv[0]);
+                return 2;
+        }
+    }
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+    const char *kernel = "neon";
+#elif defined(__SSE2__)
+    const char *kernel = "sse2";
+#else
+    const char *kernel = "scalar";
+#endif
+
+    FILE *out = outPath ? fopen(outPath, "w") : stdout;
+    if (!out) {
+        perror(outPath);
+        return 1;
+    }
+    fprintf(out, "{\n  \"benchmark\": \"pdubench\",\n  \"label\": \"%s\",\n", label);
+    fprintf(out, "  \"kernel\": \"%s\",\n  \"messages\": %lu,\n  \"unit\": \"ns per message\",\n",
+            kernel, messages);
+
+    double hexOld, hexNew;
+    measureHex(messages * 10, &hexOld, &hexNew);
+    fprintf(out, "  \"hex_140_octets\": { \"setOctet\": %.1f, \"setOctets\": %.1f },\n",
+            hexOld, hexNew);
+
+    for (alphabet = 0; alphabet < 2; alphabet++) {
+        gboolean ucs2 = alphabet;
+
+        fprintf(out, "  \"%s\": [", ucs2 ? "ucs2" : "gsm7");
+        for (parts = 1; parts <= MAX_PARTS; parts++) {
+            char *text = makeText(parts, ucs2);
+            size_t oldSize, newSize;
+            double oldNs, newNs;
+
+            if (check(text, parts, &oldSize, &newSize))
+                return 1;
+            measure(text, messages, &oldNs, &newNs);
+            fprintf(out, "%s\n    { \"parts\": %d, \"old\": %.1f, \"new\": %.1f, "
+                    "\"old_bytes\": %zu, \"new_bytes\": %zu }",
+                    parts > 1 ? "," : "", parts, oldNs, newNs, oldSize, newSize);
+            g_free(text);
+        }
+        fprintf(out, "\n  ]%s\n", ucs2 ? "" : ",");
+    }
+    fprintf(out, "}\n");
+    if (out != stdout)
+        fclose(out);
+    return 0;
+}
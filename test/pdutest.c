@@ -0,0 +1,198 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/*
+ * SMS PDUs without the library: every series encodeDeliverPDUs() makes,
+ * with 8-bit and 16-bit references, is decoded part by part and has to
+ * give the text back, exits non-zero if any check failed.
+ *
+ * UCS2 parts are joined as octets and converted once, so a part that
+ * ends inside a character or a surrogate pair shows up.
+ */
+
+// the coders are static
+#include "../src/pdu.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "harness.h"
+
+#define SMSC    "+79168999100"
+#define SENDER  "+358401234567"
+
+/*** SMS-DELIVER, the way the framework reads it ***/
+
+typedef struct {
+    guint8      dcs;
+    int         udl;            // septets or octets, with the UDH
+    int         udhLen;         // octets, with the UDHL
+    guint8      ud[SMS_MAX_UD];
+    int         udOctets;
+    SmsSubmit   concat;         // concatenation fields of the UDH
+} Deliver;
+
+static int decodeDeliver(const char *hex, Deliver *d)
+{
+    guint8 pdu[256];
+    int len, ofs;
+
+    memset(d, 0, sizeof(*d));
+    if (strlen(hex) / 2 > sizeof(pdu) || (len = hexDecode(hex, pdu)) < 1)
+        return -1;
+
+    ofs = 1 + pdu[0];                       // SMSC
+    if (ofs + 2 > len)
+        return -1;
+    guint8 firstOctet = pdu[ofs++];
+    if (firstOctet & 0x03)                  // TP-MTI, SMS-DELIVER
+        return -1;
+    ofs += 2 + (pdu[ofs] + 1) / 2;          // TP-OA
+    ofs++;                                  // TP-PID
+    if (ofs + 9 > len)
+        return -1;
+    d->dcs = pdu[ofs++];
+    ofs += 7;                               // TP-SCTS
+    d->udl = pdu[ofs++];
+
+    d->udOctets = 0x08 == d->dcs ? d->udl : (d->udl * 7 + 7) / 8;
+    if (d->udOctets != len - ofs || d->udOctets > SMS_MAX_UD)
+        return -1;
+    memcpy(d->ud, &pdu[ofs], d->udOctets);
+
+    if (firstOctet & 0x40) {                // TP-UDHI
+        d->udhLen = 1 + d->ud[0];
+        if (d->udhLen > d->udOctets || !decodeUDH(&d->ud[1], d->udhLen - 1, &d->concat))
+            return -1;
+    }
+    return 0;
+}
+
+/*** Round trips ***/
+
+/* Encodes text, decodes every part and joins them again, parts 0 for any series */
+static void roundTrip(const char *text, gboolean ref16, gboolean ucs2, int parts)
+{
+    char **pdus;
+    int count = encodeDeliverPDUs(text, SMSC, SENDER, ref16, &pdus);
+    GString *joined = g_string_new(NULL);
+    GByteArray *octets = g_byte_array_new();
+    int i;
+
+    CHECK(parts ? count == parts : count > 1);
+    for (i = 0; i < count; i++) {
+        Deliver d;
+
+        if (decodeDeliver(pdus[i], &d)) {
+            fprintf(stderr, "part %d of %d doesn't decode: %s\n", i + 1, count, pdus[i]);
+            harnessFailures++;
+            break;
+        }
+        CHECK(d.dcs == (ucs2 ? 0x08 : 0x00));
+        if (count > 1) {
+            CHECK(d.udhLen == (ref16 ? UDH_CONCAT16_SIZE : UDH_CONCAT8_SIZE));
+            CHECK(d.concat.concatTotal == count);
+            CHECK(d.concat.concatSeq == i + 1);
+        } else {
+            CHECK(!d.udhLen);
+        }
+
+        if (ucs2) {
+            // whole UTF-16 code units in every part
+            CHECK(!((d.udOctets - d.udhLen) & 1));
+            g_byte_array_append(octets, &d.ud[d.udhLen], d.udOctets - d.udhLen);
+        } else {
+            gchar *part = gsmToUtf8(d.ud, d.udl, (d.udhLen * 8 + 6) / 7);
+            g_string_append(joined, part);
+            g_free(part);
+        }
+    }
+
+    if (ucs2) {
+        gchar *all = ucs2ToUtf8(octets->data, octets->len);
+        g_string_append(joined, all);
+        g_free(all);
+    }
+    if (strcmp(joined->str, text)) {
+        fprintf(stderr, "%s reference, %d parts: text differs\n  in:  %s\n  out: %s\n",
+                ref16 ? "16-bit" : "8-bit", count, text, joined->str);
+        harnessFailures++;
+    }
+
+    g_byte_array_free(octets, TRUE);
+    g_string_free(joined, TRUE);
+    g_free(pdus);
+}
+
+static char *repeat(const char *prefix, const char *unit, int count)
+{
+    GString *str = g_string_new(prefix);
+    int i;
+
+    for (i = 0; i < count; i++)
+        g_string_append(str, unit);
+    return g_string_free(str, FALSE);
+}
+
+static void testDeliver(gboolean ref16)
+{
+    int udhSize = ref16 ? UDH_CONCAT16_SIZE : UDH_CONCAT8_SIZE;
+    int gsmPart = SMS_MAX_SEPTETS - (udhSize * 8 + 6) / 7;
+    int ucs2Part = (SMS_MAX_UD - udhSize) / 2;      // characters
+    char *text;
+    int shift;
+
+    roundTrip("Hello", ref16, FALSE, 1);
+    roundTrip("Привет", ref16, TRUE, 1);
+
+    // GSM, exactly full and one septet over, escapes on the boundaries
+    text = repeat("", "a", SMS_MAX_SEPTETS);
+    roundTrip(text, ref16, FALSE, 1);
+    g_free(text);
+    text = repeat("", "a", SMS_MAX_SEPTETS + 1);
+    roundTrip(text, ref16, FALSE, 2);
+    g_free(text);
+    for (shift = 0; shift < 2; shift++) {
+        text = repeat(shift ? "a" : "", "€", gsmPart + 1);
+        roundTrip(text, ref16, FALSE, 3);
+        g_free(text);
+    }
+
+    // UCS2, BMP only
+    text = repeat("", "ж", 3 * ucs2Part);
+    roundTrip(text, ref16, TRUE, 3);
+    g_free(text);
+    text = repeat("", "ж", 3 * ucs2Part + 1);
+    roundTrip(text, ref16, TRUE, 4);
+    g_free(text);
+
+    // surrogate pairs at both alignments against the part boundary, which
+    // decides how many parts there are
+    for (shift = 0; shift < 2; shift++) {
+        text = repeat(shift ? "ж" : "", "😀", ucs2Part);
+        roundTrip(text, ref16, TRUE, 0);
+        g_free(text);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    testDeliver(FALSE);
+    testDeliver(TRUE);
+
+    return harnessResult();
+}
@@ -0,0 +1,269 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/*
+ * Property name and enum value decoding: ofonoString() and
+ * ofonoStateToRILState() from ril.c against the g_strcmp0 chains they
+ * replaced, kept below in their old order.
+ *
+ *   propbench [-n lookups] [-l label] [-o out.json]
+ *
+ * netreg is a NetworkRegistration PropertyChanged mix, mostly Strength
+ * as when moving, with Status, Technology and Mode values decoded too.
+ * callstate is VoiceCall.State values. The strings are copies, like the
+ * ones demarshalled from a message.
+ */
+
+// the decoders are static
+#include "../src/ril.c"
+
+#include <getopt.h>
+#include <time.h>
+
+/*** The chains before the table ***/
+
+static int chainNetreg(const gchar *property, const gchar *value)
+{
+    if (!g_strcmp0(property, "Strength"))
+        return OFONO_PROP_STRENGTH;
+    else if (!g_strcmp0(property, "BaseStation"))
+        return OFONO_PROP_BASE_STATION;
+    else if (!g_strcmp0(property, "CellId"))
+        return OFONO_PROP_CELL_ID;
+    else if (!g_strcmp0(property, "LocationAreaCode"))
+        return OFONO_PROP_LAC;
+    else if (!g_strcmp0(property, "Status")) {
+        if (!g_strcmp0(value, "searching"))
+            return OFONO_STATUS_SEARCHING;
+        else if (!g_strcmp0(value, "registered"))
+            return OFONO_STATUS_REGISTERED;
+        else if (!g_strcmp0(value, "roaming"))
+            return OFONO_STATUS_ROAMING;
+        return OFONO_PROP_STATUS;
+    }
+    else if (!g_strcmp0(property, "Name"))
+        return OFONO_PROP_NAME;
+    else if (!g_strcmp0(property, "MobileNetworkCode"))
+        return OFONO_PROP_MNC;
+    else if (!g_strcmp0(property, "MobileCountryCode"))
+        return OFONO_PROP_MCC;
+    else if (!g_strcmp0(property, "Technology")) {
+        if (!g_strcmp0(value, "gsm"))
+            return OFONO_TECH_GSM;
+        else if (!g_strcmp0(value, "edge"))
+            return OFONO_TECH_EDGE;
+        else if (!g_strcmp0(value, "umts"))
+            return OFONO_TECH_UMTS;
+        else if (!g_strcmp0(value, "hspa"))
+            return OFONO_TECH_HSPA;
+        else if (!g_strcmp0(value, "lte"))
+            return OFONO_TECH_LTE;
+        return OFONO_PROP_TECHNOLOGY;
+    }
+    else if (!g_strcmp0(property, "Mode")) {
+        if (!g_strcmp0(value, "auto"))
+            return OFONO_MODE_AUTO;
+        else if (!g_strcmp0(value, "manual"))
+            return OFONO_MODE_MANUAL;
+        return OFONO_PROP_MODE;
+    }
+    return OFONO_UNKNOWN;
+}
+
+static RIL_CallState chainCallState(const gchar *state)
+{
+    if (!g_strcmp0(state, "active")) return RIL_CALL_ACTIVE;
+    if (!g_strcmp0(state, "held")) return RIL_CALL_HOLDING;
+    if (!g_strcmp0(state, "dialing")) return RIL_CALL_DIALING;
+    if (!g_strcmp0(state, "alerting")) return RIL_CALL_ALERTING;
+    if (!g_strcmp0(state, "incoming")) return RIL_CALL_INCOMING;
+    if (!g_strcmp0(state, "waiting")) return RIL_CALL_WAITING;
+    return (RIL_CallState) 0xffffffff;
+}
+
+/*** The table, as the handlers use it ***/
+
+static int tableNetreg(const gchar *property, const gchar *value)
+{
+    OfonoString prop = ofonoString(property);
+
+    switch (prop) {
+        case OFONO_PROP_STATUS:
+        case OFONO_PROP_TECHNOLOGY:
+        case OFONO_PROP_MODE: {
+            OfonoString id = ofonoString(value);
+            return id ? id : prop;
+        }
+        default:
+            return prop;
+    }
+}
+
+/*** Workloads ***/
+
+typedef struct {
+    const char  *property;
+    const char  *value;     // for enum properties
+    int         weight;
+} Sample;
+
+static const Sample netregMix[] = {
+    { "Strength",           NULL,           60 },
+    { "CellId",             NULL,           12 },
+    { "LocationAreaCode",   NULL,           6 },
+    { "Technology",         "umts",         6 },
+    { "Technology",         "hspa",         4 },
+    { "Status",             "registered",   4 },
+    { "Status",             "searching",    2 },
+    { "Name",               NULL,           2 },
+    { "MobileCountryCode",  NULL,           1 },
+    { "MobileNetworkCode",  NULL,           1 },
+    { "Mode",               "auto",         1 },
+    { "BaseStation",        NULL,           1 },
+};
+
+static const Sample callMix[] = {
+    { "active",     NULL, 40 },
+    { "alerting",   NULL, 15 },
+    { "dialing",    NULL, 15 },
+    { "incoming",   NULL, 15 },
+    { "held",       NULL, 10 },
+    { "waiting",    NULL, 5 },
+};
+
+#define MIX_SIZE 4096   // power of two
+
+typedef struct {
+    char *property;
+    char *value;
+} Input;
+
+/* Heap copies in a shuffled weighted order */
+static Input *makeInputs(const Sample *mix, unsigned count)
+{
+    Input *inputs = g_new(Input, MIX_SIZE);
+    unsigned total = 0, i, j, seed = 1;
+
+    for (i = 0; i < count; i++)
+        total += mix[i].weight;
+    for (i = 0; i < MIX_SIZE; i++) {
+        unsigned r = rand_r(&seed) % total;
+        for (j = 0; j < count - 1 && r >= (unsigned) mix[j].weight; j++)
+            r -= mix[j].weight;
+        inputs[i].property = g_strdup(mix[j].property);
+        inputs[i].value = g_strdup(mix[j].value);
+    }
+    return inputs;
+}
+
+static uint64_t nowNs()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static volatile int sink;
+
+typedef int (*DecodeFunc)(const Input *input);
+
+static int decodeChainNetreg(const Input *in) { return chainNetreg(in->property, in->value); }
+static int decodeTableNetreg(const Input *in) { return tableNetreg(in->property, in->value); }
+static int decodeChainCall(const Input *in) { return chainCallState(in->property); }
+static int decodeTableCall(const Input *in) { return ofonoStateToRILState(in->property); }
+
+/* ns per lookup, best of three */
+static double measure(DecodeFunc decode, const Input *inputs, unsigned long lookups)
+{
+    double best = 0;
+    int round;
+
+    for (round = 0; round < 3; round++) {
+        uint64_t start = nowNs();
+        unsigned long i;
+        int acc = 0;
+
+        for (i = 0; i < lookups; i++)
+            acc += decode(&inputs[i & (MIX_SIZE - 1)]);
+        sink = acc;
+
+        double ns = (double) (nowNs() - start) / lookups;
+        if (!round || ns < best)
+            best = ns;
+    }
+    return best;
+}
+
+static int check(DecodeFunc a, DecodeFunc b, const Input *inputs)
+{
+    unsigned i;
+
+    for (i = 0; i < MIX_SIZE; i++)
+        if (a(&inputs[i]) != b(&inputs[i])) {
+            fprintf(stderr, "decoders disagree on %s %s\n", inputs[i].property,
+                    inputs[i].value ? inputs[i].value : "");
+            return -1;
+        }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long lookups = 5000000;
+    const char *label = "", *outPath = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:l:o:")) != -1) {
+        switch (opt) {
+            case 'n': lookups = strtoul(optarg, NULL, 0); break;
+            case 'l': label = optarg; break;
+            case 'o': outPath = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-n lookups] [-l label] [-o out.json]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    ofonoStringsInit();
+    Input *netreg = makeInputs(netregMix, G_N_ELEMENTS(netregMix));
+    Input *calls = makeInputs(callMix, G_N_ELEMENTS(callMix));
+
+    if (check(decodeChainNetreg, decodeTableNetreg, netreg) ||
+        check(decodeChainCall, decodeTableCall, calls))
+        return 1;
+
+    double netregChain = measure(decodeChainNetreg, netreg, lookups);
+    double netregTable = measure(decodeTableNetreg, netreg, lookups);
+    double callChain = measure(decodeChainCall, calls, lookups);
+    double callTable = measure(decodeTableCall, calls, lookups);
+
+    FILE *out = outPath ? fopen(outPath, "w") : stdout;
+    if (!out) {
+        perror(outPath);
+        return 1;
+    }
+    fprintf(out, "{\n  \"benchmark\": \"propbench\",\n  \"label\": \"%s\",\n", label);
+    fprintf(out, "  \"lookups\": %lu,\n  \"unit\": \"ns per lookup\",\n", lookups);
+    fprintf(out, "  \"netreg\": { \"strcmp_chain\": %.2f, \"hash\": %.2f },\n",
+            netregChain, netregTable);
+    fprintf(out, "  \"callstate\": { \"strcmp_chain\": %.2f, \"hash\": %.2f }\n}\n",
+            callChain, callTable);
+    if (out != stdout)
+        fclose(out);
+    return 0;
+}
@@ -0,0 +1,466 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/*
+ * Plays a signal trace from ofono-sigrecord back into the library's
+ * DBusConnection and measures the dbus_g_proxy_manager_filter to handler
+ * path: signals/s, CPU time and allocations per signal.
+ *
+ *   replay [-f trace.sig] [-x 1,10,0] [-r /oldmodem:/isimodem]
+ *          [-l label] [-o out.json]
+ *
+ * -x lists the speeds, 0 is as fast as possible. Without -f a synthetic
+ * trace is recorded from fake-ofono.py storms first. -r moves object
+ * paths under another modem to /isimodem, where the fake has its modem.
+ *
+ * The link wraps dbus_connection_add_filter to learn the library's
+ * filters. Messages are demarshalled, given the sender that owns
+ * org.ofono and run through those filters on the main loop thread, as
+ * dbus_connection_dispatch() would after reading them off the socket.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <glib.h>
+#include <dbus/dbus.h>
+
+#include "harness.h"
+#include "allocs.h"
+#include "sigtrace.h"
+
+#define MAX_FILTERS 8
+#define MAX_SPEEDS  8
+#define BATCH       64      // signals per main loop callback at full speed
+
+/*** Filters of the library's connection ***/
+
+typedef struct {
+    DBusConnection              *connection;
+    DBusHandleMessageFunction   function;
+    void                        *data;
+} Filter;
+
+static Filter filters[MAX_FILTERS];
+static int filterCount;
+static pthread_mutex_t filterLock = PTHREAD_MUTEX_INITIALIZER;
+
+dbus_bool_t __real_dbus_connection_add_filter(DBusConnection *connection,
+                                              DBusHandleMessageFunction function,
+                                              void *data, DBusFreeFunction freeData);
+void __real_dbus_connection_remove_filter(DBusConnection *connection,
+                                          DBusHandleMessageFunction function,
+                                          void *data);
+
+dbus_bool_t __wrap_dbus_connection_add_filter(DBusConnection *connection,
+                                              DBusHandleMessageFunction function,
+                                              void *data, DBusFreeFunction freeData)
+{
+    pthread_mutex_lock(&filterLock);
+    if (filterCount < MAX_FILTERS) {
+        Filter filter = { connection, function, data };
+        filters[filterCount++] = filter;
+    }
+    pthread_mutex_unlock(&filterLock);
+    return __real_dbus_connection_add_filter(connection, function, data, freeData);
+}
+
+void __wrap_dbus_connection_remove_filter(DBusConnection *connection,
+                                          DBusHandleMessageFunction function,
+                                          void *data)
+{
+    int i;
+
+    pthread_mutex_lock(&filterLock);
+    for (i = 0; i < filterCount; i++) {
+        if (filters[i].connection == connection && filters[i].function == function &&
+            filters[i].data == data) {
+            memmove(&filters[i], &filters[i + 1], (filterCount - i - 1) * sizeof(Filter));
+            filterCount--;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&filterLock);
+    __real_dbus_connection_remove_filter(connection, function, data);
+}
+
+/*** The trace ***/
+
+typedef struct {
+    uint64_t    time;       // us from the first signal
+    char        *message;   // marshalled
+    uint32_t    len;
+} Record;
+
+static Record *records;
+static unsigned recordCount;
+
+static int loadTrace(FILE *file)
+{
+    unsigned capacity = 0;
+    uint64_t time = 0, delta;
+    char *message;
+    uint32_t len;
+    int ret;
+
+    if (sigtraceReadHeader(file)) {
+        fprintf(stderr, "not a signal trace\n");
+        return -1;
+    }
+    while ((ret = sigtraceRead(file, &delta, &message, &len)) > 0) {
+        if (recordCount == capacity) {
+            capacity = capacity ? capacity * 2 : 1024;
+            records = realloc(records, capacity * sizeof(Record));
+        }
+        time += delta;
+        records[recordCount].time = recordCount ? time : 0;
+        records[recordCount].message = message;
+        records[recordCount].len = len;
+        recordCount++;
+    }
+    if (ret < 0)
+        fprintf(stderr, "damaged trace, using the first %u signals\n", recordCount);
+    return recordCount ? 0 : -1;
+}
+
+/* Storms from the fake, recorded off the private bus */
+
+typedef struct {
+    DBusConnection  *connection;
+    FILE            *file;
+    volatile int    stop;
+    long            count;
+} Recorder;
+
+static void *recordThread(void *param)
+{
+    Recorder *rec = param;
+
+    rec->count = sigtraceRecord(rec->connection, rec->file, &rec->stop, 0);
+    return NULL;
+}
+
+static FILE *recordSynthetic()
+{
+    static const char *storms[] = {
+        "storm strength 2000",
+        "storm netreg 1000",
+        "storm calls 200",
+        "storm sms 200",
+        "storm ussd 200",
+    };
+    Recorder rec = { NULL, tmpfile(), 0, 0 };
+    DBusError error;
+    pthread_t thread;
+    unsigned i;
+
+    dbus_error_init(&error);
+    rec.connection = dbus_connection_open_private(getenv("DBUS_SYSTEM_BUS_ADDRESS"), &error);
+    if (!rec.connection || !dbus_bus_register(rec.connection, &error)) {
+        fprintf(stderr, "recorder can't connect: %s\n", error.message);
+        return NULL;
+    }
+    if (!rec.file || sigtraceWriteHeader(rec.file) || sigtraceMatch(rec.connection))
+        return NULL;
+
+    pthread_create(&thread, NULL, recordThread, &rec);
+    for (i = 0; i < G_N_ELEMENTS(storms); i++)
+        harnessOfono(NULL, 0, "%s", storms[i]);
+    harnessOfono(NULL, 0, "sync");
+    usleep(200000);     // the last signals are on their way to the recorder
+    rec.stop = 1;
+    pthread_join(thread, NULL);
+
+    dbus_connection_close(rec.connection);
+    dbus_connection_unref(rec.connection);
+    if (rec.count <= 0)
+        return NULL;
+    rewind(rec.file);
+    return rec.file;
+}
+
+/*** Replay ***/
+
+typedef struct {
+    double          speed;      // 0 for full speed
+    const char      *sender;    // unique name owning org.ofono
+    const char      *fromPath, *toPath;
+    DBusConnection  *connection;
+    unsigned        next;
+    uint64_t        start, end; // us, first and last dispatch
+    uint64_t        cpu;        // ns on the main loop thread
+    unsigned long long allocs;
+    unsigned        failed;     // couldn't demarshal
+    int             done;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+} Run;
+
+static uint64_t threadCpu()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void dispatch(Run *run, const Record *record, Filter *list, int count)
+{
+    DBusError error;
+    DBusMessage *message;
+    int i;
+
+    dbus_error_init(&error);
+    message = dbus_message_demarshal(record->message, record->len, &error);
+    if (!message) {
+        run->failed++;
+        dbus_error_free(&error);
+        return;
+    }
+    dbus_message_set_sender(message, run->sender);
+    if (run->fromPath) {
+        const char *path = dbus_message_get_path(message);
+        size_t len = strlen(run->fromPath);
+
+        if (path && !strncmp(path, run->fromPath, len) && ('/' == path[len] || !path[len])) {
+            char *moved = g_strconcat(run->toPath, path + len, NULL);
+            dbus_message_set_path(message, moved);
+            g_free(moved);
+        }
+    }
+
+    for (i = 0; i < count; i++)
+        if (DBUS_HANDLER_RESULT_NOT_YET_HANDLED !=
+            list[i].function(run->connection, message, list[i].data))
+            break;
+    dbus_message_unref(message);
+}
+
+static gboolean replayStep(gpointer data);
+
+static void schedule(Run *run, uint64_t delay)
+{
+    if (delay >= 1000)
+        g_timeout_add(delay / 1000, replayStep, run);
+    else
+        g_idle_add(replayStep, run);
+}
+
+/* Main loop thread */
+static gboolean replayStep(gpointer data)
+{
+    Run *run = data;
+    Filter list[MAX_FILTERS];
+    int count = 0, i, handled = 0;
+
+    pthread_mutex_lock(&filterLock);
+    for (i = 0; i < filterCount; i++)
+        if (filters[i].connection == run->connection)
+            list[count++] = filters[i];
+    pthread_mutex_unlock(&filterLock);
+
+    uint64_t now = harnessNow();
+    uint64_t cpu = threadCpu();
+    unsigned long long allocs = allocsThread();
+
+    if (!run->start)
+        run->start = now;
+
+    while (run->next < recordCount && handled < BATCH) {
+        if (run->speed > 0) {
+            uint64_t due = run->start + records[run->next].time / run->speed;
+
+            now = harnessNow();
+            if (due > now) {
+                schedule(run, due - now);
+                break;
+            }
+        }
+        dispatch(run, &records[run->next], list, count);
+        run->next++;
+        handled++;
+    }
+
+    run->cpu += threadCpu() - cpu;
+    run->allocs += allocsThread() - allocs;
+
+    if (run->next == recordCount) {
+        run->end = harnessNow();
+        pthread_mutex_lock(&run->lock);
+        run->done = 1;
+        pthread_cond_signal(&run->cond);
+        pthread_mutex_unlock(&run->lock);
+        return FALSE;
+    }
+    // a batch is done, let the main loop do its own work in between
+    if (handled == BATCH)
+        schedule(run, 0);
+    return FALSE;
+}
+
+/* Unsolicited responses so far, the handlers did run if this moves */
+static unsigned unsolTotal()
+{
+    unsigned total = 0;
+    int unsol;
+
+    for (unsol = RIL_UNSOL_RESPONSE_BASE; unsol < RIL_UNSOL_RESPONSE_BASE + 32; unsol++)
+        total += harnessUnsolCount(unsol);
+    return total;
+}
+
+static char *ofonoOwner(DBusConnection *connection)
+{
+    DBusMessage *call, *reply;
+    DBusError error;
+    const char *name = "org.ofono", *owner = NULL;
+    char *ret = NULL;
+
+    dbus_error_init(&error);
+    call = dbus_message_new_method_call(DBUS_SERVICE_DBUS, DBUS_PATH_DBUS,
+                                        DBUS_INTERFACE_DBUS, "GetNameOwner");
+    dbus_message_append_args(call, DBUS_TYPE_STRING, &name, DBUS_TYPE_INVALID);
+    reply = dbus_connection_send_with_reply_and_block(connection, call, 5000, &error);
+    dbus_message_unref(call);
+    if (reply) {
+        if (dbus_message_get_args(reply, &error, DBUS_TYPE_STRING, &owner, DBUS_TYPE_INVALID))
+            ret = strdup(owner);
+        dbus_message_unref(reply);
+    }
+    if (dbus_error_is_set(&error)) {
+        fprintf(stderr, "GetNameOwner: %s\n", error.message);
+        dbus_error_free(&error);
+    }
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    const char *tracePath = NULL, *label = "", *outPath = NULL;
+    char *fromPath = NULL;
+    double speeds[MAX_SPEEDS] = { 1, 10, 0 };
+    int speedCount = 3, opt, i;
+
+    while ((opt = getopt(argc, argv, "f:x:r:l:o:")) != -1) {
+        switch (opt) {
+            case 'f': tracePath = optarg; break;
+            case 'x': {
+                char *item, *save = NULL;
+                speedCount = 0;
+                for (item = strtok_r(optarg, ",", &save); item && speedCount < MAX_SPEEDS;
+                     item = strtok_r(NULL, ",", &save))
+                    speeds[speedCount++] = atof(item);
+                break;
+            }
+            case 'r': fromPath = optarg; break;
+            case 'l': label = optarg; break;
+            case 'o': outPath = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-f trace.sig] [-x speed,...] [-r from:to] "
+                        "[-l label] [-o out.json]\n", argv[0]);
+                return 2;
+        }
+    }
+    char *toPath = fromPath ? strchr(fromPath, ':') : NULL;
+    if (fromPath && !toPath) {
+        fprintf(stderr, "-r wants FROM:TO\n");
+        return 2;
+    }
+    if (toPath)
+        *toPath++ = 0;
+
+    // before glib starts, older glib keeps g_slice to itself otherwise
+    setenv("G_SLICE", "always-malloc", 1);
+
+    if (harnessStart(0, NULL, NULL)) {
+        fprintf(stderr, "bring-up failed\n");
+        return 1;
+    }
+
+    FILE *file = tracePath ? fopen(tracePath, "rb") : recordSynthetic();
+    if (!file || loadTrace(file)) {
+        fprintf(stderr, "no signals to replay\n");
+        return 1;
+    }
+    fclose(file);
+
+    DBusConnection *connection = dbus_bus_get(DBUS_BUS_SYSTEM, NULL);
+    char *sender = connection ? ofonoOwner(connection) : NULL;
+    if (!sender)
+        return 1;
+
+    FILE *out = outPath ? fopen(outPath, "w") : stdout;
+    if (!out) {
+        perror(outPath);
+        return 1;
+    }
+    fprintf(out, "{\n  \"benchmark\": \"replay\",\n  \"label\": \"%s\",\n", label);
+    fprintf(out, "  \"trace\": \"%s\",\n  \"signals\": %u,\n  \"runs\": [",
+            tracePath ? tracePath : "synthetic", recordCount);
+
+    for (i = 0; i < speedCount; i++) {
+        Run run;
+
+        memset(&run, 0, sizeof(run));
+        run.speed = speeds[i];
+        run.sender = sender;
+        run.fromPath = fromPath;
+        run.toPath = toPath;
+        run.connection = connection;
+        pthread_mutex_init(&run.lock, NULL);
+        pthread_cond_init(&run.cond, NULL);
+
+        unsigned unsol = unsolTotal();
+        g_idle_add(replayStep, &run);
+        pthread_mutex_lock(&run.lock);
+        while (!run.done)
+            pthread_cond_wait(&run.cond, &run.lock);
+        pthread_mutex_unlock(&run.lock);
+
+        // coalesced ones may still be pending, not a rate
+        unsol = unsolTotal() - unsol;
+
+        double seconds = (run.end - run.start) / 1e6;
+        char speed[32];
+
+        if (run.speed > 0)
+            snprintf(speed, sizeof(speed), "%gx", run.speed);
+        else
+            snprintf(speed, sizeof(speed), "max");
+        fprintf(out, "%s\n    { \"speed\": \"%s\", \"seconds\": %.6f, \"signals_per_s\": %.0f, "
+                "\"cpu_us_per_signal\": %.3f, \"allocs_per_signal\": %.2f, \"unsolicited\": %u, "
+                "\"undecodable\": %u }",
+                i ? "," : "", speed, seconds,
+                seconds > 0 ? recordCount / seconds : 0.0,
+                run.cpu / 1000.0 / recordCount,
+                (double) run.allocs / recordCount, unsol, run.failed);
+
+        pthread_mutex_destroy(&run.lock);
+        pthread_cond_destroy(&run.cond);
+    }
+    fprintf(out, "\n  ]\n}\n");
+    if (out != stdout)
+        fclose(out);
+
+    free(sender);
+    dbus_connection_unref(connection);
+    return 0;
+}
@@ -0,0 +1,207 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/*
+ * ofono crashing mid-call: fake-ofono.py is killed with an active call,
+ * started again, and the time to get back to a working phone measured.
+ * Exits non-zero if any check failed.
+ *
+ *   restart [-r rounds] [-l label] [-o out.json]
+ *
+ * lost is from the kill until the radio is unavailable and the call
+ * dropped. attached is the library's "ofono restart" stats, from losing
+ * ofono until the modem was attached again, python's start-up included.
+ * The rest is from the new ofono owning its name: radio until SIM_READY,
+ * registered until REGISTRATION_STATE says so again, and call until a
+ * new incoming call shows up in GET_CURRENT_CALLS.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+
+#include "harness.h"
+
+#define TIMEOUT     10000   // ms
+#define MAX_ROUNDS  50
+
+typedef enum {
+    TIME_LOST = 0,
+    TIME_ATTACHED,
+    TIME_RADIO,
+    TIME_REGISTERED,
+    TIME_CALL,
+    TIME_COUNT
+} Milestone;
+
+static const char *milestoneNames[TIME_COUNT] = {
+    "lost", "attached", "radio", "registered", "call",
+};
+
+static uint64_t times[TIME_COUNT][MAX_ROUNDS];
+
+/* Calls in GET_CURRENT_CALLS, -1 if it failed */
+static int callCount(RIL_CallState *state)
+{
+    HarnessRequest *req = harnessCall(RIL_REQUEST_GET_CURRENT_CALLS, NULL, 0, TIMEOUT);
+
+    if (!req || RIL_E_SUCCESS != req->error)
+        return -1;
+    if (state && req->response.ncalls)
+        *state = req->response.calls[0].state;
+    return req->response.ncalls;
+}
+
+/* Polls until GET_CURRENT_CALLS has count calls, the first in state if any */
+static int waitCalls(int count, RIL_CallState state, int timeoutMs)
+{
+    uint64_t end = harnessNow() + (uint64_t) timeoutMs * 1000;
+
+    do {
+        RIL_CallState first = state;
+
+        if (callCount(&first) == count && first == state)
+            return 0;
+        usleep(1000);
+    } while (harnessNow() < end);
+    return -1;
+}
+
+/* An incoming call answered, as the framework does it */
+static int answeredCall()
+{
+    if (harnessOfono(NULL, 0, "call-incoming +358401234567") ||
+        waitCalls(1, RIL_CALL_INCOMING, TIMEOUT))
+        return -1;
+
+    HarnessRequest *req = harnessCall(RIL_REQUEST_ANSWER, NULL, 0, TIMEOUT);
+    if (!req || RIL_E_SUCCESS != req->error)
+        return -1;
+    return waitCalls(1, RIL_CALL_ACTIVE, TIMEOUT);
+}
+
+/* The library's own measure of the last restart, us, 0 if count is off */
+static uint64_t statsRestart(unsigned count)
+{
+    char *line = harnessStatsLine("ofono restart");
+    unsigned long long last = 0;
+    unsigned seen = 0;
+
+    if (line && 2 == sscanf(line, "ofono restart: count=%u last=%llu", &seen, &last) &&
+        seen == count) {
+        free(line);
+        return last;
+    }
+    free(line);
+    return 0;
+}
+
+static int interruptCall(int round)
+{
+    if (answeredCall()) {
+        fprintf(stderr, "round %d: no call to interrupt\n", round);
+        return -1;
+    }
+
+    unsigned changes = harnessUnsolCount(RIL_UNSOL_RESPONSE_CALL_STATE_CHANGED);
+    uint64_t start = harnessNow();
+    harnessOfonoKill();
+    CHECK(!harnessWaitRadio(RADIO_STATE_UNAVAILABLE, TIMEOUT));
+    CHECK(!harnessWaitUnsol(RIL_UNSOL_RESPONSE_CALL_STATE_CHANGED, changes + 1, TIMEOUT));
+    times[TIME_LOST][round] = harnessNow() - start;
+
+    if (harnessOfonoStart(NULL)) {
+        fprintf(stderr, "round %d: fake ofono didn't start again\n", round);
+        return -1;
+    }
+    start = harnessNow();
+
+    // the framework keeps the radio on, the library powers the new modem
+    CHECK(!harnessWaitRadio(RADIO_STATE_SIM_READY, TIMEOUT));
+    times[TIME_RADIO][round] = harnessNow() - start;
+    // the dropped call doesn't come back
+    CHECK(0 == callCount(NULL));
+    CHECK(!harnessWaitRegistered(TIMEOUT));
+    times[TIME_REGISTERED][round] = harnessNow() - start;
+    times[TIME_ATTACHED][round] = statsRestart(round + 1);
+    CHECK(times[TIME_ATTACHED][round]);
+
+    CHECK(!harnessOfono(NULL, 0, "call-incoming +358407654321"));
+    CHECK(!waitCalls(1, RIL_CALL_INCOMING, TIMEOUT));
+    times[TIME_CALL][round] = harnessNow() - start;
+
+    // and it can be hung up on the new ofono
+    int line = 1;
+    HarnessRequest *req = harnessCall(RIL_REQUEST_HANGUP, &line, sizeof(line), TIMEOUT);
+    CHECK(req && RIL_E_SUCCESS == req->error);
+    CHECK(!waitCalls(0, 0, TIMEOUT));
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *label = "", *outPath = NULL;
+    int rounds = 5, opt, i;
+
+    while ((opt = getopt(argc, argv, "r:l:o:")) != -1) {
+        switch (opt) {
+            case 'r': rounds = atoi(optarg); break;
+            case 'l': label = optarg; break;
+            case 'o': outPath = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-r rounds] [-l label] [-o out.json]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (rounds <= 0 || rounds > MAX_ROUNDS) {
+        fprintf(stderr, "rounds is 1-%d\n", MAX_ROUNDS);
+        return 2;
+    }
+
+    if (harnessStart(0, NULL, NULL)) {
+        fprintf(stderr, "bring-up failed\n");
+        return 1;
+    }
+
+    for (i = 0; i < rounds; i++)
+        if (interruptCall(i))
+            return 1;
+    CHECK(0 == harnessBadCompletions());
+
+    FILE *out = outPath ? fopen(outPath, "w") : stdout;
+    if (!out) {
+        perror(outPath);
+        return 1;
+    }
+    fprintf(out, "{\n  \"benchmark\": \"restart\",\n  \"label\": \"%s\",\n", label);
+    fprintf(out, "  \"rounds\": %d,\n  \"unit\": \"us\"", rounds);
+    for (i = 0; i < TIME_COUNT; i++) {
+        uint64_t *t = times[i];
+
+        uint64_t median = harnessMedian(t, rounds);
+        fprintf(out, ",\n  \"%s\": { \"median\": %llu, \"min\": %llu, \"max\": %llu }",
+                milestoneNames[i], (unsigned long long) median,
+                (unsigned long long) t[0], (unsigned long long) t[rounds - 1]);
+    }
+    fprintf(out, "\n}\n");
+    if (out != stdout)
+        fclose(out);
+
+    return harnessResult();
+}
@@ -0,0 +1,105 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/*
+ * Records ofono's PropertyChanged, CallAdded, CallRemoved, IncomingMessage
+ * and RequestReceived signals into a trace for replay, see sigtrace.h:
+ *
+ *   adb shell ofono-sigrecord -d 600 /data/radio/ofono.sig
+ *   adb pull /data/radio/ofono.sig
+ *
+ * Stops after -d seconds, -n signals or on SIGINT/SIGTERM. The system bus
+ * is used unless -a gives another address.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "sigtrace.h"
+
+static volatile int stop;
+
+static void onSignal(int sig)
+{
+    stop = 1;
+}
+
+int main(int argc, char **argv)
+{
+    const char *address = NULL;
+    unsigned long limit = 0;
+    int seconds = 0, opt;
+    DBusConnection *connection;
+    DBusError error;
+
+    while ((opt = getopt(argc, argv, "a:d:n:")) != -1) {
+        switch (opt) {
+            case 'a': address = optarg; break;
+            case 'd': seconds = atoi(optarg); break;
+            case 'n': limit = strtoul(optarg, NULL, 0); break;
+            default: optind = argc + 1; break;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "usage: %s [-a address] [-d seconds] [-n signals] out.sig\n", argv[0]);
+        return 2;
+    }
+
+    dbus_error_init(&error);
+    if (address) {
+        connection = dbus_connection_open_private(address, &error);
+        if (connection && !dbus_bus_register(connection, &error)) {
+            dbus_connection_close(connection);
+            dbus_connection_unref(connection);
+            connection = NULL;
+        }
+    } else {
+        connection = dbus_bus_get_private(DBUS_BUS_SYSTEM, &error);
+    }
+    if (!connection) {
+        fprintf(stderr, "can't connect: %s\n", error.message);
+        return 1;
+    }
+    dbus_connection_set_exit_on_disconnect(connection, FALSE);
+
+    FILE *file = fopen(argv[optind], "wb");
+    if (!file) {
+        perror(argv[optind]);
+        return 1;
+    }
+    if (sigtraceWriteHeader(file) || sigtraceMatch(connection))
+        return 1;
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    signal(SIGALRM, onSignal);
+    if (seconds > 0)
+        alarm(seconds);
+
+    long count = sigtraceRecord(connection, file, &stop, limit);
+    if (fclose(file) || count < 0) {
+        perror(argv[optind]);
+        return 1;
+    }
+    fprintf(stderr, "%ld signals\n", count);
+
+    dbus_connection_close(connection);
+    dbus_connection_unref(connection);
+    return 0;
+}
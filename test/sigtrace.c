@@ -0,0 +1,173 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sigtrace.h"
+
+#define MAX_MESSAGE (128 * 1024 * 1024)    // DBUS_MAXIMUM_MESSAGE_LENGTH
+
+const char *sigtraceRules[] = {
+    "type='signal',sender='org.ofono',member='PropertyChanged'",
+    "type='signal',sender='org.ofono',member='CallAdded'",
+    "type='signal',sender='org.ofono',member='CallRemoved'",
+    "type='signal',sender='org.ofono',member='IncomingMessage'",
+    "type='signal',sender='org.ofono',member='RequestReceived'",
+    NULL
+};
+
+static int writeVarint(FILE *file, uint64_t value)
+{
+    unsigned char buf[10];
+    int len = 0;
+
+    do {
+        buf[len] = value & 0x7f;
+        value >>= 7;
+        if (value)
+            buf[len] |= 0x80;
+        len++;
+    } while (value);
+    return fwrite(buf, 1, len, file) == (size_t) len ? 0 : -1;
+}
+
+/* 1 on success, 0 at a clean end, -1 on a truncated varint */
+static int readVarint(FILE *file, uint64_t *value)
+{
+    int shift, c;
+
+    *value = 0;
+    for (shift = 0; shift < 64; shift += 7) {
+        c = getc(file);
+        if (EOF == c)
+            return shift ? -1 : 0;
+        *value |= (uint64_t) (c & 0x7f) << shift;
+        if (!(c & 0x80))
+            return 1;
+    }
+    return -1;
+}
+
+int sigtraceWriteHeader(FILE *file)
+{
+    SigtraceHeader header = { SIGTRACE_MAGIC, SIGTRACE_VERSION };
+
+    return fwrite(&header, sizeof(header), 1, file) == 1 ? 0 : -1;
+}
+
+int sigtraceWrite(FILE *file, uint64_t delta, DBusMessage *message)
+{
+    char *buf;
+    int len, ret;
+
+    if (!dbus_message_marshal(message, &buf, &len))
+        return -1;
+    ret = writeVarint(file, delta) || writeVarint(file, len) ||
+          fwrite(buf, 1, len, file) != (size_t) len ? -1 : 0;
+    dbus_free(buf);
+    return ret;
+}
+
+int sigtraceReadHeader(FILE *file)
+{
+    SigtraceHeader header;
+
+    if (fread(&header, sizeof(header), 1, file) != 1)
+        return -1;
+    return SIGTRACE_MAGIC == header.magic && SIGTRACE_VERSION == header.version ? 0 : -1;
+}
+
+int sigtraceRead(FILE *file, uint64_t *delta, char **message, uint32_t *len)
+{
+    uint64_t size;
+    int ret = readVarint(file, delta);
+
+    if (ret <= 0)
+        return ret;
+    if (readVarint(file, &size) <= 0 || size > MAX_MESSAGE)
+        return -1;
+
+    *message = malloc(size);
+    if (!*message || fread(*message, 1, size, file) != size) {
+        free(*message);
+        *message = NULL;
+        return -1;
+    }
+    *len = size;
+    return 1;
+}
+
+int sigtraceMatch(DBusConnection *connection)
+{
+    DBusError error;
+    const char **rule;
+
+    dbus_error_init(&error);
+    for (rule = sigtraceRules; *rule; rule++) {
+        dbus_bus_add_match(connection, *rule, &error);
+        if (dbus_error_is_set(&error)) {
+            fprintf(stderr, "%s: %s\n", *rule, error.message);
+            dbus_error_free(&error);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static uint64_t now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+long sigtraceRecord(DBusConnection *connection, FILE *file,
+                    volatile int *stop, unsigned long limit)
+{
+    uint64_t last = 0;
+    long count = 0;
+
+    while (!*stop && (!limit || (unsigned long) count < limit)) {
+        DBusMessage *message;
+
+        if (!dbus_connection_read_write(connection, 100))
+            break;      // disconnected
+
+        while ((!limit || (unsigned long) count < limit) &&
+               (message = dbus_connection_pop_message(connection))) {
+            if (DBUS_MESSAGE_TYPE_SIGNAL == dbus_message_get_type(message) &&
+                !dbus_message_has_interface(message, DBUS_INTERFACE_DBUS) &&
+                !dbus_message_has_interface(message, DBUS_INTERFACE_LOCAL)) {
+                // the time the message was read, not when it was sent
+                uint64_t time = now();
+
+                if (sigtraceWrite(file, last ? time - last : 0, message)) {
+                    dbus_message_unref(message);
+                    return -1;
+                }
+                last = time;
+                count++;
+            }
+            dbus_message_unref(message);
+        }
+    }
+    fflush(file);
+    return count;
+}
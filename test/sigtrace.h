@@ -0,0 +1,79 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef __SIGTRACE_H
+#define __SIGTRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <dbus/dbus.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Recorded ofono signal traffic, written by ofono-sigrecord and played
+ * back by replay. Only libdbus is needed, the recorder runs on devices.
+ *
+ * File layout: SigtraceHeader, then one record per signal: the time since
+ * the previous record in us and the length of the message, both LEB128
+ * varints, and the message as dbus_message_marshal() has it.
+ */
+
+#define SIGTRACE_MAGIC   0x4749534f     // "OSIG"
+#define SIGTRACE_VERSION 1
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+} SigtraceHeader;
+
+/* Match rules for the recorded signals, NULL terminated */
+extern const char *sigtraceRules[];
+
+int sigtraceWriteHeader(FILE *file);
+
+/* 0 on success */
+int sigtraceWrite(FILE *file, uint64_t delta, DBusMessage *message);
+
+/* 0 if file starts with a header of this version */
+int sigtraceReadHeader(FILE *file);
+
+/**
+ * Next record, the message is malloc()ed
+ *
+ * @return  1 for a record, 0 at the end, -1 if the file is damaged
+ */
+int sigtraceRead(FILE *file, uint64_t *delta, char **message, uint32_t *len);
+
+/* Add the match rules to connection, 0 on success */
+int sigtraceMatch(DBusConnection *connection);
+
+/**
+ * Write the signals arriving on connection until *stop is set or limit
+ * signals are written (0 for no limit), the connection must have no
+ * other users. Returns the number written, -1 on write errors.
+ */
+long sigtraceRecord(DBusConnection *connection, FILE *file,
+                    volatile int *stop, unsigned long limit);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SIGTRACE_H
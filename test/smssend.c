@@ -0,0 +1,370 @@
+/*
+**
+** Copyright (C) 2010 The NitDroid Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/*
+ * Sending SMS against fake-ofono.py: which PDUs become one SendMessage
+ * and which go to SendPdu as they are, exits non-zero if any check
+ * failed.
+ *
+ * The parts of a concatenated message have to reach SendMessage once as
+ * the joined text and complete every request, a surrogate pair split
+ * across parts included. Parts whose siblings don't come within the
+ * concatenation timeout, repeated parts, and whatever SendMessage can't
+ * express have to reach SendPdu unchanged. ofono's errors have to map
+ * to the RIL errors the framework retries or gives up on.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "harness.h"
+
+#define TIMEOUT         5000    // ms
+#define CONCAT_TIMEOUT  2000    // ms, SMS_CONCAT_TIMEOUT in ril.c
+#define NUMBER          "+358401234567"
+
+/*** SMS-SUBMIT PDUs ***/
+
+typedef struct {
+    unsigned char   octets[200];
+    int             len;
+} Pdu;
+
+static void put(Pdu *pdu, const unsigned char *octets, int len)
+{
+    memcpy(&pdu->octets[pdu->len], octets, len);
+    pdu->len += len;
+}
+
+static void putOctet(Pdu *pdu, unsigned char octet)
+{
+    put(pdu, &octet, 1);
+}
+
+/* Septets from skip on, characters GSM has at their ASCII codes only */
+static int packGsm(const char *text, int skip, unsigned char *out)
+{
+    int count = skip + strlen(text), i;
+
+    memset(out, 0, (count * 7 + 7) / 8);
+    for (i = skip; i < count; i++) {
+        int bit = 7 * i;
+        unsigned septet = text[i - skip] & 0x7f;
+
+        out[bit / 8] |= septet << (bit % 8);
+        if (bit % 8 > 1)
+            out[bit / 8 + 1] |= septet >> (8 - bit % 8);
+    }
+    return (count * 7 + 7) / 8;
+}
+
+/* TP-DA, international for a '+', alphanumeric if it starts with a letter */
+static void putAddress(Pdu *pdu, const char *address)
+{
+    unsigned char packed[16];
+    int i;
+
+    if (address[0] >= 'A') {
+        int octets = packGsm(address, 0, packed);
+        putOctet(pdu, (strlen(address) * 7 + 3) / 4);   // semi-octets used
+        putOctet(pdu, 0xd0);
+        put(pdu, packed, octets);
+        return;
+    }
+
+    int international = '+' == address[0];
+    const char *digits = address + international;
+    int count = strlen(digits);
+
+    putOctet(pdu, count);
+    putOctet(pdu, international ? 0x91 : 0x81);
+    for (i = 0; i < count; i += 2)
+        putOctet(pdu, (i + 1 < count ? (digits[i + 1] - '0') << 4 : 0xf0) | (digits[i] - '0'));
+}
+
+/* First octet to TP-DCS, TP-UDHI is added by putUserData() */
+static void putHeader(Pdu *pdu, unsigned char firstOctet, const char *address,
+                      unsigned char pid, unsigned char dcs)
+{
+    pdu->len = 0;
+    putOctet(pdu, 0x01 | firstOctet);   // SMS-SUBMIT
+    putOctet(pdu, 0x00);                // TP-MR
+    putAddress(pdu, address);
+    putOctet(pdu, pid);
+    putOctet(pdu, dcs);
+    if (firstOctet & 0x18)
+        putOctet(pdu, 0xa7);            // TP-VP, relative, a day
+}
+
+/* UDL and UD, with an 8-bit concatenation header if total, octets for UCS2 or 8-bit data */
+static void putUserData(Pdu *pdu, int octets, const unsigned char *data, int len,
+                        unsigned char ref, unsigned char total, unsigned char seq)
+{
+    unsigned char udh[] = { 0x05, 0x00, 0x03, ref, total, seq };
+    int udhLen = total ? sizeof(udh) : 0;
+
+    if (total)
+        pdu->octets[0] |= 0x40;         // TP-UDHI
+    if (octets) {
+        putOctet(pdu, udhLen + len);
+        put(pdu, udh, udhLen);
+        put(pdu, data, len);
+    } else {
+        unsigned char ud[160];
+        int skip = (udhLen * 8 + 6) / 7;
+        int udOctets = packGsm((const char *) data, skip, ud);
+
+        memcpy(ud, udh, udhLen);
+        putOctet(pdu, skip + strlen((const char *) data));
+        put(pdu, ud, udOctets);
+    }
+}
+
+static const char *hex(const Pdu *pdu)
+{
+    static char out[2 * sizeof(pdu->octets) + 1];
+    int i;
+
+    for (i = 0; i < pdu->len; i++)
+        sprintf(&out[2 * i], "%02X", pdu->octets[i]);
+    out[2 * i] = 0;
+    return out;
+}
+
+/* GSM text in a single PDU, or one part of a message */
+static const char *textPdu(const char *text, unsigned char ref, unsigned char total,
+                           unsigned char seq)
+{
+    Pdu pdu;
+
+    putHeader(&pdu, 0, NUMBER, 0x00, 0x00);
+    putUserData(&pdu, 0, (const unsigned char *) text, strlen(text), ref, total, seq);
+    return hex(&pdu);
+}
+
+/* GSM text of message class 0 */
+static const char *flashPdu(const char *text)
+{
+    Pdu pdu;
+
+    putHeader(&pdu, 0, NUMBER, 0x00, 0x10);
+    putUserData(&pdu, 0, (const unsigned char *) text, strlen(text), 0, 0, 0);
+    return hex(&pdu);
+}
+
+/*** Requests ***/
+
+static HarnessRequest *sendSms(const char *pdu)
+{
+    const char *data[2] = { NULL, pdu };
+
+    return harnessRequest(RIL_REQUEST_SEND_SMS, data, sizeof(data));
+}
+
+/* Calls the fake has had to MessageManager.method */
+static int calls(const char *method)
+{
+    char reply[32];
+
+    if (harnessOfono(reply, sizeof(reply), "count MessageManager.%s", method))
+        return -1;
+    return atoi(reply);
+}
+
+/* Arguments of the latest call to MessageManager.method */
+static const char *lastCall(const char *method)
+{
+    static char reply[1024];
+
+    if (harnessOfono(reply, sizeof(reply), "last MessageManager.%s", method))
+        return "";
+    return reply;
+}
+
+static int succeeded(HarnessRequest *req)
+{
+    return !harnessWait(req, TIMEOUT) && RIL_E_SUCCESS == req->error
+           && 2 == req->response.nints && req->response.ints[0] >= 0
+           && req->response.ints[0] <= 0xff;
+}
+
+/*** Tests ***/
+
+static void testSingle()
+{
+    int messages = calls("SendMessage"), pdus = calls("SendPdu");
+
+    CHECK(succeeded(sendSms(textPdu("Hello world", 0, 0, 0))));
+    CHECK(calls("SendMessage") == messages + 1);
+    CHECK(calls("SendPdu") == pdus);
+    CHECK(!strcmp(lastCall("SendMessage"), NUMBER " Hello world"));
+}
+
+/* Three UCS2 parts, with a surrogate pair across the first two */
+static void testConcat()
+{
+    static const unsigned char parts[3][8] = {
+        { 0x00, 'H', 0x00, 'i', 0x00, ' ', 0xd8, 0x3d },
+        { 0xde, 0x00, 0x04, 0x3c, 0x04, 0x38, 0x04, 0x40 },
+        { 0x00, '!' },
+    };
+    static const int lengths[3] = { 8, 8, 2 };
+    int messages = calls("SendMessage"), pdus = calls("SendPdu");
+    HarnessRequest *reqs[3];
+    Pdu pdu;
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        putHeader(&pdu, 0, NUMBER, 0x00, 0x08);
+        putUserData(&pdu, 1, parts[i], lengths[i], 0x11, 3, i + 1);
+        reqs[i] = sendSms(hex(&pdu));
+    }
+    for (i = 0; i < 3; i++)
+        CHECK(succeeded(reqs[i]));
+    CHECK(calls("SendMessage") == messages + 1);
+    CHECK(calls("SendPdu") == pdus);
+    CHECK(!strcmp(lastCall("SendMessage"), NUMBER " Hi \xf0\x9f\x98\x80\xd0\xbc\xd0\xb8\xd1\x80!"));
+}
+
+/* Two parts of three go to SendPdu once the rest is given up on */
+static void testMissingPart()
+{
+    int messages = calls("SendMessage"), pdus = calls("SendPdu");
+    uint64_t start = harnessNow();
+    HarnessRequest *first = sendSms(textPdu("first", 0x22, 3, 1));
+    HarnessRequest *third = sendSms(textPdu("third", 0x22, 3, 3));
+
+    usleep(CONCAT_TIMEOUT / 2 * 1000);
+    CHECK(!first->completed && !third->completed);
+    CHECK(calls("SendPdu") == pdus);
+
+    CHECK(succeeded(first));
+    CHECK(succeeded(third));
+    CHECK(harnessNow() - start >= CONCAT_TIMEOUT * 1000);
+    CHECK(calls("SendPdu") == pdus + 2);
+    CHECK(calls("SendMessage") == messages);
+    CHECK(!strcmp(lastCall("SendPdu"), textPdu("third", 0x22, 3, 3)));
+}
+
+/* A part sent again goes to SendPdu, the message still gets sent whole */
+static void testRepeatedPart()
+{
+    int messages = calls("SendMessage"), pdus = calls("SendPdu");
+    HarnessRequest *reqs[4];
+    int i;
+
+    reqs[0] = sendSms(textPdu("one ", 0x33, 3, 1));
+    reqs[1] = sendSms(textPdu("one ", 0x33, 3, 1));
+    reqs[2] = sendSms(textPdu("two ", 0x33, 3, 2));
+    reqs[3] = sendSms(textPdu("three", 0x33, 3, 3));
+    for (i = 0; i < 4; i++)
+        CHECK(succeeded(reqs[i]));
+    CHECK(calls("SendMessage") == messages + 1);
+    CHECK(calls("SendPdu") == pdus + 1);
+    CHECK(!strcmp(lastCall("SendMessage"), NUMBER " one two three"));
+}
+
+/* What SendMessage can't express reaches SendPdu unchanged */
+static void testPduOnly()
+{
+    static const struct {
+        const char      *name;
+        unsigned char   firstOctet;
+        const char      *address;
+        unsigned char   pid;
+        unsigned char   dcs;
+    } cases[] = {
+        { "flash",              0x00, NUMBER,   0x00, 0x10 },   // class 0
+        { "class 2",            0x00, NUMBER,   0x00, 0xf2 },
+        { "voicemail waiting",  0x00, NUMBER,   0x00, 0xc8 },
+        { "replace type 1",     0x00, NUMBER,   0x41, 0x00 },
+        { "validity period",    0x10, NUMBER,   0x00, 0x00 },
+        { "status report",      0x20, NUMBER,   0x00, 0x00 },
+        { "8-bit data",         0x00, NUMBER,   0x00, 0x04 },
+        { "alphanumeric",       0x00, "Info",   0x00, 0x00 },   // doesn't decode
+    };
+    unsigned i;
+
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        int messages = calls("SendMessage"), pdus = calls("SendPdu");
+        Pdu pdu;
+
+        putHeader(&pdu, cases[i].firstOctet, cases[i].address, cases[i].pid, cases[i].dcs);
+        putUserData(&pdu, 0x04 == cases[i].dcs, (const unsigned char *) "data", 4, 0, 0, 0);
+
+        const char *sent = hex(&pdu);
+        if (!succeeded(sendSms(sent)) || calls("SendPdu") != pdus + 1
+            || calls("SendMessage") != messages || strcmp(lastCall("SendPdu"), sent))
+        {
+            fprintf(stderr, "%s: not sent as a PDU\n", cases[i].name);
+            harnessFailures++;
+        }
+    }
+}
+
+/* ofono's errors to what the framework retries or gives up on */
+static void testErrors()
+{
+    static const struct {
+        const char  *error;
+        RIL_Errno   expected;
+    } cases[] = {
+        { "Failed",         RIL_E_SMS_SEND_FAIL_RETRY },
+        { "NotAvailable",   RIL_E_RADIO_NOT_AVAILABLE },
+        { "InvalidFormat",  RIL_E_GENERIC_FAILURE },
+    };
+    unsigned i;
+
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        HarnessRequest *req;
+
+        CHECK(!harnessOfono(NULL, 0, "fail MessageManager.SendMessage %s", cases[i].error));
+        CHECK(!harnessOfono(NULL, 0, "fail MessageManager.SendPdu %s", cases[i].error));
+
+        // every part of a message gets the error
+        HarnessRequest *first = sendSms(textPdu("first", 0x44 + i, 2, 1));
+        HarnessRequest *second = sendSms(textPdu("second", 0x44 + i, 2, 2));
+        CHECK(!harnessWait(first, TIMEOUT) && cases[i].expected == first->error);
+        CHECK(!harnessWait(second, TIMEOUT) && cases[i].expected == second->error);
+
+        req = sendSms(flashPdu("flash"));
+        CHECK(!harnessWait(req, TIMEOUT) && cases[i].expected == req->error);
+    }
+    CHECK(!harnessOfono(NULL, 0, "fail MessageManager.SendMessage off"));
+    CHECK(!harnessOfono(NULL, 0, "fail MessageManager.SendPdu off"));
+}
+
+int main(int argc, char **argv)
+{
+    if (harnessStart(0, NULL, NULL)) {
+        fprintf(stderr, "bring-up failed\n");
+        return 1;
+    }
+
+    testSingle();
+    testConcat();
+    testMissingPart();
+    testRepeatedPart();
+    testPduOnly();
+    testErrors();
+
+    CHECK(0 == harnessBadCompletions());
+
+    return harnessResult();
+}